@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <concurrentqueue.h>
 #include <functional>
 #include <memory>
@@ -57,7 +58,7 @@ public:
 
 		if (d_queue.try_dequeue(res) == false) {
 			res = d_constructor();
-			++d_created;
+			d_created.fetch_add(1, std::memory_order_relaxed);
 		}
 		return {
 		    res,
@@ -80,7 +81,10 @@ public:
 	};
 
 	Stats GetStats() const {
-		return {.Allocated = d_created, .Available = d_queue.size_approx()};
+		return {
+		    .Allocated = d_created.load(std::memory_order_relaxed),
+		    .Available = d_queue.size_approx(),
+		};
 	}
 
 protected:
@@ -94,7 +98,8 @@ private:
 	Constructor d_constructor;
 	Deleter     d_deleter;
 	Queue       d_queue;
-	size_t      d_created = 0;
+	// Get() may be called concurrently, like the queue.
+	std::atomic<size_t> d_created = 0;
 };
 
 } // namespace utils
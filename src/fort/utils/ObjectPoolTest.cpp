@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include "ObjectPool.hpp"
 
 namespace fort {
@@ -120,5 +124,31 @@ TEST_F(ObjectPoolTest, DeallocateAll) {
 	EXPECT_EQ(Count(), 0);
 }
 
+TEST_F(ObjectPoolTest, CountsConcurrentAllocations) {
+	struct A {};
+
+	std::atomic<size_t> built{0};
+
+	auto build = [&built]() {
+		++built;
+		return new A{};
+	};
+	auto pool = ObjectPool<A, decltype(build)>::Create(build);
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 8; ++i) {
+		threads.emplace_back([&pool]() {
+			for (int j = 0; j < 1000; ++j) {
+				auto res = pool->Get();
+			}
+		});
+	}
+	for (auto &t : threads) {
+		t.join();
+	}
+	EXPECT_EQ(pool->GetStats().Allocated, built.load());
+	EXPECT_EQ(pool->GetStats().Available, built.load());
+}
+
 } // namespace utils
 } // namespace fort
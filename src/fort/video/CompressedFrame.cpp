@@ -0,0 +1,337 @@
+#include "CompressedFrame.hpp"
+#include "TypesIO.hpp"
+#include "details/AVCall.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cpptrace/cpptrace.hpp>
+#include <cstring>
+
+#include <lz4.h>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace fort {
+namespace video {
+
+namespace {
+// Planes of a frame without their padding.
+struct PlaneLayout {
+	int    RowBytes[4];
+	int    Rows[4];
+	size_t Offsets[4];
+	size_t Bytes = 0;
+};
+} // namespace
+
+static PlaneLayout layout(PixelFormat format, const Resolution &size) {
+	const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+	if (desc == nullptr ||
+	    (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM |
+	                    AV_PIX_FMT_FLAG_PAL)) != 0) {
+		throw cpptrace::invalid_argument{
+		    "compression is not supported for " + std::to_string(format),
+		};
+	}
+	PlaneLayout res;
+	details::AVCall(av_image_fill_linesizes, res.RowBytes, format, size.Width);
+	for (int i = 0; i < 4; ++i) {
+		const int shift = (i == 1 || i == 2) ? desc->log2_chroma_h : 0;
+		res.Rows[i]     = res.RowBytes[i] > 0 ? -((-size.Height) >> shift) : 0;
+		res.Offsets[i]  = res.Bytes;
+		res.Bytes += size_t(res.RowBytes[i]) * res.Rows[i];
+	}
+	return res;
+}
+
+// The delta loops work by fixed blocks, which compilers vectorize even
+// when they do not vectorize loops of unknown length (GCC at -O2).
+constexpr static size_t BLOCK = 32;
+
+static void subtract(
+    uint8_t *__restrict dst,
+    const uint8_t *__restrict input,
+    uint8_t *__restrict previous,
+    size_t size
+) {
+	size_t i = 0;
+	for (; i + BLOCK <= size; i += BLOCK) {
+		for (size_t j = i; j < i + BLOCK; ++j) {
+			dst[j] = input[j] - previous[j];
+		}
+		std::memcpy(previous + i, input + i, BLOCK);
+	}
+	for (; i < size; ++i) {
+		dst[i]      = input[i] - previous[i];
+		previous[i] = input[i];
+	}
+}
+
+static void subtractInPlace(
+    uint8_t *__restrict values, uint8_t *__restrict previous, size_t size
+) {
+	size_t  i = 0;
+	uint8_t block[BLOCK];
+	for (; i + BLOCK <= size; i += BLOCK) {
+		std::memcpy(block, values + i, BLOCK);
+		for (size_t j = 0; j < BLOCK; ++j) {
+			values[i + j] = block[j] - previous[i + j];
+		}
+		std::memcpy(previous + i, block, BLOCK);
+	}
+	for (; i < size; ++i) {
+		const uint8_t value = values[i];
+		values[i]           = value - previous[i];
+		previous[i]         = value;
+	}
+}
+
+static void
+add(uint8_t *__restrict values, const uint8_t *__restrict previous, size_t size
+) {
+	size_t i = 0;
+	for (; i + BLOCK <= size; i += BLOCK) {
+		for (size_t j = i; j < i + BLOCK; ++j) {
+			values[j] += previous[j];
+		}
+	}
+	for (; i < size; ++i) {
+		values[i] += previous[i];
+	}
+}
+
+static uint64_t newStream() noexcept {
+	static std::atomic<uint64_t> last = 0;
+	return ++last;
+}
+
+struct FrameCompressor::Implementation {
+	Params   d_params;
+	uint64_t d_stream;
+	uint64_t d_sequence = 0;
+	// frames since the last key frame, 0 forces one.
+	size_t d_sinceKey = 0;
+
+	PixelFormat d_format = AV_PIX_FMT_NONE;
+	Resolution  d_size;
+
+	// packed planes of the previous frame, only kept for deltas.
+	std::vector<uint8_t> d_previous;
+	// packed planes of the current frame, or their delta.
+	std::vector<uint8_t> d_packed;
+	std::vector<char>    d_compressed;
+
+	Implementation(const Params &params)
+	    : d_params{params}
+	    , d_stream{newStream()} {
+		if (d_params.KeyPeriod == 0 || d_params.Acceleration <= 0) {
+			throw cpptrace::invalid_argument{
+			    "invalid compression parameters {KeyPeriod: " +
+			    std::to_string(d_params.KeyPeriod) + ", Acceleration: " +
+			    std::to_string(d_params.Acceleration) + "}",
+			};
+		}
+	}
+
+	CompressedFrame Compress(const Frame &frame) {
+		const auto planes = layout(frame.Format, frame.Size);
+		if (frame.Format != d_format || frame.Size != d_size) {
+			d_format   = frame.Format;
+			d_size     = frame.Size;
+			d_sinceKey = 0;
+		}
+		const bool deltas = d_params.KeyPeriod > 1;
+		const bool key    = d_sinceKey == 0;
+		d_sinceKey        = (d_sinceKey + 1) % d_params.KeyPeriod;
+
+		CompressedFrame res;
+		res.Format     = frame.Format;
+		res.Size       = frame.Size;
+		res.Index      = frame.Index;
+		res.PTS        = frame.PTS;
+		res.d_key      = key;
+		res.d_stream   = d_stream;
+		res.d_sequence = ++d_sequence;
+		res.d_rawBytes = planes.Bytes;
+
+		d_packed.resize(planes.Bytes);
+		if (deltas) {
+			d_previous.resize(planes.Bytes);
+		}
+		d_compressed.resize(LZ4_compressBound(planes.Bytes) + 4 * 16);
+
+		size_t compressed = 0;
+		for (int i = 0; i < 4 && planes.Rows[i] > 0; ++i) {
+			const size_t   offset = planes.Offsets[i];
+			const uint8_t *input  = pack(frame, planes, i);
+			if (deltas && key) {
+				std::memcpy(
+				    d_previous.data() + offset,
+				    input,
+				    size_t(planes.RowBytes[i]) * planes.Rows[i]
+				);
+			} else if (deltas) {
+				input = delta(input, planes, i);
+			}
+			res.d_planeBytes[i] = compress(input, planes, i, compressed);
+			compressed += res.d_planeBytes[i];
+		}
+		res.d_data.assign(
+		    d_compressed.begin(),
+		    d_compressed.begin() + compressed
+		);
+		return res;
+	}
+
+	// Returns plane i of frame without padding, contiguous planes are used
+	// in place.
+	const uint8_t *pack(const Frame &frame, const PlaneLayout &planes, int i) {
+		const int rowBytes = planes.RowBytes[i];
+		if (frame.Linesize[i] == rowBytes) {
+			return frame.Planes[i];
+		}
+		uint8_t *dst = d_packed.data() + planes.Offsets[i];
+		for (int y = 0; y < planes.Rows[i]; ++y) {
+			std::memcpy(
+			    dst + size_t(y) * rowBytes,
+			    frame.Planes[i] + size_t(y) * frame.Linesize[i],
+			    rowBytes
+			);
+		}
+		return dst;
+	}
+
+	// Replaces the previous plane i by input, and returns their difference.
+	// input may be the packed plane, which is overwritten.
+	const uint8_t *
+	delta(const uint8_t *input, const PlaneLayout &planes, int i) {
+		const size_t size     = size_t(planes.RowBytes[i]) * planes.Rows[i];
+		uint8_t     *dst      = d_packed.data() + planes.Offsets[i];
+		uint8_t     *previous = d_previous.data() + planes.Offsets[i];
+		if (input == dst) {
+			subtractInPlace(dst, previous, size);
+		} else {
+			subtract(dst, input, previous, size);
+		}
+		return dst;
+	}
+
+	uint32_t compress(
+	    const uint8_t *input, const PlaneLayout &planes, int i, size_t offset
+	) {
+		const int size     = planes.RowBytes[i] * planes.Rows[i];
+		const int capacity = int(d_compressed.size() - offset);
+		const int res      = LZ4_compress_fast(
+		    reinterpret_cast<const char *>(input),
+		    d_compressed.data() + offset,
+		    size,
+		    capacity,
+		    d_params.Acceleration
+		);
+		if (res <= 0) {
+			throw cpptrace::runtime_error{
+			    "could not compress plane " + std::to_string(i) + " of a " +
+			    std::to_string(d_format) + " " + std::to_string(d_size) +
+			    " frame",
+			};
+		}
+		return res;
+	}
+};
+
+FrameCompressor::FrameCompressor()
+    : FrameCompressor{Params{}} {}
+
+FrameCompressor::FrameCompressor(const Params &params)
+    : self{std::make_unique<Implementation>(params)} {}
+
+FrameCompressor::~FrameCompressor() = default;
+
+CompressedFrame FrameCompressor::Compress(const Frame &frame) {
+	return self->Compress(frame);
+}
+
+void FrameCompressor::Reset() noexcept {
+	self->d_sinceKey = 0;
+}
+
+struct FrameDecompressor::Implementation {
+	// last decompressed frame.
+	uint64_t d_stream = 0, d_sequence = 0;
+
+	// packed planes of the current frame, and of the previous one.
+	std::vector<uint8_t> d_packed, d_previous;
+
+	void Decompress(const CompressedFrame &frame, Frame &dst) {
+		if (dst.Format != frame.Format || dst.Size != frame.Size) {
+			throw cpptrace::invalid_argument{
+			    "invalid destination " + std::to_string(dst.Format) + " " +
+			    std::to_string(dst.Size) + " frame, expected " +
+			    std::to_string(frame.Format) + " " +
+			    std::to_string(frame.Size),
+			};
+		}
+		if (!frame.Key() && (frame.d_stream != d_stream ||
+		                     frame.d_sequence != d_sequence + 1)) {
+			throw cpptrace::invalid_argument{
+			    "frame " + std::to_string(frame.Index) +
+			    " is a delta to a frame that was not decompressed last",
+			};
+		}
+
+		const auto planes = layout(frame.Format, frame.Size);
+		d_packed.resize(planes.Bytes);
+		size_t compressed = 0;
+		for (int i = 0; i < 4 && planes.Rows[i] > 0; ++i) {
+			uint8_t   *packed   = d_packed.data() + planes.Offsets[i];
+			const int  rowBytes = planes.RowBytes[i];
+			const int  size     = rowBytes * planes.Rows[i];
+			const int  res      = LZ4_decompress_safe(
+			    reinterpret_cast<const char *>(frame.d_data.data()) +
+			        compressed,
+			    reinterpret_cast<char *>(packed),
+			    frame.d_planeBytes[i],
+			    size
+			);
+			if (res != size) {
+				throw cpptrace::runtime_error{
+				    "corrupted plane " + std::to_string(i) + " of frame " +
+				    std::to_string(frame.Index),
+				};
+			}
+			compressed += frame.d_planeBytes[i];
+
+			if (!frame.Key()) {
+				add(packed, d_previous.data() + planes.Offsets[i], size);
+			}
+			for (int y = 0; y < planes.Rows[i]; ++y) {
+				std::memcpy(
+				    dst.Planes[i] + size_t(y) * dst.Linesize[i],
+				    packed + size_t(y) * rowBytes,
+				    rowBytes
+				);
+			}
+		}
+		// d_packed is the next reference, the old one is recycled.
+		std::swap(d_packed, d_previous);
+		d_stream   = frame.d_stream;
+		d_sequence = frame.d_sequence;
+		dst.Index  = frame.Index;
+		dst.PTS    = frame.PTS;
+	}
+};
+
+FrameDecompressor::FrameDecompressor()
+    : self{std::make_unique<Implementation>()} {}
+
+FrameDecompressor::~FrameDecompressor() = default;
+
+void FrameDecompressor::Decompress(const CompressedFrame &frame, Frame &dst) {
+	self->Decompress(frame, dst);
+}
+
+} // namespace video
+} // namespace fort
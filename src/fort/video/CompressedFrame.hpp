@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Frame.hpp"
+#include "Types.hpp"
+
+namespace fort {
+namespace video {
+
+// CompressedFrame holds a frame losslessly compressed in memory, each plane
+// separately with LZ4, so buffers of raw frames hold several times more of
+// them. They are produced by a FrameCompressor, and restored by a
+// FrameDecompressor.
+class CompressedFrame {
+public:
+	PixelFormat Format = AV_PIX_FMT_NONE;
+	Resolution  Size;
+	size_t      Index = 0;
+	Duration    PTS   = Duration{0};
+
+	// Returns true if the frame decompresses on its own. Other frames are
+	// stored as their difference with the previous one.
+	bool Key() const noexcept {
+		return d_key;
+	}
+
+	// Size of the compressed planes, in bytes.
+	size_t Bytes() const noexcept {
+		return d_data.size();
+	}
+
+	// Size of the uncompressed planes without padding, in bytes.
+	size_t RawBytes() const noexcept {
+		return d_rawBytes;
+	}
+
+private:
+	friend class FrameCompressor;
+	friend class FrameDecompressor;
+
+	// compressed planes, back to back.
+	std::vector<uint8_t>    d_data;
+	std::array<uint32_t, 4> d_planeBytes = {0, 0, 0, 0};
+	size_t                  d_rawBytes   = 0;
+	// compressor and position in its output, as deltas require the
+	// previous frame.
+	uint64_t d_stream = 0, d_sequence = 0;
+	bool     d_key = true;
+};
+
+// FrameCompressor compresses frames in sequence. With a KeyPeriod larger
+// than one, frames between key frames only store their difference with
+// the previous frame, which is mostly zeros for a static scene and
+// compresses far better.
+//
+// A buffer holding these frames must drop them by whole key periods, as a
+// delta frame cannot be restored without all frames since its key frame.
+class FrameCompressor {
+public:
+	struct Params {
+		// One frame every KeyPeriod is a key frame, one makes them all key
+		// frames.
+		size_t KeyPeriod = 1;
+		// LZ4 acceleration, larger values are faster but compress less.
+		int Acceleration = 1;
+	};
+
+	FrameCompressor();
+	FrameCompressor(const Params &params);
+	~FrameCompressor();
+
+	// Throws cpptrace::invalid_argument for hardware, bitstream or
+	// palette formats. A change of size or format starts a new key frame.
+	CompressedFrame Compress(const Frame &frame);
+
+	// Makes the next frame a key frame.
+	void Reset() noexcept;
+
+private:
+	struct Implementation;
+
+	std::unique_ptr<Implementation> self;
+};
+
+// FrameDecompressor restores frames from a FrameCompressor.
+class FrameDecompressor {
+public:
+	FrameDecompressor();
+	~FrameDecompressor();
+
+	// Decompresses frame into dst, which must have the same size and
+	// format. Delta frames must be decompressed in sequence, right after
+	// the previous frame, otherwise it throws cpptrace::invalid_argument.
+	void Decompress(const CompressedFrame &frame, Frame &dst);
+
+private:
+	struct Implementation;
+
+	std::unique_ptr<Implementation> self;
+};
+
+} // namespace video
+} // namespace fort
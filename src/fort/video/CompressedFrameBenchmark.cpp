@@ -0,0 +1,112 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include <fort/video/CompressedFrame.hpp>
+#include <fort/video/Frame.hpp>
+
+namespace fort {
+namespace video {
+
+// Draws a gradient with a square at x, plus noise in [0, noise].
+static void draw(Frame &frame, int x, int noise, std::mt19937 &rng) {
+	std::uniform_int_distribution<int> dist{0, noise};
+	for (int y = 0; y < frame.Size.Height; ++y) {
+		uint8_t *row = frame.Planes[0] + y * frame.Linesize[0];
+		for (int j = 0; j < frame.Size.Width; ++j) {
+			const bool square = j >= x && j < x + 64 && y < 64;
+			row[j]            = square ? 255 : (j + y) / 16 + dist(rng);
+		}
+	}
+}
+
+// Sequences of GRAY8 frames with a moving square, compressed with the
+// given key period and noise amplitude.
+static void setup(
+    benchmark::State        &state,
+    std::vector<Frame>      &frames,
+    FrameCompressor::Params &params
+) {
+	params.KeyPeriod = state.range(0);
+	const int        noise = state.range(1);
+	const Resolution size{int(state.range(2)), int(state.range(3))};
+	state.SetLabel(
+	    "key period: " + std::to_string(params.KeyPeriod) +
+	    ", noise: " + std::to_string(noise)
+	);
+	std::mt19937 rng{0};
+	for (int i = 0; i < 8; ++i) {
+		frames.emplace_back(size, AV_PIX_FMT_GRAY8);
+		draw(frames.back(), 8 * i, noise, rng);
+	}
+}
+
+static void
+setCounters(benchmark::State &state, size_t raw, size_t compressed) {
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(int64_t(state.iterations()) * raw);
+	state.counters["ratio"] = double(raw) / compressed;
+}
+
+static void BM_Compress(benchmark::State &state) {
+	std::vector<Frame>      frames;
+	FrameCompressor::Params params;
+	setup(state, frames, params);
+	FrameCompressor compressor{params};
+
+	size_t raw = 0, compressed = 0, i = 0;
+	for (auto _ : state) {
+		auto res = compressor.Compress(frames[i++ % frames.size()]);
+		raw += res.RawBytes();
+		compressed += res.Bytes();
+		benchmark::DoNotOptimize(res);
+	}
+	setCounters(
+	    state,
+	    raw / state.iterations(),
+	    compressed / state.iterations()
+	);
+}
+
+static void BM_Decompress(benchmark::State &state) {
+	std::vector<Frame>      frames;
+	FrameCompressor::Params params;
+	setup(state, frames, params);
+	FrameCompressor              compressor{params};
+	std::vector<CompressedFrame> compressed;
+	size_t                       bytes = 0;
+	// a whole number of key periods, so the sequence can loop.
+	for (size_t i = 0; i < 8 * params.KeyPeriod; ++i) {
+		compressed.push_back(compressor.Compress(frames[i % frames.size()]));
+		bytes += compressed.back().Bytes();
+	}
+
+	FrameDecompressor decompressor;
+	Frame             result{frames[0].Size, AV_PIX_FMT_GRAY8};
+	size_t            i = 0;
+	for (auto _ : state) {
+		decompressor.Decompress(compressed[i++ % compressed.size()], result);
+		benchmark::ClobberMemory();
+	}
+	setCounters(state, compressed[0].RawBytes(), bytes / compressed.size());
+}
+
+static void periodsAndNoise(benchmark::internal::Benchmark *b) {
+	for (int keyPeriod : {1, 8}) {
+		for (int noise : {0, 3}) {
+			b->Args({keyPeriod, noise, 1920, 1080});
+			b->Args({keyPeriod, noise, 3840, 2160});
+		}
+	}
+}
+
+BENCHMARK(BM_Compress)
+    ->Apply(periodsAndNoise)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_Decompress)
+    ->Apply(periodsAndNoise)
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace video
+} // namespace fort
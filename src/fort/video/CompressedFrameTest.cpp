@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include <cpptrace/cpptrace.hpp>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <fort/video/CompressedFrame.hpp>
+#include <fort/video/Frame.hpp>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace fort {
+namespace video {
+
+class CompressedFrameTest : public ::testing::TestWithParam<PixelFormat> {
+protected:
+	// Plane sizes in bytes, without padding.
+	static void PlaneSizes(const Frame &frame, int rowBytes[4], int rows[4]) {
+		const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame.Format);
+		av_image_fill_linesizes(rowBytes, frame.Format, frame.Size.Width);
+		for (int i = 0; i < 4; ++i) {
+			const int shift = (i == 1 || i == 2) ? desc->log2_chroma_h : 0;
+			rows[i] = rowBytes[i] > 0 ? -((-frame.Size.Height) >> shift) : 0;
+		}
+	}
+
+	// Draws a smooth gradient with a square at x, and some noise.
+	static void Draw(Frame &frame, int x, std::mt19937 &rng) {
+		std::uniform_int_distribution<int> noise{0, 3};
+		int                                rowBytes[4], rows[4];
+		PlaneSizes(frame, rowBytes, rows);
+		for (int i = 0; i < 4; ++i) {
+			for (int y = 0; y < rows[i]; ++y) {
+				uint8_t *row = frame.Planes[i] + y * frame.Linesize[i];
+				for (int j = 0; j < rowBytes[i]; ++j) {
+					const bool square = j >= x && j < x + 16 && y < 16;
+					row[j] = square ? 255 : (j + y) / 4 + noise(rng);
+				}
+			}
+		}
+	}
+
+	static void ExpectSame(const Frame &expected, const Frame &result) {
+		ASSERT_EQ(expected.Format, result.Format);
+		ASSERT_EQ(expected.Size, result.Size);
+		EXPECT_EQ(expected.Index, result.Index);
+		EXPECT_EQ(expected.PTS, result.PTS);
+		int rowBytes[4], rows[4];
+		PlaneSizes(expected, rowBytes, rows);
+		for (int i = 0; i < 4; ++i) {
+			for (int y = 0; y < rows[i]; ++y) {
+				ASSERT_EQ(
+				    0,
+				    memcmp(
+				        expected.Planes[i] + y * expected.Linesize[i],
+				        result.Planes[i] + y * result.Linesize[i],
+				        rowBytes[i]
+				    )
+				) << "plane: " << i << " row: " << y;
+			}
+		}
+	}
+};
+
+TEST_P(CompressedFrameTest, RoundTrips) {
+	std::mt19937 rng{42};
+	// padded frames, and a contiguous one which is compressed in place.
+	for (int alignment : {32, 1}) {
+		SCOPED_TRACE("alignment " + std::to_string(alignment));
+		Frame frame{101, 67, GetParam(), alignment};
+		Draw(frame, 10, rng);
+		frame.Index = 3;
+		frame.PTS   = std::chrono::milliseconds{120};
+
+		FrameCompressor   compressor;
+		FrameDecompressor decompressor;
+		auto              compressed = compressor.Compress(frame);
+		EXPECT_TRUE(compressed.Key());
+		EXPECT_LT(compressed.Bytes(), compressed.RawBytes());
+
+		Frame result{frame.Size, frame.Format};
+		decompressor.Decompress(compressed, result);
+		ExpectSame(frame, result);
+	}
+}
+
+TEST_P(CompressedFrameTest, RoundTripsDeltas) {
+	std::mt19937    rng{43};
+	FrameCompressor compressor{{.KeyPeriod = 4}};
+
+	std::vector<Frame>           frames;
+	std::vector<CompressedFrame> compressed;
+	for (int i = 0; i < 10; ++i) {
+		frames.emplace_back(96, 64, GetParam());
+		Draw(frames.back(), 4 * i, rng);
+		frames.back().Index = i;
+		compressed.push_back(compressor.Compress(frames.back()));
+		EXPECT_EQ(compressed.back().Key(), i % 4 == 0) << "frame " << i;
+	}
+
+	// decompression may start at any key frame.
+	for (int start : {0, 4}) {
+		SCOPED_TRACE("start " + std::to_string(start));
+		FrameDecompressor decompressor;
+		Frame             result{96, 64, GetParam()};
+		for (size_t i = start; i < frames.size(); ++i) {
+			decompressor.Decompress(compressed[i], result);
+			ExpectSame(frames[i], result);
+		}
+	}
+
+	FrameDecompressor decompressor;
+	Frame             result{96, 64, GetParam()};
+	EXPECT_THROW(
+	    decompressor.Decompress(compressed[1], result),
+	    cpptrace::invalid_argument
+	);
+	decompressor.Decompress(compressed[0], result);
+	EXPECT_THROW(
+	    decompressor.Decompress(compressed[2], result),
+	    cpptrace::invalid_argument
+	);
+}
+
+TEST_P(CompressedFrameTest, DeltasCompressStaticScenes) {
+	Frame        frame{128, 96, GetParam()};
+	std::mt19937 rng{44};
+	Draw(frame, 0, rng);
+
+	FrameCompressor keys, deltas{{.KeyPeriod = 8}};
+	keys.Compress(frame);
+	deltas.Compress(frame);
+	const auto key   = keys.Compress(frame);
+	const auto delta = deltas.Compress(frame);
+	EXPECT_TRUE(key.Key());
+	EXPECT_FALSE(delta.Key());
+	EXPECT_LT(delta.Bytes() * 10, key.Bytes());
+
+	deltas.Reset();
+	EXPECT_TRUE(deltas.Compress(frame).Key());
+}
+
+TEST_P(CompressedFrameTest, ChecksArguments) {
+	EXPECT_THROW(
+	    (FrameCompressor{{.KeyPeriod = 0}}),
+	    cpptrace::invalid_argument
+	);
+	EXPECT_THROW(
+	    (FrameCompressor{{.Acceleration = 0}}),
+	    cpptrace::invalid_argument
+	);
+
+	Frame             frame{16, 16, GetParam()};
+	FrameCompressor   compressor;
+	FrameDecompressor decompressor;
+	auto              compressed = compressor.Compress(frame);
+	Frame             wrongSize{16, 8, GetParam()};
+	EXPECT_THROW(
+	    decompressor.Decompress(compressed, wrongSize),
+	    cpptrace::invalid_argument
+	);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Formats,
+    CompressedFrameTest,
+    ::testing::Values(AV_PIX_FMT_GRAY8, AV_PIX_FMT_YUV420P, AV_PIX_FMT_RGB24),
+    [](const ::testing::TestParamInfo<PixelFormat> &info) {
+	    return std::string{av_get_pix_fmt_name(info.param)};
+    }
+);
+
+} // namespace video
+} // namespace fort
@@ -1,13 +1,24 @@
 #include <cpptrace/cpptrace.hpp>
 
+#include <fort/utils/Defer.hpp>
 #include <fort/utils/ObjectPool.hpp>
 #include <fort/video/Types.hpp>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <mutex>
 #include <stdexcept>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
+#include <libavutil/frame.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/mathematics.h>
 #include <libavutil/opt.h>
 #include <libswscale/swscale.h>
 }
@@ -16,6 +27,10 @@ extern "C" {
 #include "TypesIO.hpp"
 #include "details/AVCall.hpp"
 #include "details/AVTypes.hpp"
+#include "details/ColorConversion.hpp"
+#include "details/QualityMonitor.hpp"
+#include "details/Scale.hpp"
+#include "details/ScaleContextCache.hpp"
 #include <iostream>
 
 namespace fort {
@@ -32,76 +47,382 @@ struct Encoder::Implementation {
 	    PacketPool::Create(av_packet_alloc, [](AVPacket *pkt) {
 		    av_packet_free(&pkt);
 	    });
-	details::AVCodecContextPtr d_codec;
-	details::SwsContextPtr     d_scale;
+	details::AVCodecContextPtr             d_codec;
+	details::ScaleContextCache::ContextPtr d_scale;
+	details::RGB24ToYUV420PFunction        d_convert = nullptr;
+
+	Encoder::Params d_params;
+	const AVCodec  *d_enc = nullptr;
+
+	using clock = std::chrono::steady_clock;
+	// adaptation state, only accessed by the encoding thread.
+	size_t                            d_frames       = 0;
+	size_t                            d_windowFrames = 0;
+	clock::duration                   d_windowBusy{0};
+	std::deque<PacketPool::ObjectPtr> d_pending;
+	std::atomic<size_t>               d_backlog{0};
+
+	mutable std::mutex d_statsMutex;
+	Stats              d_stats;
+	// d_codec may be re-opened, this time base stays the same.
+	AVRational d_timeBase;
+	// send time of in-flight frames by pts, in send order.
+	std::deque<std::pair<int64_t, clock::time_point>> d_sent;
+	Duration                                          d_totalLatency{0};
+	// dts and size of the packets in the largest bit rate window.
+	std::deque<std::pair<int64_t, int>> d_sizes;
+
+	std::unique_ptr<details::QualityMonitor> d_quality;
+	// set when the codec reached its end of stream.
+	bool d_eof = false;
 
 	Implementation(Encoder::Params &&params)
-	    : d_expectedFormat{params.Format} {
+	    : d_expectedFormat{params.Format}
+	    , d_params{std::move(params)} {
 		using namespace fort::video::details;
 
-		auto enc = avcodec_find_encoder_by_name(params.Codec.c_str());
-		if (enc == nullptr) {
+		d_enc = avcodec_find_encoder_by_name(d_params.Codec.c_str());
+		if (d_enc == nullptr) {
 			throw cpptrace::runtime_error{
-			    "could not found codec '" + params.Codec + "'",
+			    "could not found codec '" + d_params.Codec + "'",
 			};
 		}
 
-		d_codec            = MakeAVCodecContext(enc);
-		d_codec->width     = params.Size.Width;
-		d_codec->height    = params.Size.Height;
-		d_codec->time_base = {params.Framerate.Den, params.Framerate.Num};
-		d_codec->pix_fmt   = AV_PIX_FMT_YUV420P;
-		d_codec->bit_rate  = params.BitRate;
-		d_codec->rc_buffer_size =
-		    std::max(2 * params.BitRate, params.MaxBitRate);
-		d_codec->rc_min_rate = params.MinBitRate;
-		d_codec->rc_max_rate = params.MaxBitRate;
+		const auto &levels = d_params.Adaptive.Levels;
+		if (levels.empty()) {
+			d_codec = open({d_params.Preset, d_params.Threads});
+		} else {
+			if (d_params.Adaptive.Initial >= levels.size() ||
+			    d_params.Adaptive.Period == 0) {
+				throw cpptrace::invalid_argument{
+				    "invalid adaptation {initial: " +
+				    std::to_string(d_params.Adaptive.Initial) +
+				    ", levels: " + std::to_string(levels.size()) +
+				    ", period: " + std::to_string(d_params.Adaptive.Period) +
+				    "}",
+				};
+			}
+			d_stats.Level = d_params.Adaptive.Initial;
+			d_codec       = open(levels[d_stats.Level]);
+			checkReorderDelay();
+		}
 
-		AVCall(avcodec_open2, d_codec.get(), enc, nullptr);
+		d_timeBase      = d_codec->time_base;
+		d_frame->format = d_codec->pix_fmt;
+		d_frame->width  = d_codec->width;
+		d_frame->height = d_codec->height;
+
+		AVCall(av_frame_get_buffer, d_frame.get(), 0);
+
+		// packed RGB input does not need any scaling, we use our own kernel
+		// which is much faster than swscale generic path.
+		if (useInternalConversion(d_params.Scale)) {
+			d_convert = FindRGB24ToYUV420P(d_params.Format);
+		}
 
+		if (d_params.QualityPeriod > 0) {
+			d_quality = std::make_unique<QualityMonitor>(
+			    d_codec.get(),
+			    d_params.QualityPeriod
+			);
+		}
+
+		if (d_params.Format != AV_PIX_FMT_YUV420P && d_convert == nullptr) {
+			const Resolution size{d_codec->width, d_codec->height};
+			d_scale = ScaleContextCache::Default().Get(
+			    size,
+			    d_params.Format,
+			    size,
+			    AV_PIX_FMT_YUV420P,
+			    ScaleFlags(d_params.Scale),
+			    ScaleThreads(size, size)
+			);
+		}
+	}
+
+	// Throws if a level reorders frames differently than the initial one.
+	// The decoding timestamps of the first packets of a re-opened codec
+	// would go back before the ones already written, and the muxed stream
+	// keeps the initial reorder delay.
+	void checkReorderDelay() {
+		const auto &levels = d_params.Adaptive.Levels;
+		for (size_t i = 0; i < levels.size(); ++i) {
+			if (i == d_stats.Level) {
+				continue;
+			}
+			const auto codec = open(levels[i]);
+			if (codec->has_b_frames == d_codec->has_b_frames) {
+				continue;
+			}
+			throw cpptrace::invalid_argument{
+			    "adaptation level " + std::to_string(i) + " {preset: '" +
+			    levels[i].Preset + "'} reorders " +
+			    std::to_string(codec->has_b_frames) +
+			    " frames, but initial level " + std::to_string(d_stats.Level) +
+			    " {preset: '" + levels[d_stats.Level].Preset + "'} reorders " +
+			    std::to_string(d_codec->has_b_frames),
+			};
+		}
+	}
+
+	// Returns true if our RGB kernel, which box filters chroma, is as good
+	// as the requested conversion.
+	static bool useInternalConversion(const ScaleOptions &options) noexcept {
+		switch (options.Algorithm) {
+		case ScaleAlgorithm::Point:
+		case ScaleAlgorithm::FastBilinear:
+		case ScaleAlgorithm::Bilinear:
+		case ScaleAlgorithm::Area:
+			return !options.AccurateRounding;
+		default:
+			return false;
+		}
+	}
+
+	details::AVCodecContextPtr open(const Level &level) {
+		using namespace fort::video::details;
+		const auto &params = d_params;
+
+		auto codec       = MakeAVCodecContext(d_enc);
+		codec->width     = params.Size.Width;
+		codec->height    = params.Size.Height;
+		codec->framerate = {params.Framerate.Num, params.Framerate.Den};
+		codec->time_base = {params.Framerate.Den, params.Framerate.Num};
+		if (params.TimeBase.Num > 0 && params.TimeBase.Den > 0) {
+			codec->time_base = {params.TimeBase.Num, params.TimeBase.Den};
+		}
+		codec->pix_fmt  = AV_PIX_FMT_YUV420P;
+		codec->bit_rate = params.BitRate;
+		codec->rc_buffer_size =
+		    std::max(2 * params.BitRate, params.MaxBitRate);
+		codec->rc_min_rate = params.MinBitRate;
+		codec->rc_max_rate = params.MaxBitRate;
+		if (level.Threads > 0) {
+			codec->thread_count = level.Threads;
+		}
+
+		// private options must be set before opening the codec to be taken
+		// into account.
+		if (level.Preset.empty() == false) {
+			AVCall(
+			    av_opt_set,
+			    codec->priv_data,
+			    "preset",
+			    level.Preset.c_str(),
+			    0
+			);
+		}
 		AVCall(
 		    av_opt_set,
-		    d_codec->priv_data,
+		    codec->priv_data,
 		    params.ParamID.c_str(),
 		    params.ParamKeyValues.c_str(),
 		    0
 		);
 
-		d_frame->format = d_codec->pix_fmt;
-		d_frame->width  = d_codec->width;
-		d_frame->height = d_codec->height;
+		AVCall(avcodec_open2, codec.get(), d_enc, nullptr);
+		return codec;
+	}
 
-		AVCall(av_frame_get_buffer, d_frame.get(), 0);
+	void ReportBacklog(size_t frames) noexcept {
+		d_backlog.store(frames, std::memory_order_relaxed);
+	}
 
-		if (params.Format != AV_PIX_FMT_YUV420P) {
-			d_scale = SwsContextPtr{sws_getContext(
-			    d_codec->width,
-			    d_codec->height,
-			    params.Format,
-			    d_codec->width,
-			    d_codec->height,
-			    AV_PIX_FMT_YUV420P,
-			    SWS_BILINEAR,
-			    nullptr,
-			    nullptr,
-			    nullptr
-			)};
+	Stats GetStats() const {
+		std::lock_guard<std::mutex> lock{d_statsMutex};
+		auto                        res = d_stats;
+		res.InFlight                    = d_sent.size();
+		if (d_quality) {
+			const auto quality = d_quality->GetStats();
+			res.QualitySamples = quality.Samples;
+			res.MeanPSNR       = quality.MeanPSNR;
+			res.MinPSNR        = quality.MinPSNR;
+			res.MeanSSIM       = quality.MeanSSIM;
+			res.MinSSIM        = quality.MinSSIM;
+		}
+		if (d_stats.Packets > 0) {
+			res.MeanLatency = d_totalLatency / d_stats.Packets;
+		}
+		if (d_sizes.empty()) {
+			return res;
+		}
+		const int64_t last = d_sizes.back().first;
+		for (size_t i = 0; i < BitRateWindows.size(); ++i) {
+			const int64_t window = av_rescale_q(
+			    BitRateWindows[i].count(),
+			    {1, int(1e9)},
+			    d_timeBase
+			);
+			int64_t bytes = 0;
+			for (auto it = d_sizes.rbegin();
+			     it != d_sizes.rend() && it->first > last - window;
+			     ++it) {
+				bytes += it->second;
+			}
+			res.BitRates[i] =
+			    av_rescale(8 * bytes, 1000000000, BitRateWindows[i].count());
+		}
+		return res;
+	}
+
+	void recordSend(int64_t pts, clock::time_point now) {
+		std::lock_guard<std::mutex> lock{d_statsMutex};
+		d_sent.emplace_back(pts, now);
+		d_stats.MaxInFlight = std::max(d_stats.MaxInFlight, d_sent.size());
+	}
+
+	void recordPacket(const AVPacket &pkt) {
+		const auto now = clock::now();
+
+		auto pictType = (pkt.flags & AV_PKT_FLAG_KEY) != 0
+		                    ? AV_PICTURE_TYPE_I
+		                    : AV_PICTURE_TYPE_P;
+		size_t         size = 0;
+		const uint8_t *quality =
+		    av_packet_get_side_data(&pkt, AV_PKT_DATA_QUALITY_STATS, &size);
+		if (quality != nullptr && size >= 5) {
+			// quality stats are a 32-bit quality followed by the picture type.
+			pictType = AVPictureType(quality[4]);
+		}
+
+		const int64_t window = av_rescale_q(
+		    BitRateWindows.back().count(),
+		    {1, int(1e9)},
+		    d_timeBase
+		);
+
+		std::lock_guard<std::mutex> lock{d_statsMutex};
+		++d_stats.Packets;
+		d_stats.Bytes += pkt.size;
+		switch (pictType) {
+		case AV_PICTURE_TYPE_I:
+			++d_stats.IFrames;
+			break;
+		case AV_PICTURE_TYPE_B:
+			++d_stats.BFrames;
+			break;
+		default:
+			++d_stats.PFrames;
 		}
+
+		d_sizes.emplace_back(pkt.dts, pkt.size);
+		while (d_sizes.front().first <= pkt.dts - window) {
+			d_sizes.pop_front();
+		}
+
+		// packets may come out of order, but only a few frames are in
+		// flight.
+		auto it = std::find_if(d_sent.begin(), d_sent.end(), [&](const auto &s) {
+			return s.first == pkt.pts;
+		});
+		if (it == d_sent.end()) {
+			return;
+		}
+		const auto latency =
+		    std::chrono::duration_cast<Duration>(now - it->second);
+		d_sent.erase(it);
+		d_totalLatency += latency;
+		d_stats.MaxLatency = std::max(d_stats.MaxLatency, latency);
+		const auto ms      = uint64_t(
+            std::chrono::duration_cast<std::chrono::milliseconds>(latency)
+                .count()
+        );
+		d_stats.Latency[std::min(
+		    size_t(std::bit_width(ms)),
+		    Stats::LatencyBuckets - 1
+		)]++;
+	}
+
+	// Evaluates the load over the last period, and switches the level if
+	// needed. Returns true if the codec was re-opened.
+	bool adapt() {
+		const auto &adaptive = d_params.Adaptive;
+		if (adaptive.Levels.empty() || d_windowFrames < adaptive.Period) {
+			return false;
+		}
+
+		const double framePeriod =
+		    double(d_params.Framerate.Den) / d_params.Framerate.Num;
+		const float load = std::chrono::duration<double>(d_windowBusy).count() /
+		                   (d_windowFrames * framePeriod);
+		const size_t backlog = d_backlog.load(std::memory_order_relaxed);
+		d_windowFrames       = 0;
+		d_windowBusy         = clock::duration{0};
+
+		const size_t from = d_stats.Level;
+		size_t       to   = from;
+		if (load > adaptive.HighLoad || backlog > adaptive.MaxBacklog) {
+			to = std::min(from + 1, adaptive.Levels.size() - 1);
+		} else if (load < adaptive.LowLoad && backlog == 0 && from > 0) {
+			to = from - 1;
+		}
+		if (to == from) {
+			return false;
+		}
+
+		// The previous codec is drained, its packets are returned by
+		// Receive() before the ones of the new codec.
+		details::AVCall(avcodec_send_frame, d_codec.get(), nullptr);
+		while (true) {
+			auto pkt = receive();
+			if (!pkt) {
+				break;
+			}
+			d_pending.push_back(std::move(pkt));
+		}
+		d_codec = open(adaptive.Levels[to]);
+
+		std::lock_guard<std::mutex> lock{d_statsMutex};
+		d_stats.Level = to;
+		d_stats.Switches.push_back({
+		    .Frame   = d_frames,
+		    .From    = from,
+		    .To      = to,
+		    .Load    = load,
+		    .Backlog = backlog,
+		});
+		return true;
 	}
 
 	PacketPool::ObjectPtr Receive() {
+		if (d_pending.empty() == false) {
+			auto pkt = std::move(d_pending.front());
+			d_pending.pop_front();
+			return pkt;
+		}
+		const auto start = clock::now();
+		auto       pkt   = receive();
+		d_windowBusy += clock::now() - start;
+		// the end of stream of a codec drained by adapt() is not the end of
+		// the stream.
+		if (!pkt && d_eof && d_quality) {
+			d_quality->Finish();
+		}
+		return pkt;
+	}
+
+	PacketPool::ObjectPtr receive() {
 		auto pkt   = d_pool->Get(av_packet_unref);
 		int  error = avcodec_receive_packet(d_codec.get(), pkt.get());
+		d_eof      = error == AVERROR_EOF;
 		if (error == AVERROR(EAGAIN) || error == AVERROR_EOF) {
 			return nullptr;
 		} else if (error < 0) {
 			throw details::AVError(error, avcodec_receive_frame);
 		}
-
+		recordPacket(*pkt);
+		if (d_quality) {
+			d_quality->Received(*pkt);
+		}
 		return pkt;
 	}
 
-	void Send(const Frame &f, int64_t pts) {
+	void Send(
+	    const Frame               &f,
+	    int64_t                    pts,
+	    bool                       keyFrame,
+	    const std::vector<Region> &regions
+	) {
 		if (f.Format != d_expectedFormat ||
 		    f.Size != Resolution{d_frame->width, d_frame->height}) {
 
@@ -113,18 +434,32 @@ struct Encoder::Implementation {
 			    std::to_string(Resolution{d_frame->width, d_frame->height})};
 		}
 
+		if (adapt()) {
+			keyFrame = true;
+		}
+		const auto start = clock::now();
+		defer {
+			d_windowBusy += clock::now() - start;
+		};
+
 		details::AVCall(av_frame_make_writable, d_frame.get());
-		if (d_scale) {
-			details::AVCall(
-			    sws_scale,
-			    d_scale.get(),
-			    f.Planes,
-			    f.Linesize,
-			    0,
-			    d_codec->height,
+		if (d_convert) {
+			d_convert(
+			    f.Planes[0],
+			    f.Linesize[0],
+			    d_frame->data,
+			    d_frame->linesize,
+			    d_codec->width,
+			    d_codec->height
+			);
+		} else if (d_scale) {
+			auto dst = Frame::View(
+			    f.Size,
+			    AV_PIX_FMT_YUV420P,
 			    d_frame->data,
 			    d_frame->linesize
 			);
+			details::Scale(d_scale.get(), f, dst);
 		} else {
 			av_image_copy(
 			    d_frame->data,
@@ -136,8 +471,64 @@ struct Encoder::Implementation {
 			    d_codec->height
 			);
 		}
-		d_frame->pts = pts;
+		d_frame->pts       = pts;
+		d_frame->pict_type = keyFrame ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+		if (d_quality) {
+			d_quality->Sent(*d_frame, d_frames);
+		}
+		setRegions(regions);
 		details::AVCall(avcodec_send_frame, d_codec.get(), d_frame.get());
+		recordSend(pts, start);
+		++d_frames;
+		++d_windowFrames;
+	}
+
+	void setRegions(const std::vector<Region> &regions) {
+		// d_frame is reused, previous regions must not leak to this frame.
+		av_frame_remove_side_data(
+		    d_frame.get(),
+		    AV_FRAME_DATA_REGIONS_OF_INTEREST
+		);
+		if (regions.empty()) {
+			return;
+		}
+
+		std::vector<AVRegionOfInterest> rois;
+		rois.reserve(regions.size());
+		for (const auto &r : regions) {
+			if (!(r.QualityOffset >= -1.0f && r.QualityOffset <= 1.0f)) {
+				throw std::invalid_argument{
+				    "invalid region quality offset " +
+				    std::to_string(r.QualityOffset) + ", expected [-1, 1]",
+				};
+			}
+			AVRegionOfInterest roi{
+			    .self_size = sizeof(AVRegionOfInterest),
+			    .top       = std::max(r.Y, 0),
+			    .bottom    = std::min(r.Y + r.Height, d_codec->height),
+			    .left      = std::max(r.X, 0),
+			    .right     = std::min(r.X + r.Width, d_codec->width),
+			    .qoffset   = {int(std::lround(r.QualityOffset * 1000)), 1000},
+			};
+			if (roi.top >= roi.bottom || roi.left >= roi.right) {
+				continue;
+			}
+			rois.push_back(roi);
+		}
+		if (rois.empty()) {
+			return;
+		}
+
+		const size_t size = rois.size() * sizeof(AVRegionOfInterest);
+		auto         sd   = av_frame_new_side_data(
+            d_frame.get(),
+            AV_FRAME_DATA_REGIONS_OF_INTEREST,
+            size
+        );
+		if (sd == nullptr) {
+			throw details::AVError(AVERROR(ENOMEM), av_frame_new_side_data);
+		}
+		std::memcpy(sd->data, rois.data(), size);
 	}
 
 	void Flush() {
@@ -150,8 +541,13 @@ Encoder::Encoder(Params &&params)
 
 Encoder::~Encoder() = default;
 
-void Encoder::Send(const Frame &frame, int64_t pts) {
-	self->Send(frame, pts);
+void Encoder::Send(
+    const Frame               &frame,
+    int64_t                    pts,
+    bool                       keyFrame,
+    const std::vector<Region> &regions
+) {
+	self->Send(frame, pts, keyFrame, regions);
 }
 
 AVCodecContext *Encoder::CodecContext() const {
@@ -166,5 +562,13 @@ void Encoder::Flush() {
 	self->Flush();
 }
 
+void Encoder::ReportBacklog(size_t frames) noexcept {
+	self->ReportBacklog(frames);
+}
+
+Encoder::Stats Encoder::GetStats() const {
+	return self->GetStats();
+}
+
 } // namespace video
 } // namespace fort
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <array>
+#include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "Frame.hpp"
 #include "Types.hpp"
@@ -11,30 +14,154 @@ namespace video {
 
 class Encoder {
 public:
+	// Encoder speed settings.
+	struct Level {
+		// Codec preset, e.g. "veryfast" for libx264. Empty uses the codec
+		// default.
+		std::string Preset;
+		// Number of codec threads, 0 lets the codec choose.
+		int Threads = 0;
+	};
+
+	// Load-adaptive switching between encoding levels. Every Period frames,
+	// the time spent encoding is compared to the frame period. If this load
+	// is above HighLoad, or if more than MaxBacklog frames are waiting to be
+	// encoded (see ReportBacklog()), the next faster level is used. If it is
+	// below LowLoad without backlog, the next slower one is used. The codec
+	// is re-opened on a switch, which forces a key frame.
+	//
+	// All levels must reorder frames the same way, e.g. libx264 "ultrafast"
+	// has no B-frames and cannot be mixed with other presets. Otherwise
+	// decoding timestamps would not stay monotonic across a switch, and the
+	// Encoder throws cpptrace::invalid_argument.
+	struct Adaptation {
+		// Levels from the best quality to the fastest. Empty disables the
+		// adaptation.
+		std::vector<Level> Levels;
+		// Index of the starting level.
+		size_t Initial    = 0;
+		size_t Period     = 60;
+		float  HighLoad   = 0.8f;
+		float  LowLoad    = 0.4f;
+		size_t MaxBacklog = 2;
+	};
+
+	struct LevelSwitch {
+		// Index of the first frame encoded with the new level.
+		size_t Frame;
+		size_t From, To;
+		// Load and backlog that triggered the switch.
+		float  Load;
+		size_t Backlog;
+	};
+
+	// Windows, in stream time, over which Stats::BitRates are computed.
+	constexpr static std::array<Duration, 3> BitRateWindows = {
+	    std::chrono::seconds(1),
+	    std::chrono::seconds(10),
+	    std::chrono::seconds(60),
+	};
+
+	struct Stats {
+		// Bucket i counts frames whose latency from Send() to the output of
+		// their packet is below 2^i ms, and at least 2^(i-1) ms for i > 0.
+		// The last bucket counts everything above.
+		constexpr static size_t LatencyBuckets = 12;
+
+		std::array<size_t, LatencyBuckets> Latency{};
+		Duration                           MeanLatency = Duration{0};
+		Duration                           MaxLatency  = Duration{0};
+
+		size_t Packets = 0;
+		size_t Bytes   = 0;
+		// Achieved bit rates over BitRateWindows, in bits per second.
+		std::array<int64_t, BitRateWindows.size()> BitRates{};
+
+		size_t IFrames = 0, PFrames = 0, BFrames = 0;
+
+		// Frames sent whose packet has not been output yet.
+		size_t InFlight    = 0;
+		size_t MaxInFlight = 0;
+
+		// Current level index, 0 if adaptation is disabled.
+		size_t                   Level = 0;
+		std::vector<LevelSwitch> Switches;
+
+		// Luma quality of the sampled frames, see Params::QualityPeriod.
+		size_t QualitySamples = 0;
+		double MeanPSNR = 0.0, MinPSNR = 0.0;
+		double MeanSSIM = 0.0, MinSSIM = 0.0;
+	};
+
 	struct Params {
 		Resolution  Size;
 		std::string Codec          = "libx264";
 		std::string ParamID        = "x264-params";
 		std::string ParamKeyValues = "keyint=60:min-keyint=60:scenecut=0";
 		Ratio<int>  Framerate;
-		PixelFormat Format = AV_PIX_FMT_YUV420P;
+		// Time base of the timestamps passed to Send(). Defaults to
+		// 1/Framerate, a finer one is needed for variable frame rate.
+		Ratio<int>  TimeBase = {0, 0};
+		PixelFormat Format   = AV_PIX_FMT_YUV420P;
+		// Number of codec threads, 0 lets the codec choose.
+		int Threads = 0;
+		// Conversion of other formats than YUV420P. Packed RGB input uses a
+		// faster internal conversion, averaging chroma on 2x2 blocks, unless
+		// AccurateRounding or an Algorithm sharper than Area is requested.
+		ScaleOptions Scale;
 
 		int64_t BitRate    = 2 * 1024 * 1024;
 		int64_t MinBitRate = 500 * 1024;
 		int64_t MaxBitRate = 3 * 1024 * 1024;
+
+		// Codec preset, e.g. "veryfast" for libx264. Empty uses the codec
+		// default.
+		std::string Preset;
+		// Overrides Preset and Threads when Levels is not empty.
+		Adaptation Adaptive;
+
+		// If not 0, one frame every QualityPeriod is decoded back on a side
+		// thread and compared to the input, see Stats::MeanPSNR. The results
+		// are complete once Receive() returned the last packet after Flush().
+		size_t QualityPeriod = 0;
+	};
+
+	// A rectangle of the frame encoded with a different quality.
+	struct Region {
+		int X, Y, Width, Height;
+		// Quantizer offset in [-1, 1]. Negative values increase the quality,
+		// positive ones decrease it. When regions overlap, the first one in
+		// the list applies.
+		float QualityOffset;
 	};
 
 	Encoder(Params &&params);
 
 	~Encoder();
 
-	void Send(const Frame &frame, int64_t pts);
+	// Sends a frame to the encoder. If keyFrame is true, the encoder is
+	// forced to produce a key frame for it. regions are passed as
+	// AV_FRAME_DATA_REGIONS_OF_INTEREST, and are clipped to the frame.
+	void Send(
+	    const Frame               &frame,
+	    int64_t                    pts,
+	    bool                       keyFrame = false,
+	    const std::vector<Region> &regions  = {}
+	);
 	void Flush();
 
 	std::unique_ptr<AVPacket, std::function<void(AVPacket *)>> Receive();
 
+	// Informs the adaptation of the number of frames waiting to be sent.
+	// Thread-safe.
+	void ReportBacklog(size_t frames) noexcept;
+
+	// Thread-safe.
+	Stats GetStats() const;
+
 private:
 	friend class Writer;
+	friend class SegmentedWriter;
 
 	AVCodecContext *CodecContext() const;
 
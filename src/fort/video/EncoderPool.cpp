@@ -0,0 +1,215 @@
+#include "EncoderPool.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cpptrace/cpptrace.hpp>
+
+namespace fort {
+namespace video {
+
+using clock = std::chrono::steady_clock;
+
+struct EncoderPool::StreamState {
+	struct Task {
+		std::function<void()> Fn;
+		clock::time_point     Submitted;
+	};
+
+	// all fields are protected by the pool mutex.
+	std::deque<Task>        d_tasks;
+	// true if the stream is in the ready queue, or a task is running.
+	bool                    d_scheduled = false;
+	std::exception_ptr      d_error;
+	std::condition_variable d_changed;
+
+	size_t   d_frames = 0;
+	Duration d_totalLatency{0}, d_maxLatency{0};
+};
+
+struct EncoderPool::Implementation {
+	using State = StreamState;
+
+	Params d_params;
+
+	std::mutex                          d_mutex;
+	std::condition_variable             d_ready;
+	std::deque<std::shared_ptr<State>>  d_readyQueue;
+	bool                                d_stop = false;
+	std::vector<std::thread>            d_workers;
+
+	Implementation(Params &&params)
+	    : d_params{std::move(params)} {
+		if (d_params.Workers == 0) {
+			d_params.Workers =
+			    std::max(1U, std::thread::hardware_concurrency());
+		}
+		if (d_params.QueueSize == 0) {
+			throw cpptrace::invalid_argument{"QueueSize must be positive"};
+		}
+		try {
+			for (size_t i = 0; i < d_params.Workers; ++i) {
+				d_workers.emplace_back([this]() { loop(); });
+			}
+		} catch (...) {
+			// the destructor will not be called, and joinable threads would
+			// terminate on destruction.
+			stop();
+			throw;
+		}
+	}
+
+	~Implementation() {
+		stop();
+	}
+
+	void stop() {
+		{
+			std::lock_guard<std::mutex> lock{d_mutex};
+			d_stop = true;
+		}
+		d_ready.notify_all();
+		for (auto &t : d_workers) {
+			t.join();
+		}
+	}
+
+	void loop() {
+		std::unique_lock<std::mutex> lock{d_mutex};
+		while (true) {
+			d_ready.wait(lock, [this]() {
+				return d_stop || d_readyQueue.empty() == false;
+			});
+			if (d_readyQueue.empty()) {
+				return;
+			}
+			auto stream = std::move(d_readyQueue.front());
+			d_readyQueue.pop_front();
+			auto task = std::move(stream->d_tasks.front().Fn);
+
+			lock.unlock();
+			std::exception_ptr error;
+			try {
+				task();
+			} catch (...) {
+				error = std::current_exception();
+			}
+			lock.lock();
+
+			const auto latency =
+			    clock::now() - stream->d_tasks.front().Submitted;
+			stream->d_tasks.pop_front();
+			++stream->d_frames;
+			stream->d_totalLatency += latency;
+			stream->d_maxLatency = std::max(
+			    stream->d_maxLatency,
+			    std::chrono::duration_cast<Duration>(latency)
+			);
+			if (error) {
+				stream->d_error = error;
+				stream->d_tasks.clear();
+			}
+
+			// Serving one task at a time and re-queuing at the back is what
+			// makes the scheduling fair between streams.
+			if (stream->d_tasks.empty()) {
+				stream->d_scheduled = false;
+			} else {
+				d_readyQueue.push_back(stream);
+				d_ready.notify_one();
+			}
+			stream->d_changed.notify_all();
+		}
+	}
+
+	void Submit(const std::shared_ptr<State> &stream, std::function<void()> &&fn) {
+		std::unique_lock<std::mutex> lock{d_mutex};
+		stream->d_changed.wait(lock, [&]() {
+			return stream->d_error ||
+			       stream->d_tasks.size() < d_params.QueueSize;
+		});
+		if (stream->d_error) {
+			std::rethrow_exception(stream->d_error);
+		}
+		stream->d_tasks.push_back({std::move(fn), clock::now()});
+		if (stream->d_scheduled == false) {
+			stream->d_scheduled = true;
+			d_readyQueue.push_back(stream);
+			d_ready.notify_one();
+		}
+	}
+
+	void Wait(const std::shared_ptr<State> &stream) {
+		std::unique_lock<std::mutex> lock{d_mutex};
+		stream->d_changed.wait(lock, [&]() {
+			return stream->d_scheduled == false;
+		});
+		if (stream->d_error) {
+			std::rethrow_exception(stream->d_error);
+		}
+	}
+
+	StreamStats Stats(const std::shared_ptr<State> &stream) {
+		std::lock_guard<std::mutex> lock{d_mutex};
+		StreamStats res{
+		    .Frames     = stream->d_frames,
+		    .Queued     = stream->d_tasks.size(),
+		    .MaxLatency = stream->d_maxLatency,
+		};
+		if (stream->d_frames > 0) {
+			res.MeanLatency = stream->d_totalLatency / stream->d_frames;
+		}
+		return res;
+	}
+};
+
+EncoderPool::EncoderPool()
+    : EncoderPool{Params{}} {}
+
+EncoderPool::EncoderPool(Params &&params)
+    : self{std::make_unique<Implementation>(std::move(params))} {}
+
+EncoderPool::~EncoderPool() = default;
+
+size_t EncoderPool::Workers() const noexcept {
+	return self->d_params.Workers;
+}
+
+int EncoderPool::EncoderThreads() const noexcept {
+	return self->d_params.EncoderThreads;
+}
+
+EncoderPool::Stream::Stream(std::shared_ptr<EncoderPool> pool)
+    : d_pool{std::move(pool)}
+    , d_state{std::make_shared<StreamState>()} {
+	if (!d_pool) {
+		throw cpptrace::invalid_argument{"pool cannot be null"};
+	}
+}
+
+EncoderPool::Stream::~Stream() {
+	try {
+		Wait();
+	} catch (...) {
+	}
+}
+
+void EncoderPool::Stream::Submit(std::function<void()> &&task) {
+	d_pool->self->Submit(d_state, std::move(task));
+}
+
+void EncoderPool::Stream::Wait() {
+	d_pool->self->Wait(d_state);
+}
+
+EncoderPool::StreamStats EncoderPool::Stream::Stats() const {
+	return d_pool->self->Stats(d_state);
+}
+
+} // namespace video
+} // namespace fort
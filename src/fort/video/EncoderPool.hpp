@@ -0,0 +1,82 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "Types.hpp"
+
+namespace fort {
+namespace video {
+
+// EncoderPool multiplexes the encoding of many streams over a fixed number
+// of worker threads, instead of letting each encoder spawn its own. Work for
+// a stream is always executed in submission order, one task at a time, and
+// streams with pending work are served in a round-robin fashion so a busy
+// stream cannot starve the others.
+//
+// It is used through Writer::Params::Pool.
+class EncoderPool {
+public:
+	struct Params {
+		// Number of worker threads, 0 uses the number of available cores.
+		size_t Workers = 0;
+		// Number of tasks a stream can have pending before Submit() blocks.
+		size_t QueueSize = 4;
+		// Number of codec threads for each pooled encoder.
+		int EncoderThreads = 1;
+	};
+
+	struct StreamStats {
+		// Number of completed tasks.
+		size_t Frames = 0;
+		// Number of submitted tasks not yet completed.
+		size_t Queued = 0;
+		// Time between the submission and the completion of tasks.
+		Duration MeanLatency = Duration{0};
+		Duration MaxLatency  = Duration{0};
+	};
+
+private:
+	struct StreamState;
+
+public:
+	// A serial queue of tasks executed by the pool.
+	class Stream {
+	public:
+		Stream(std::shared_ptr<EncoderPool> pool);
+		// Waits for all pending tasks.
+		~Stream();
+
+		Stream(const Stream &other)            = delete;
+		Stream &operator=(const Stream &other) = delete;
+
+		// Submits a task, blocking while the stream has Params::QueueSize
+		// pending tasks. Rethrows the error of a previously failed task,
+		// after which the stream does not accept any more work.
+		void Submit(std::function<void()> &&task);
+
+		// Waits until all pending tasks are completed, and rethrows the
+		// error of a failed task.
+		void Wait();
+
+		StreamStats Stats() const;
+
+	private:
+		std::shared_ptr<EncoderPool> d_pool;
+		std::shared_ptr<StreamState> d_state;
+	};
+
+	EncoderPool();
+	EncoderPool(Params &&params);
+	~EncoderPool();
+
+	size_t Workers() const noexcept;
+	int    EncoderThreads() const noexcept;
+
+private:
+	struct Implementation;
+	std::unique_ptr<Implementation> self;
+};
+
+} // namespace video
+} // namespace fort
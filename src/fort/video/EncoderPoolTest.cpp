@@ -0,0 +1,123 @@
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <fort/video/EncoderPool.hpp>
+#include <gtest/gtest.h>
+
+namespace fort {
+namespace video {
+
+TEST(EncoderPoolTest, DefaultsToAvailableCores) {
+	auto pool = std::make_shared<EncoderPool>();
+	EXPECT_GE(pool->Workers(), 1);
+	EXPECT_EQ(pool->EncoderThreads(), 1);
+}
+
+TEST(EncoderPoolTest, ExecutesStreamInOrder) {
+	auto pool = std::make_shared<EncoderPool>(EncoderPool::Params{
+	    .Workers = 4,
+	});
+
+	std::vector<std::vector<int>> results(8);
+	{
+		std::vector<std::unique_ptr<EncoderPool::Stream>> streams;
+		for (size_t i = 0; i < results.size(); ++i) {
+			streams.push_back(std::make_unique<EncoderPool::Stream>(pool));
+		}
+		for (int j = 0; j < 100; ++j) {
+			for (size_t i = 0; i < results.size(); ++i) {
+				streams[i]->Submit([&r = results[i], j]() { r.push_back(j); });
+			}
+		}
+		for (const auto &s : streams) {
+			s->Wait();
+			auto stats = s->Stats();
+			EXPECT_EQ(stats.Frames, 100);
+			EXPECT_EQ(stats.Queued, 0);
+			EXPECT_LE(stats.MeanLatency, stats.MaxLatency);
+		}
+	}
+	for (const auto &r : results) {
+		ASSERT_EQ(r.size(), 100);
+		for (int j = 0; j < 100; ++j) {
+			EXPECT_EQ(r[j], j);
+		}
+	}
+}
+
+TEST(EncoderPoolTest, SchedulesStreamsFairly) {
+	auto pool = std::make_shared<EncoderPool>(EncoderPool::Params{
+	    .Workers   = 1,
+	    .QueueSize = 8,
+	});
+	EncoderPool::Stream blocker{pool}, a{pool}, b{pool};
+
+	std::promise<void> gate;
+	blocker.Submit([f = gate.get_future().share()]() { f.wait(); });
+
+	std::mutex       mutex;
+	std::vector<int> order;
+	auto             record = [&](int v) {
+        return [&, v]() {
+            std::lock_guard<std::mutex> lock{mutex};
+            order.push_back(v);
+        };
+	};
+	// while the only worker is busy, a submits a burst before b.
+	for (int i = 0; i < 3; ++i) {
+		a.Submit(record(i));
+	}
+	b.Submit(record(10));
+	gate.set_value();
+	a.Wait();
+	b.Wait();
+
+	EXPECT_EQ(order, (std::vector<int>{0, 10, 1, 2}));
+}
+
+TEST(EncoderPoolTest, BlocksWhenStreamQueueIsFull) {
+	auto pool = std::make_shared<EncoderPool>(EncoderPool::Params{
+	    .Workers   = 1,
+	    .QueueSize = 2,
+	});
+	EncoderPool::Stream s{pool};
+
+	std::promise<void> gate;
+	auto               f = gate.get_future().share();
+	s.Submit([f]() { f.wait(); });
+	s.Submit([]() {});
+	EXPECT_EQ(s.Stats().Queued, 2);
+
+	std::atomic<bool> submitted{false};
+	auto              third = std::async(std::launch::async, [&]() {
+        s.Submit([]() {});
+        submitted = true;
+    });
+	EXPECT_EQ(
+	    third.wait_for(std::chrono::milliseconds(50)),
+	    std::future_status::timeout
+	);
+	EXPECT_FALSE(submitted);
+	gate.set_value();
+	third.get();
+	s.Wait();
+	EXPECT_EQ(s.Stats().Frames, 3);
+}
+
+TEST(EncoderPoolTest, ReportsTaskErrors) {
+	auto pool = std::make_shared<EncoderPool>(EncoderPool::Params{
+	    .Workers = 2,
+	});
+	EncoderPool::Stream s{pool}, other{pool};
+	s.Submit([]() { throw std::runtime_error{"boom"}; });
+	other.Submit([]() {});
+	EXPECT_THROW(s.Wait(), std::runtime_error);
+	EXPECT_THROW(s.Submit([]() {}), std::runtime_error);
+	EXPECT_NO_THROW(other.Wait());
+}
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,72 @@
+#include <cstring>
+#include <fort/video/Encoder.hpp>
+#include <fort/video/Frame.hpp>
+#include <gtest/gtest.h>
+#include <random>
+
+namespace fort {
+namespace video {
+
+TEST(EncoderTest, MonitorsSampledQuality) {
+	constexpr int WIDTH = 64, HEIGHT = 48, FRAMES = 50;
+	Encoder       encoder{{
+	    .Size{WIDTH, HEIGHT},
+	    .Framerate     = {24, 1},
+	    .Format        = AV_PIX_FMT_GRAY8,
+	    .QualityPeriod = 10,
+	}};
+
+	std::mt19937                       rng{42};
+	std::uniform_int_distribution<int> noise{0, 15};
+	Frame                              frame{WIDTH, HEIGHT, AV_PIX_FMT_GRAY8, 16};
+
+	size_t packets = 0;
+	auto   drain   = [&]() {
+		while (encoder.Receive()) {
+			++packets;
+		}
+	};
+
+	for (int i = 0; i < FRAMES; ++i) {
+		for (int y = 0; y < HEIGHT; ++y) {
+			for (int x = 0; x < WIDTH; ++x) {
+				frame.Planes[0][y * frame.Linesize[0] + x] =
+				    uint8_t(2 * x + y + i + noise(rng));
+			}
+		}
+		encoder.Send(frame, i);
+		drain();
+	}
+	encoder.Flush();
+	drain();
+
+	EXPECT_EQ(packets, FRAMES);
+	auto stats = encoder.GetStats();
+	EXPECT_EQ(stats.QualitySamples, FRAMES / 10);
+	EXPECT_GT(stats.MinPSNR, 20.0);
+	EXPECT_GE(stats.MeanPSNR, stats.MinPSNR);
+	EXPECT_LE(stats.MeanPSNR, 100.0);
+	EXPECT_GT(stats.MinSSIM, 0.5);
+	EXPECT_GE(stats.MeanSSIM, stats.MinSSIM);
+	EXPECT_LE(stats.MeanSSIM, 1.0);
+}
+
+TEST(EncoderTest, QualityIsNotMonitoredByDefault) {
+	Encoder encoder{{
+	    .Size{40, 30},
+	    .Framerate = {24, 1},
+	    .Format    = AV_PIX_FMT_GRAY8,
+	}};
+	Frame   frame{40, 30, AV_PIX_FMT_GRAY8, 16};
+	for (int i = 0; i < 10; ++i) {
+		std::memset(frame.Planes[0], 10 * i, 40 * 30);
+		encoder.Send(frame, i);
+	}
+	encoder.Flush();
+	while (encoder.Receive()) {
+	}
+	EXPECT_EQ(encoder.GetStats().QualitySamples, 0);
+}
+
+} // namespace video
+} // namespace fort
@@ -1,46 +1,150 @@
 #include "Frame.hpp"
+#include "TypesIO.hpp"
 #include "details/AVCall.hpp"
 
+#include <algorithm>
+#include <utility>
+
+#include <cpptrace/cpptrace.hpp>
+
 extern "C" {
 #include <libavutil/avutil.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 }
 
 namespace fort {
 namespace video {
 
 Frame::Frame(int width, int height, PixelFormat format, int alignement)
+    : Frame{Resolution{width, height}, format, alignement} {}
+
+Frame::Frame(const Resolution &size, PixelFormat format, int alignement)
     : Format{format}
-    , Size{width, height} {
+    , Size{size} {
 
 	details::AVCall(
 	    av_image_alloc,
 	    Planes,
 	    Linesize,
-	    width,
-	    height,
+	    size.Width,
+	    size.Height,
 	    format,
 	    alignement
 	);
+	d_buffer = Planes[0];
 }
 
-Frame::Frame(const Resolution &size, PixelFormat format, int alignement)
-    : Format{format}
-    , Size{size} {
+Frame::Frame(ViewTag, const Resolution &size, PixelFormat format)
+    : Planes{nullptr, nullptr, nullptr, nullptr}
+    , Linesize{0, 0, 0, 0}
+    , Format{format}
+    , Size{size} {}
 
+Frame Frame::View(
+    const Resolution &size,
+    PixelFormat       format,
+    uint8_t *const    planes[4],
+    const int         linesize[4]
+) {
+	Frame res{ViewTag{}, size, format};
+	std::copy(planes, planes + 4, res.Planes);
+	std::copy(linesize, linesize + 4, res.Linesize);
+	return res;
+}
+
+Frame Frame::View(
+    const Resolution &size, PixelFormat format, uint8_t *buffer, int alignement
+) {
+	Frame res{ViewTag{}, size, format};
 	details::AVCall(
-	    av_image_alloc,
-	    Planes,
-	    Linesize,
+	    av_image_fill_arrays,
+	    res.Planes,
+	    res.Linesize,
+	    buffer,
+	    format,
 	    size.Width,
 	    size.Height,
-	    format,
 	    alignement
 	);
+	return res;
 }
 
 Frame::~Frame() {
-	av_freep(Planes);
+	av_freep(&d_buffer);
+}
+
+Frame::Frame(Frame &&other) noexcept
+    : Format{other.Format}
+    , Index{other.Index}
+    , PTS{other.PTS}
+    , Size{other.Size}
+    , d_buffer{std::exchange(other.d_buffer, nullptr)} {
+	std::copy(other.Planes, other.Planes + 4, Planes);
+	std::copy(other.Linesize, other.Linesize + 4, Linesize);
+	std::fill(other.Planes, other.Planes + 4, nullptr);
+	std::fill(other.Linesize, other.Linesize + 4, 0);
+}
+
+Frame &Frame::operator=(Frame &&other) noexcept {
+	if (this == &other) {
+		return *this;
+	}
+	av_freep(&d_buffer);
+	d_buffer = std::exchange(other.d_buffer, nullptr);
+	std::copy(other.Planes, other.Planes + 4, Planes);
+	std::copy(other.Linesize, other.Linesize + 4, Linesize);
+	std::fill(other.Planes, other.Planes + 4, nullptr);
+	std::fill(other.Linesize, other.Linesize + 4, 0);
+	Format = other.Format;
+	Index  = other.Index;
+	PTS    = other.PTS;
+	Size   = other.Size;
+	return *this;
+}
+
+Frame Frame::SubView(int x, int y, int width, int height) const {
+	const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(Format);
+	if (desc == nullptr ||
+	    (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM |
+	                    AV_PIX_FMT_FLAG_PAL)) != 0) {
+		throw cpptrace::invalid_argument{
+		    "sub-views are not supported for " + std::to_string(Format),
+		};
+	}
+	if (x < 0 || y < 0 || width <= 0 || height <= 0 ||
+	    x + width > Size.Width || y + height > Size.Height ||
+	    x % (1 << desc->log2_chroma_w) != 0 ||
+	    y % (1 << desc->log2_chroma_h) != 0) {
+		throw cpptrace::invalid_argument{
+		    "invalid sub-view {x: " + std::to_string(x) +
+		    ", y: " + std::to_string(y) + ", width: " + std::to_string(width) +
+		    ", height: " + std::to_string(height) + "} of a " +
+		    std::to_string(Format) + " " + std::to_string(Size) + " frame",
+		};
+	}
+
+	// the byte offset of x in each plane is the line size of a x wide
+	// image.
+	int offsets[4];
+	details::AVCall(av_image_fill_linesizes, offsets, Format, x);
+
+	Frame res{ViewTag{}, {width, height}, Format};
+	for (int i = 0; i < 4; ++i) {
+		if (Planes[i] == nullptr) {
+			continue;
+		}
+		const int row   = (i == 1 || i == 2) ? y >> desc->log2_chroma_h : y;
+		res.Planes[i]   = Planes[i] + ptrdiff_t(row) * Linesize[i] + offsets[i];
+		res.Linesize[i] = Linesize[i];
+	}
+	res.Index = Index;
+	res.PTS   = PTS;
+	return res;
+}
+
+bool Frame::Owning() const noexcept {
+	return d_buffer != nullptr;
 }
 
 } // namespace video
@@ -14,17 +14,55 @@ struct Frame {
 	    const Resolution &resolution, PixelFormat format, int alignement = 32
 	);
 
+	// Returns a frame which does not own its planes, but points to caller
+	// memory that must outlive it. It can be passed to any API taking a
+	// Frame, without copy.
+	static Frame View(
+	    const Resolution &size,
+	    PixelFormat       format,
+	    uint8_t *const    planes[4],
+	    const int         linesize[4]
+	);
+	// Returns a view over a single buffer with the layout given by
+	// av_image_fill_arrays() for alignement.
+	static Frame View(
+	    const Resolution &size,
+	    PixelFormat       format,
+	    uint8_t          *buffer,
+	    int               alignement = 1
+	);
+
 	~Frame();
 
 	Frame(const Frame &other)            = delete;
 	Frame &operator=(const Frame &other) = delete;
 
+	// The planes ownership is transferred, other is left without planes.
+	Frame(Frame &&other) noexcept;
+	Frame &operator=(Frame &&other) noexcept;
+
+	// Returns a view of the rectangle (x, y, width, height), sharing the
+	// planes of this frame. x and y must be multiples of the chroma
+	// subsampling of the format.
+	Frame SubView(int x, int y, int width, int height) const;
+
+	// Returns true if the frame owns its planes.
+	bool Owning() const noexcept;
+
 	uint8_t    *Planes[4];
 	int         Linesize[4];
 	PixelFormat Format;
-	size_t      Index;
-	Duration    PTS;
+	size_t      Index = 0;
+	Duration    PTS   = Duration{0};
 	Resolution  Size;
+
+private:
+	struct ViewTag {};
+
+	Frame(ViewTag, const Resolution &size, PixelFormat format);
+
+	// allocation holding all the planes, nullptr for views.
+	uint8_t *d_buffer = nullptr;
 };
 
 } // namespace video
@@ -0,0 +1,60 @@
+#include "FramePool.hpp"
+
+#include <algorithm>
+
+namespace fort {
+namespace video {
+
+FramePool::Ptr FramePool::Create() {
+	return Ptr{new FramePool()};
+}
+
+const FramePool::Ptr &FramePool::Default() {
+	static Ptr instance = Create();
+	return instance;
+}
+
+FramePool::FramePtr
+FramePool::Get(const Resolution &size, PixelFormat format, int alignement) {
+	const Key key{size.Width, size.Height, format, alignement};
+
+	std::lock_guard<std::mutex> lock{d_mutex};
+	auto                        it = d_pools.find(key);
+	if (it == d_pools.end()) {
+		auto pool = Pool::Create([size, format, alignement]() {
+			return new Frame{size, format, alignement};
+		});
+		it = d_pools.emplace(key, std::move(pool)).first;
+	}
+
+	auto frame = it->second->Get(
+	    [self = shared_from_this()](Frame *) { --self->d_inUse; }
+	);
+	d_highWaterMark = std::max(d_highWaterMark, ++d_inUse);
+	return frame;
+}
+
+FramePool::Stats FramePool::GetStats() const {
+	std::lock_guard<std::mutex> lock{d_mutex};
+	Stats                       res;
+	res.Allocated     = d_cleared;
+	res.InUse         = d_inUse.load();
+	res.HighWaterMark = d_highWaterMark;
+	for (const auto &[key, pool] : d_pools) {
+		const auto stats = pool->GetStats();
+		res.Allocated += stats.Allocated;
+		res.Available += stats.Available;
+	}
+	return res;
+}
+
+void FramePool::Clear() {
+	std::lock_guard<std::mutex> lock{d_mutex};
+	for (const auto &[key, pool] : d_pools) {
+		d_cleared += pool->GetStats().Allocated;
+	}
+	d_pools.clear();
+}
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <compare>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <fort/utils/ObjectPool.hpp>
+
+#include "Frame.hpp"
+#include "Types.hpp"
+
+namespace fort {
+namespace video {
+
+// FramePool recycles Frame buffers of any geometry. It keeps one
+// utils::ObjectPool per (size, format, alignement), and a frame returned by
+// Get() goes back to its pool when released, from any thread.
+class FramePool : public std::enable_shared_from_this<FramePool> {
+public:
+	using Ptr      = std::shared_ptr<FramePool>;
+	using FramePtr = std::unique_ptr<Frame, std::function<void(Frame *)>>;
+
+	struct Stats {
+		// Frames allocated since creation, and waiting in the pool.
+		size_t Allocated = 0, Available = 0;
+		// Frames currently in use, and their maximum since creation.
+		size_t InUse = 0, HighWaterMark = 0;
+	};
+
+	static Ptr Create();
+
+	// Process-wide pool, used when no other is given.
+	static const Ptr &Default();
+
+	FramePool(const FramePool &other)            = delete;
+	FramePool &operator=(const FramePool &other) = delete;
+
+	// Returns a frame from the pool, or a newly allocated one. Its content,
+	// Index and PTS are the ones left by its previous user. Thread-safe.
+	FramePtr
+	Get(const Resolution &size, PixelFormat format, int alignement = 32);
+
+	// Thread-safe.
+	Stats GetStats() const;
+
+	// Frees all available frames. Frames in use are freed on release.
+	void Clear();
+
+private:
+	FramePool() = default;
+
+	struct Key {
+		int         Width, Height;
+		PixelFormat Format;
+		int         Alignement;
+
+		auto operator<=>(const Key &other) const = default;
+	};
+
+	using Pool = utils::ObjectPool<Frame, std::function<Frame *()>>;
+
+	mutable std::mutex       d_mutex;
+	std::map<Key, Pool::Ptr> d_pools;
+	// allocations of the pools dropped by Clear().
+	size_t              d_cleared       = 0;
+	size_t              d_highWaterMark = 0;
+	std::atomic<size_t> d_inUse{0};
+};
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,96 @@
+#include <fort/video/FramePool.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace fort {
+namespace video {
+
+TEST(FramePoolTest, RecyclesFramesByGeometry) {
+	auto pool = FramePool::Create();
+
+	uint8_t *planes = nullptr;
+	{
+		auto frame = pool->Get({40, 30}, AV_PIX_FMT_GRAY8);
+		EXPECT_EQ(frame->Size, (Resolution{40, 30}));
+		EXPECT_EQ(frame->Format, AV_PIX_FMT_GRAY8);
+		planes = frame->Planes[0];
+	}
+	{
+		auto same = pool->Get({40, 30}, AV_PIX_FMT_GRAY8);
+		EXPECT_EQ(same->Planes[0], planes);
+		// any difference in the key gives another frame.
+		auto size      = pool->Get({30, 40}, AV_PIX_FMT_GRAY8);
+		auto format    = pool->Get({40, 30}, AV_PIX_FMT_RGB24);
+		auto alignment = pool->Get({40, 30}, AV_PIX_FMT_GRAY8, 64);
+		EXPECT_EQ(size->Size, (Resolution{30, 40}));
+		EXPECT_EQ(format->Format, AV_PIX_FMT_RGB24);
+		EXPECT_EQ(alignment->Linesize[0] % 64, 0);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(alignment->Planes[0]) % 64, 0);
+		for (const auto &f : {&size, &format, &alignment}) {
+			EXPECT_NE((*f)->Planes[0], planes);
+		}
+	}
+
+	auto stats = pool->GetStats();
+	EXPECT_EQ(stats.Allocated, 4);
+	EXPECT_EQ(stats.Available, 4);
+	EXPECT_EQ(stats.InUse, 0);
+	EXPECT_EQ(stats.HighWaterMark, 4);
+}
+
+TEST(FramePoolTest, TracksHighWaterMark) {
+	auto pool = FramePool::Create();
+	{
+		std::vector<FramePool::FramePtr> frames;
+		for (int i = 0; i < 5; ++i) {
+			frames.push_back(pool->Get({16, 16}, AV_PIX_FMT_GRAY8));
+		}
+		EXPECT_EQ(pool->GetStats().InUse, 5);
+		frames.resize(2);
+		EXPECT_EQ(pool->GetStats().InUse, 2);
+		frames.push_back(pool->Get({16, 16}, AV_PIX_FMT_GRAY8));
+		auto stats = pool->GetStats();
+		EXPECT_EQ(stats.InUse, 3);
+		EXPECT_EQ(stats.Available, 2);
+		EXPECT_EQ(stats.Allocated, 5);
+		EXPECT_EQ(stats.HighWaterMark, 5);
+
+		pool->Clear();
+		stats = pool->GetStats();
+		EXPECT_EQ(stats.Allocated, 5);
+		EXPECT_EQ(stats.Available, 0);
+		EXPECT_EQ(stats.InUse, 3);
+	}
+	// frames of a cleared pool are freed on release, and a new pool is
+	// created.
+	EXPECT_EQ(pool->GetStats().Available, 0);
+	auto frame = pool->Get({16, 16}, AV_PIX_FMT_GRAY8);
+	EXPECT_EQ(pool->GetStats().Allocated, 6);
+}
+
+TEST(FramePoolTest, FramesCanBeReleasedFromOtherThreads) {
+	auto pool = FramePool::Create();
+	{
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; ++t) {
+			threads.emplace_back([pool]() {
+				for (int i = 0; i < 100; ++i) {
+					auto frame = pool->Get({8, 8}, AV_PIX_FMT_GRAY8);
+					std::thread{[f = std::move(frame)]() {}}.join();
+				}
+			});
+		}
+		for (auto &t : threads) {
+			t.join();
+		}
+	}
+	auto stats = pool->GetStats();
+	EXPECT_EQ(stats.InUse, 0);
+	EXPECT_LE(stats.HighWaterMark, 4);
+	EXPECT_LE(stats.Allocated, 4);
+	EXPECT_EQ(stats.Available, stats.Allocated);
+}
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,90 @@
+#include <cpptrace/cpptrace.hpp>
+#include <fort/video/Frame.hpp>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+
+namespace fort {
+namespace video {
+
+TEST(FrameTest, IsMovable) {
+	std::vector<Frame> frames;
+	for (int i = 0; i < 10; ++i) {
+		// reallocations move the frames.
+		frames.emplace_back(40, 30, AV_PIX_FMT_GRAY8);
+		frames.back().Index        = i;
+		frames.back().Planes[0][0] = i;
+	}
+	for (int i = 0; i < 10; ++i) {
+		EXPECT_TRUE(frames[i].Owning());
+		EXPECT_EQ(frames[i].Index, i);
+		EXPECT_EQ(frames[i].Planes[0][0], i);
+	}
+
+	Frame moved{std::move(frames[0])};
+	EXPECT_TRUE(moved.Owning());
+	EXPECT_FALSE(frames[0].Owning());
+	EXPECT_EQ(frames[0].Planes[0], nullptr);
+	EXPECT_EQ(moved.Planes[0][0], 0);
+
+	moved = std::move(frames[1]);
+	EXPECT_EQ(moved.Index, 1);
+	EXPECT_EQ(moved.Planes[0][0], 1);
+	EXPECT_EQ(frames[1].Planes[0], nullptr);
+}
+
+TEST(FrameTest, ViewsCallerMemory) {
+	std::vector<uint8_t> buffer(6 * 4 + 2 * 3 * 2);
+	std::iota(buffer.begin(), buffer.end(), 0);
+
+	auto view = Frame::View({6, 4}, AV_PIX_FMT_YUV420P, buffer.data());
+	EXPECT_FALSE(view.Owning());
+	EXPECT_EQ(view.Size, (Resolution{6, 4}));
+	EXPECT_EQ(view.Planes[0], buffer.data());
+	EXPECT_EQ(view.Linesize[0], 6);
+	EXPECT_EQ(view.Planes[1], buffer.data() + 24);
+	EXPECT_EQ(view.Linesize[1], 3);
+	EXPECT_EQ(view.Planes[2], buffer.data() + 30);
+
+	uint8_t *planes[4]   = {buffer.data(), nullptr, nullptr, nullptr};
+	int      linesize[4] = {8, 0, 0, 0};
+	auto     gray = Frame::View({5, 3}, AV_PIX_FMT_GRAY8, planes, linesize);
+	EXPECT_FALSE(gray.Owning());
+	EXPECT_EQ(gray.Planes[0], buffer.data());
+	EXPECT_EQ(gray.Linesize[0], 8);
+	// the destructor of a view must not free the memory.
+	{ auto moved = std::move(gray); }
+	EXPECT_EQ(buffer[0], 0);
+}
+
+TEST(FrameTest, SubViews) {
+	Frame frame{40, 30, AV_PIX_FMT_YUV420P};
+	frame.Index = 3;
+	auto roi    = frame.SubView(10, 6, 20, 12);
+	EXPECT_FALSE(roi.Owning());
+	EXPECT_EQ(roi.Size, (Resolution{20, 12}));
+	EXPECT_EQ(roi.Index, 3);
+	EXPECT_EQ(roi.Planes[0], frame.Planes[0] + 6 * frame.Linesize[0] + 10);
+	EXPECT_EQ(roi.Planes[1], frame.Planes[1] + 3 * frame.Linesize[1] + 5);
+	EXPECT_EQ(roi.Planes[2], frame.Planes[2] + 3 * frame.Linesize[2] + 5);
+	for (int i = 0; i < 3; ++i) {
+		EXPECT_EQ(roi.Linesize[i], frame.Linesize[i]);
+	}
+
+	// sub-views of sub-views are relative to their parent.
+	auto nested = roi.SubView(2, 2, 4, 4);
+	EXPECT_EQ(nested.Planes[0], frame.Planes[0] + 8 * frame.Linesize[0] + 12);
+
+	Frame rgb{40, 30, AV_PIX_FMT_RGB24};
+	auto  rgbROI = rgb.SubView(3, 1, 5, 5);
+	EXPECT_EQ(rgbROI.Planes[0], rgb.Planes[0] + rgb.Linesize[0] + 9);
+
+	EXPECT_THROW(frame.SubView(1, 0, 4, 4), cpptrace::invalid_argument);
+	EXPECT_THROW(frame.SubView(0, 0, 41, 4), cpptrace::invalid_argument);
+	EXPECT_THROW(frame.SubView(-2, 0, 4, 4), cpptrace::invalid_argument);
+	EXPECT_THROW(frame.SubView(0, 0, 0, 4), cpptrace::invalid_argument);
+	EXPECT_NO_THROW(rgb.SubView(1, 1, 39, 29));
+}
+
+} // namespace video
+} // namespace fort
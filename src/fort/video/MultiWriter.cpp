@@ -0,0 +1,274 @@
+#include "MultiWriter.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include <cpptrace/cpptrace.hpp>
+
+#include "TypesIO.hpp"
+#include "details/AVCall.hpp"
+#include "details/AVTypes.hpp"
+#include "details/ColorConversion.hpp"
+#include "details/ScaleContextCache.hpp"
+
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+namespace fort {
+namespace video {
+
+struct MultiWriter::Implementation {
+	using ContextPtr = details::ScaleContextCache::ContextPtr;
+
+	struct Worker {
+		std::unique_ptr<Writer> d_writer;
+		// only set if the rendition size differs from the input.
+		ContextPtr              d_scale;
+		std::unique_ptr<Frame>  d_scaled;
+		std::thread             d_thread;
+		std::exception_ptr      d_error;
+	};
+
+	Resolution  d_size;
+	PixelFormat d_format;
+
+	ContextPtr                      d_convert;
+	details::RGB24ToYUV420PFunction d_convertRGB = nullptr;
+	std::unique_ptr<Frame>          d_converted;
+
+	std::vector<Worker> d_workers;
+
+	// hand-off of the shared frame to the workers.
+	std::mutex              d_mutex;
+	std::condition_variable d_wakeWorkers, d_wakeWriter;
+	const Frame            *d_current    = nullptr;
+	uint64_t                d_generation = 0;
+	size_t                  d_pending    = 0;
+	bool                    d_stop       = false;
+
+	Implementation(
+	    const Resolution        &size,
+	    PixelFormat              format,
+	    std::vector<Rendition> &&renditions
+	)
+	    : d_size{size}
+	    , d_format{format}
+	    , d_workers(renditions.size()) {
+
+		if (format != AV_PIX_FMT_YUV420P) {
+			d_converted = std::make_unique<Frame>(size, AV_PIX_FMT_YUV420P);
+			d_convertRGB = details::FindRGB24ToYUV420P(format);
+			if (d_convertRGB == nullptr) {
+				d_convert = newScale(size, format, size);
+			}
+		}
+
+		for (size_t i = 0; i < renditions.size(); ++i) {
+			auto &r      = renditions[i];
+			auto &w      = d_workers[i];
+			auto  target = r.Encoding.Size;
+
+			r.Encoding.Format = AV_PIX_FMT_YUV420P;
+			w.d_writer        = std::make_unique<Writer>(
+                std::move(r.Output),
+                std::move(r.Encoding)
+            );
+			if (target != size) {
+				w.d_scale = newScale(size, AV_PIX_FMT_YUV420P, target);
+				w.d_scaled =
+				    std::make_unique<Frame>(target, AV_PIX_FMT_YUV420P);
+			}
+		}
+
+		try {
+			for (auto &w : d_workers) {
+				w.d_thread = std::thread{[this, &w]() { loop(w); }};
+			}
+		} catch (...) {
+			// the destructor will not be called, and joinable threads would
+			// terminate on destruction.
+			stop();
+			throw;
+		}
+	}
+
+	~Implementation() {
+		stop();
+	}
+
+	void stop() {
+		{
+			std::lock_guard<std::mutex> lock{d_mutex};
+			d_stop = true;
+		}
+		d_wakeWorkers.notify_all();
+		for (auto &w : d_workers) {
+			if (w.d_thread.joinable()) {
+				w.d_thread.join();
+			}
+		}
+	}
+
+	void Close() {
+		stop();
+		// all renditions are closed, even if one of them fails.
+		std::exception_ptr error;
+		for (auto &w : d_workers) {
+			try {
+				w.d_writer->Close();
+			} catch (...) {
+				if (!error) {
+					error = std::current_exception();
+				}
+			}
+		}
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	static ContextPtr
+	newScale(const Resolution &from, PixelFormat format, const Resolution &to) {
+		return details::ScaleContextCache::Default()
+		    .Get(from, format, to, AV_PIX_FMT_YUV420P, SWS_BILINEAR);
+	}
+
+	void Write(const Frame &frame) {
+		if (d_stop) {
+			throw cpptrace::logic_error{"writer is closed"};
+		}
+		if (frame.Format != d_format || frame.Size != d_size) {
+			throw cpptrace::invalid_argument{
+			    "invalid input frame {format: " + std::to_string(frame.Format) +
+			    ", size: " + std::to_string(frame.Size) +
+			    "}, expected {format: " + std::to_string(d_format) +
+			    ", size: " + std::to_string(d_size) + "}",
+			};
+		}
+
+		const Frame *shared = &frame;
+		if (d_converted) {
+			convert(frame);
+			shared = d_converted.get();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock{d_mutex};
+			d_current = shared;
+			d_pending = d_workers.size();
+			++d_generation;
+		}
+		d_wakeWorkers.notify_all();
+
+		std::unique_lock<std::mutex> lock{d_mutex};
+		d_wakeWriter.wait(lock, [this]() { return d_pending == 0; });
+		d_current = nullptr;
+
+		for (auto &w : d_workers) {
+			if (w.d_error) {
+				std::rethrow_exception(std::exchange(w.d_error, nullptr));
+			}
+		}
+	}
+
+	void convert(const Frame &frame) {
+		if (d_convertRGB != nullptr) {
+			d_convertRGB(
+			    frame.Planes[0],
+			    frame.Linesize[0],
+			    d_converted->Planes,
+			    d_converted->Linesize,
+			    d_size.Width,
+			    d_size.Height
+			);
+		} else {
+			details::AVCall(
+			    sws_scale,
+			    d_convert.get(),
+			    frame.Planes,
+			    frame.Linesize,
+			    0,
+			    d_size.Height,
+			    d_converted->Planes,
+			    d_converted->Linesize
+			);
+		}
+		d_converted->PTS   = frame.PTS;
+		d_converted->Index = frame.Index;
+	}
+
+	void loop(Worker &w) {
+		uint64_t seen = 0;
+		while (true) {
+			const Frame *frame;
+			{
+				std::unique_lock<std::mutex> lock{d_mutex};
+				d_wakeWorkers.wait(lock, [&]() {
+					return d_stop || d_generation != seen;
+				});
+				if (d_stop) {
+					return;
+				}
+				seen  = d_generation;
+				frame = d_current;
+			}
+
+			try {
+				process(w, *frame);
+			} catch (...) {
+				w.d_error = std::current_exception();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock{d_mutex};
+				--d_pending;
+			}
+			d_wakeWriter.notify_one();
+		}
+	}
+
+	void process(Worker &w, const Frame &frame) {
+		if (!w.d_scale) {
+			w.d_writer->Write(frame);
+			return;
+		}
+		details::AVCall(
+		    sws_scale,
+		    w.d_scale.get(),
+		    frame.Planes,
+		    frame.Linesize,
+		    0,
+		    d_size.Height,
+		    w.d_scaled->Planes,
+		    w.d_scaled->Linesize
+		);
+		w.d_scaled->PTS   = frame.PTS;
+		w.d_scaled->Index = frame.Index;
+		w.d_writer->Write(*w.d_scaled);
+	}
+};
+
+MultiWriter::MultiWriter(
+    const Resolution        &inputSize,
+    PixelFormat              inputFormat,
+    std::vector<Rendition> &&renditions
+)
+    : self{std::make_unique<Implementation>(
+          inputSize, inputFormat, std::move(renditions)
+      )} {}
+
+MultiWriter::~MultiWriter() = default;
+
+void MultiWriter::Write(const Frame &frame) {
+	self->Write(frame);
+}
+
+void MultiWriter::Close() {
+	self->Close();
+}
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "Encoder.hpp"
+#include "Frame.hpp"
+#include "Types.hpp"
+#include "Writer.hpp"
+
+namespace fort {
+namespace video {
+
+// MultiWriter writes several renditions (e.g. a full resolution archive and
+// a downscaled preview) of the same input frames. The input is converted
+// once to YUV420P, then each rendition is scaled and encoded in its own
+// thread.
+class MultiWriter {
+public:
+	struct Rendition {
+		Writer::Params Output;
+		// Encoding parameters. Size is the rendition size, Format is ignored
+		// as encoders are fed with the shared YUV420P conversion.
+		Encoder::Params Encoding;
+	};
+
+	MultiWriter(
+	    const Resolution        &inputSize,
+	    PixelFormat              inputFormat,
+	    std::vector<Rendition> &&renditions
+	);
+	~MultiWriter();
+
+	// Writes frame in all renditions. Returns once all of them are done with
+	// it, and rethrows the first error raised by any of them.
+	void Write(const Frame &frame);
+
+	// Closes all renditions like Writer::Close(), and rethrows the first
+	// error raised by any of them.
+	void Close();
+
+private:
+	struct Implementation;
+	std::unique_ptr<Implementation> self;
+};
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,120 @@
+#include <cpptrace/cpptrace.hpp>
+#include <filesystem>
+#include <fort/video/Frame.hpp>
+#include <fort/video/MultiWriter.hpp>
+#include <fort/video/Reader.hpp>
+#include <fort/video/TypesIO.hpp>
+#include <gtest/gtest.h>
+#include <string>
+
+extern "C" {
+#include <libavutil/log.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace fort {
+namespace video {
+
+class MultiWriterTest : public ::testing::Test {
+protected:
+	static std::filesystem::path TempDir;
+
+	static void SetUpTestSuite() {
+		std::string tmpDirTemplate = std::filesystem::temp_directory_path() /
+		                             "fort-video-multi-writer-tests-XXXXXX";
+		TempDir = mkdtemp(const_cast<char *>(tmpDirTemplate.c_str()));
+		av_log_set_level(AV_LOG_QUIET);
+	}
+
+	static void TearDownTestSuite() {
+		std::filesystem::remove_all(TempDir);
+	}
+
+	static MultiWriter::Rendition
+	Rendition(const std::string &name, const Resolution &size) {
+		return {
+		    .Output   = {.Path = TempDir / name},
+		    .Encoding = {.Size = size, .Framerate = {24, 1}},
+		};
+	}
+
+	static void Encode(
+	    PixelFormat format, std::vector<MultiWriter::Rendition> &&renditions
+	) {
+		MultiWriter w{{80, 60}, format, std::move(renditions)};
+		Frame       frame{80, 60, format, 16};
+		for (size_t i = 0; i < 50; ++i) {
+			// a uniform grey image, so that scaling does not matter.
+			const uint8_t value = 16 + 4 * i;
+			if (format == AV_PIX_FMT_YUV420P) {
+				memset(frame.Planes[0], value, frame.Linesize[0] * 60);
+				memset(frame.Planes[1], 128, frame.Linesize[1] * 30);
+				memset(frame.Planes[2], 128, frame.Linesize[2] * 30);
+			} else {
+				memset(frame.Planes[0], value, frame.Linesize[0] * 60);
+			}
+			w.Write(frame);
+		}
+	}
+
+	static void
+	ExpectRendition(const std::string &name, const Resolution &size) {
+		SCOPED_TRACE(name);
+		Reader r{TempDir / name, AV_PIX_FMT_GRAY8};
+		EXPECT_EQ(r.Size(), size);
+		EXPECT_EQ(r.Length(), 50);
+		auto f = r.CreateFrame();
+		for (size_t i = 0; i < 50; ++i) {
+			SCOPED_TRACE("frame " + std::to_string(i));
+			ASSERT_TRUE(r.Read(*f));
+			EXPECT_NEAR(
+			    f->Planes[0][(size.Height / 2) * f->Linesize[0] + size.Width / 2],
+			    16 + 4 * i,
+			    3
+			);
+		}
+		EXPECT_FALSE(r.Read(*f));
+	}
+};
+
+std::filesystem::path MultiWriterTest::TempDir;
+
+TEST_F(MultiWriterTest, WritesAllRenditions) {
+	for (auto format : {AV_PIX_FMT_RGB24, AV_PIX_FMT_GRAY8, AV_PIX_FMT_YUV420P}) {
+		SCOPED_TRACE(std::to_string(format));
+		const auto prefix = std::string{av_get_pix_fmt_name(format)} + "-";
+		EXPECT_NO_THROW({
+			Encode(
+			    format,
+			    {
+			        Rendition(prefix + "full.mp4", {80, 60}),
+			        Rendition(prefix + "half.mp4", {40, 30}),
+			        Rendition(prefix + "quarter.mp4", {20, 16}),
+			    }
+			);
+		});
+		ExpectRendition(prefix + "full.mp4", {80, 60});
+		ExpectRendition(prefix + "half.mp4", {40, 30});
+		ExpectRendition(prefix + "quarter.mp4", {20, 16});
+	}
+}
+
+TEST_F(MultiWriterTest, ChecksInputFrames) {
+	MultiWriter w{
+	    {80, 60},
+	    AV_PIX_FMT_GRAY8,
+	    {Rendition("checks.mp4", {40, 30})}};
+
+	EXPECT_THROW(
+	    { w.Write(Frame{40, 30, AV_PIX_FMT_GRAY8}); },
+	    cpptrace::invalid_argument
+	);
+	EXPECT_THROW(
+	    { w.Write(Frame{80, 60, AV_PIX_FMT_RGB24}); },
+	    cpptrace::invalid_argument
+	);
+	EXPECT_NO_THROW({ w.Write(Frame{80, 60, AV_PIX_FMT_GRAY8}); });
+}
+
+} // namespace video
+} // namespace fort
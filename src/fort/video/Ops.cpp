@@ -0,0 +1,697 @@
+#include "Ops.hpp"
+#include "TypesIO.hpp"
+
+#include <algorithm>
+#include <cpptrace/cpptrace.hpp>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+#include "details/CPU.hpp"
+
+#ifdef FORT_VIDEO_HAS_X86
+#include <immintrin.h>
+#endif
+
+namespace fort {
+namespace video {
+namespace ops {
+
+namespace {
+
+// Row kernels, x is the first pixel to process, so vectorized versions can
+// hand their tail to the scalar one.
+using AbsDiffFunction = void (*)(
+    const uint8_t *a, const uint8_t *b, uint8_t *dst, int x, int width
+);
+using SumAbsDiffFunction =
+    uint64_t (*)(const uint8_t *a, const uint8_t *b, int x, int width);
+using ThresholdFunction = void (*)(
+    const uint8_t *src, uint8_t *dst, uint8_t threshold, int x, int width
+);
+// width is the dst width.
+using DownsampleFunction = void (*)(
+    const uint8_t *row0, const uint8_t *row1, uint8_t *dst, int x, int width
+);
+// dst[x] = rows[0][x] + 4 * rows[1][x] + 6 * rows[2][x] + 4 * rows[3][x] +
+// rows[4][x], the vertical pass of the Gaussian downsampling.
+using BinomialFunction =
+    void (*)(const uint8_t *const rows[5], uint16_t *dst, int x, int width);
+// dst[x] = (s[2x] + 4 * s[2x + 1] + 6 * s[2x + 2] + 4 * s[2x + 3] +
+// s[2x + 4] + 128) >> 8, the horizontal pass of the Gaussian downsampling.
+// It may read up to 8 values past s[2 * width + 3].
+using DecimateFunction =
+    void (*)(const uint16_t *s, uint8_t *dst, int x, int width);
+// sums[x] += add[x] - sub[x], the box blur vertical pass.
+using SlideFunction = void (*)(
+    uint16_t *sums, const uint8_t *add, const uint8_t *sub, int x, int width
+);
+
+void absDiffScalar(
+    const uint8_t *a, const uint8_t *b, uint8_t *dst, int x, int width
+) {
+	for (; x < width; ++x) {
+		dst[x] = a[x] > b[x] ? a[x] - b[x] : b[x] - a[x];
+	}
+}
+
+uint64_t
+sumAbsDiffScalar(const uint8_t *a, const uint8_t *b, int x, int width) {
+	uint64_t res = 0;
+	for (; x < width; ++x) {
+		res += a[x] > b[x] ? a[x] - b[x] : b[x] - a[x];
+	}
+	return res;
+}
+
+void thresholdScalar(
+    const uint8_t *src, uint8_t *dst, uint8_t threshold, int x, int width
+) {
+	for (; x < width; ++x) {
+		dst[x] = src[x] > threshold ? 255 : 0;
+	}
+}
+
+void downsampleScalar(
+    const uint8_t *row0, const uint8_t *row1, uint8_t *dst, int x, int width
+) {
+	for (; x < width; ++x) {
+		dst[x] = (row0[2 * x] + row0[2 * x + 1] + row1[2 * x] +
+		          row1[2 * x + 1] + 2) >>
+		         2;
+	}
+}
+
+void binomialScalar(
+    const uint8_t *const rows[5], uint16_t *dst, int x, int width
+) {
+	for (; x < width; ++x) {
+		dst[x] = rows[0][x] + rows[4][x] + 4 * (rows[1][x] + rows[3][x]) +
+		         6 * rows[2][x];
+	}
+}
+
+void decimateScalar(const uint16_t *s, uint8_t *dst, int x, int width) {
+	for (; x < width; ++x) {
+		const uint16_t *v = s + 2 * x;
+		dst[x] = (v[0] + v[4] + 4 * (v[1] + v[3]) + 6 * v[2] + 128) >> 8;
+	}
+}
+
+void slideScalar(
+    uint16_t *sums, const uint8_t *add, const uint8_t *sub, int x, int width
+) {
+	for (; x < width; ++x) {
+		sums[x] += add[x] - sub[x];
+	}
+}
+
+#ifdef FORT_VIDEO_HAS_X86
+
+FORT_VIDEO_TARGET("sse4.1")
+void absDiffSSE41(
+    const uint8_t *a, const uint8_t *b, uint8_t *dst, int x, int width
+) {
+	for (; x + 16 <= width; x += 16) {
+		const __m128i va = _mm_loadu_si128((const __m128i *)(a + x));
+		const __m128i vb = _mm_loadu_si128((const __m128i *)(b + x));
+		_mm_storeu_si128(
+		    (__m128i *)(dst + x),
+		    _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va))
+		);
+	}
+	absDiffScalar(a, b, dst, x, width);
+}
+
+FORT_VIDEO_TARGET("avx2")
+void absDiffAVX2(
+    const uint8_t *a, const uint8_t *b, uint8_t *dst, int x, int width
+) {
+	for (; x + 32 <= width; x += 32) {
+		const __m256i va = _mm256_loadu_si256((const __m256i *)(a + x));
+		const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + x));
+		_mm256_storeu_si256(
+		    (__m256i *)(dst + x),
+		    _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va))
+		);
+	}
+	absDiffSSE41(a, b, dst, x, width);
+}
+
+FORT_VIDEO_TARGET("sse4.1")
+uint64_t
+sumAbsDiffSSE41(const uint8_t *a, const uint8_t *b, int x, int width) {
+	__m128i acc = _mm_setzero_si128();
+	for (; x + 16 <= width; x += 16) {
+		acc = _mm_add_epi64(
+		    acc,
+		    _mm_sad_epu8(
+		        _mm_loadu_si128((const __m128i *)(a + x)),
+		        _mm_loadu_si128((const __m128i *)(b + x))
+		    )
+		);
+	}
+	return _mm_extract_epi64(acc, 0) + _mm_extract_epi64(acc, 1) +
+	       sumAbsDiffScalar(a, b, x, width);
+}
+
+FORT_VIDEO_TARGET("avx2")
+uint64_t
+sumAbsDiffAVX2(const uint8_t *a, const uint8_t *b, int x, int width) {
+	__m256i acc = _mm256_setzero_si256();
+	for (; x + 32 <= width; x += 32) {
+		acc = _mm256_add_epi64(
+		    acc,
+		    _mm256_sad_epu8(
+		        _mm256_loadu_si256((const __m256i *)(a + x)),
+		        _mm256_loadu_si256((const __m256i *)(b + x))
+		    )
+		);
+	}
+	const __m128i sum = _mm_add_epi64(
+	    _mm256_castsi256_si128(acc),
+	    _mm256_extracti128_si256(acc, 1)
+	);
+	return _mm_extract_epi64(sum, 0) + _mm_extract_epi64(sum, 1) +
+	       sumAbsDiffSSE41(a, b, x, width);
+}
+
+// There is no unsigned byte comparison, values are biased by 128 to compare
+// them as signed.
+FORT_VIDEO_TARGET("sse4.1")
+void thresholdSSE41(
+    const uint8_t *src, uint8_t *dst, uint8_t threshold, int x, int width
+) {
+	const __m128i bias = _mm_set1_epi8(char(0x80));
+	const __m128i t    = _mm_set1_epi8(char(threshold ^ 0x80));
+	for (; x + 16 <= width; x += 16) {
+		const __m128i v = _mm_loadu_si128((const __m128i *)(src + x));
+		_mm_storeu_si128(
+		    (__m128i *)(dst + x),
+		    _mm_cmpgt_epi8(_mm_xor_si128(v, bias), t)
+		);
+	}
+	thresholdScalar(src, dst, threshold, x, width);
+}
+
+FORT_VIDEO_TARGET("avx2")
+void thresholdAVX2(
+    const uint8_t *src, uint8_t *dst, uint8_t threshold, int x, int width
+) {
+	const __m256i bias = _mm256_set1_epi8(char(0x80));
+	const __m256i t    = _mm256_set1_epi8(char(threshold ^ 0x80));
+	for (; x + 32 <= width; x += 32) {
+		const __m256i v = _mm256_loadu_si256((const __m256i *)(src + x));
+		_mm256_storeu_si256(
+		    (__m256i *)(dst + x),
+		    _mm256_cmpgt_epi8(_mm256_xor_si256(v, bias), t)
+		);
+	}
+	thresholdSSE41(src, dst, threshold, x, width);
+}
+
+// Sums horizontal pairs of 16 pixels of two rows into 8 16-bit lanes.
+FORT_VIDEO_TARGET("sse4.1")
+inline __m128i sumBlocks(const uint8_t *row0, const uint8_t *row1) noexcept {
+	const __m128i ones = _mm_set1_epi8(1);
+	return _mm_add_epi16(
+	    _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)row0), ones),
+	    _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)row1), ones)
+	);
+}
+
+FORT_VIDEO_TARGET("sse4.1")
+void downsampleSSE41(
+    const uint8_t *row0, const uint8_t *row1, uint8_t *dst, int x, int width
+) {
+	const __m128i two = _mm_set1_epi16(2);
+	for (; x + 16 <= width; x += 16) {
+		const __m128i lo = _mm_srli_epi16(
+		    _mm_add_epi16(sumBlocks(row0 + 2 * x, row1 + 2 * x), two),
+		    2
+		);
+		const __m128i hi = _mm_srli_epi16(
+		    _mm_add_epi16(sumBlocks(row0 + 2 * x + 16, row1 + 2 * x + 16), two),
+		    2
+		);
+		_mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+	}
+	downsampleScalar(row0, row1, dst, x, width);
+}
+
+FORT_VIDEO_TARGET("avx2")
+inline __m256i sumBlocks256(const uint8_t *row0, const uint8_t *row1) noexcept {
+	const __m256i ones = _mm256_set1_epi8(1);
+	return _mm256_add_epi16(
+	    _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)row0), ones),
+	    _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)row1), ones)
+	);
+}
+
+FORT_VIDEO_TARGET("avx2")
+void downsampleAVX2(
+    const uint8_t *row0, const uint8_t *row1, uint8_t *dst, int x, int width
+) {
+	const __m256i two = _mm256_set1_epi16(2);
+	for (; x + 32 <= width; x += 32) {
+		const __m256i lo = _mm256_srli_epi16(
+		    _mm256_add_epi16(sumBlocks256(row0 + 2 * x, row1 + 2 * x), two),
+		    2
+		);
+		const __m256i hi = _mm256_srli_epi16(
+		    _mm256_add_epi16(
+		        sumBlocks256(row0 + 2 * x + 32, row1 + 2 * x + 32),
+		        two
+		    ),
+		    2
+		);
+		// packus works per 128-bit lane, the quadwords are interleaved.
+		_mm256_storeu_si256(
+		    (__m256i *)(dst + x),
+		    _mm256_permute4x64_epi64(
+		        _mm256_packus_epi16(lo, hi),
+		        _MM_SHUFFLE(3, 1, 2, 0)
+		    )
+		);
+	}
+	downsampleSSE41(row0, row1, dst, x, width);
+}
+
+FORT_VIDEO_TARGET("sse4.1")
+void binomialSSE41(
+    const uint8_t *const rows[5], uint16_t *dst, int x, int width
+) {
+	for (; x + 8 <= width; x += 8) {
+		__m128i v[5];
+		for (int i = 0; i < 5; ++i) {
+			v[i] = _mm_cvtepu8_epi16(
+			    _mm_loadl_epi64((const __m128i *)(rows[i] + x))
+			);
+		}
+		// 6c = 4c + 2c
+		const __m128i res = _mm_add_epi16(
+		    _mm_add_epi16(v[0], v[4]),
+		    _mm_add_epi16(
+		        _mm_slli_epi16(
+		            _mm_add_epi16(_mm_add_epi16(v[1], v[3]), v[2]),
+		            2
+		        ),
+		        _mm_slli_epi16(v[2], 1)
+		    )
+		);
+		_mm_storeu_si128((__m128i *)(dst + x), res);
+	}
+	binomialScalar(rows, dst, x, width);
+}
+
+FORT_VIDEO_TARGET("avx2")
+void binomialAVX2(
+    const uint8_t *const rows[5], uint16_t *dst, int x, int width
+) {
+	for (; x + 16 <= width; x += 16) {
+		__m256i v[5];
+		for (int i = 0; i < 5; ++i) {
+			v[i] = _mm256_cvtepu8_epi16(
+			    _mm_loadu_si128((const __m128i *)(rows[i] + x))
+			);
+		}
+		const __m256i res = _mm256_add_epi16(
+		    _mm256_add_epi16(v[0], v[4]),
+		    _mm256_add_epi16(
+		        _mm256_slli_epi16(
+		            _mm256_add_epi16(_mm256_add_epi16(v[1], v[3]), v[2]),
+		            2
+		        ),
+		        _mm256_slli_epi16(v[2], 1)
+		    )
+		);
+		_mm256_storeu_si256((__m256i *)(dst + x), res);
+	}
+	binomialSSE41(rows, dst, x, width);
+}
+
+// Filters 8 consecutive positions from s, only the even ones are kept by
+// the caller. The sum of the weights is 256, so no lane overflows.
+FORT_VIDEO_TARGET("sse4.1")
+inline __m128i decimate8(const uint16_t *s) noexcept {
+	const __m128i v0 = _mm_loadu_si128((const __m128i *)(s));
+	const __m128i v1 = _mm_loadu_si128((const __m128i *)(s + 1));
+	const __m128i v2 = _mm_loadu_si128((const __m128i *)(s + 2));
+	const __m128i v3 = _mm_loadu_si128((const __m128i *)(s + 3));
+	const __m128i v4 = _mm_loadu_si128((const __m128i *)(s + 4));
+	const __m128i sum = _mm_add_epi16(
+	    _mm_add_epi16(_mm_add_epi16(v0, v4), _mm_set1_epi16(128)),
+	    _mm_add_epi16(
+	        _mm_slli_epi16(_mm_add_epi16(_mm_add_epi16(v1, v3), v2), 2),
+	        _mm_slli_epi16(v2, 1)
+	    )
+	);
+	// keeps the even lanes as 32-bit values.
+	return _mm_and_si128(_mm_srli_epi16(sum, 8), _mm_set1_epi32(0xffff));
+}
+
+FORT_VIDEO_TARGET("sse4.1")
+void decimateSSE41(const uint16_t *s, uint8_t *dst, int x, int width) {
+	for (; x + 16 <= width; x += 16) {
+		const uint16_t *v  = s + 2 * x;
+		const __m128i   lo = _mm_packus_epi32(decimate8(v), decimate8(v + 8));
+		const __m128i   hi =
+		    _mm_packus_epi32(decimate8(v + 16), decimate8(v + 24));
+		_mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+	}
+	decimateScalar(s, dst, x, width);
+}
+
+FORT_VIDEO_TARGET("sse4.1")
+void slideSSE41(
+    uint16_t *sums, const uint8_t *add, const uint8_t *sub, int x, int width
+) {
+	for (; x + 8 <= width; x += 8) {
+		const __m128i a =
+		    _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(add + x)));
+		const __m128i s =
+		    _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(sub + x)));
+		const __m128i v = _mm_loadu_si128((const __m128i *)(sums + x));
+		_mm_storeu_si128(
+		    (__m128i *)(sums + x),
+		    _mm_sub_epi16(_mm_add_epi16(v, a), s)
+		);
+	}
+	slideScalar(sums, add, sub, x, width);
+}
+
+FORT_VIDEO_TARGET("avx2")
+void slideAVX2(
+    uint16_t *sums, const uint8_t *add, const uint8_t *sub, int x, int width
+) {
+	for (; x + 16 <= width; x += 16) {
+		const __m256i a = _mm256_cvtepu8_epi16(
+		    _mm_loadu_si128((const __m128i *)(add + x))
+		);
+		const __m256i s = _mm256_cvtepu8_epi16(
+		    _mm_loadu_si128((const __m128i *)(sub + x))
+		);
+		const __m256i v = _mm256_loadu_si256((const __m256i *)(sums + x));
+		_mm256_storeu_si256(
+		    (__m256i *)(sums + x),
+		    _mm256_sub_epi16(_mm256_add_epi16(v, a), s)
+		);
+	}
+	slideSSE41(sums, add, sub, x, width);
+}
+
+// the horizontal pass shuffles more than it computes, AVX2 lane crossing
+// would not pay off.
+FORT_VIDEO_TARGET("avx2")
+void decimateAVX2(const uint16_t *s, uint8_t *dst, int x, int width) {
+	decimateSSE41(s, dst, x, width);
+}
+
+#endif // FORT_VIDEO_HAS_X86
+
+template <typename Function>
+Function
+find(SIMDLevel level, Function scalar, Function sse41, Function avx2) {
+#ifdef FORT_VIDEO_HAS_X86
+	switch (std::min(level, BestSIMDLevel())) {
+	case SIMDLevel::AVX2:
+		return avx2;
+	case SIMDLevel::SSE41:
+		return sse41;
+	default:
+		break;
+	}
+#endif
+	return scalar;
+}
+
+#ifdef FORT_VIDEO_HAS_X86
+#define FORT_VIDEO_KERNELS(name) name##Scalar, name##SSE41, name##AVX2
+#else
+#define FORT_VIDEO_KERNELS(name) name##Scalar, name##Scalar, name##Scalar
+#endif
+
+void checkGray(const Frame &frame, const char *name) {
+	if (frame.Format != AV_PIX_FMT_GRAY8) {
+		throw cpptrace::invalid_argument{
+		    std::string{name} + " must be AV_PIX_FMT_GRAY8, got " +
+		    std::to_string(frame.Format),
+		};
+	}
+}
+
+void checkSize(const Frame &frame, const char *name, const Resolution &size) {
+	checkGray(frame, name);
+	if (frame.Size != size) {
+		throw cpptrace::invalid_argument{
+		    std::string{name} + " size must be " + std::to_string(size) +
+		    ", got " + std::to_string(frame.Size),
+		};
+	}
+}
+
+void checkHalf(const Frame &src, const Frame &dst, int first, int last) {
+	checkGray(src, "src");
+	checkSize(dst, "dst", {src.Size.Width / 2, src.Size.Height / 2});
+	if (first < 0 || last < first || last > dst.Size.Height) {
+		throw cpptrace::invalid_argument{
+		    "invalid rows [" + std::to_string(first) + ", " +
+		    std::to_string(last) + ") of a " + std::to_string(dst.Size) +
+		    " frame",
+		};
+	}
+}
+
+} // namespace
+
+void AbsDiff(const Frame &a, const Frame &b, Frame &dst, SIMDLevel level) {
+	checkGray(a, "a");
+	checkSize(b, "b", a.Size);
+	checkSize(dst, "dst", a.Size);
+	const auto kernel =
+	    find<AbsDiffFunction>(level, FORT_VIDEO_KERNELS(absDiff));
+	for (int y = 0; y < a.Size.Height; ++y) {
+		kernel(
+		    a.Planes[0] + y * a.Linesize[0],
+		    b.Planes[0] + y * b.Linesize[0],
+		    dst.Planes[0] + y * dst.Linesize[0],
+		    0,
+		    a.Size.Width
+		);
+	}
+}
+
+uint64_t SumAbsDiff(const Frame &a, const Frame &b, SIMDLevel level) {
+	checkGray(a, "a");
+	checkSize(b, "b", a.Size);
+	const auto kernel =
+	    find<SumAbsDiffFunction>(level, FORT_VIDEO_KERNELS(sumAbsDiff));
+	uint64_t res = 0;
+	for (int y = 0; y < a.Size.Height; ++y) {
+		res += kernel(
+		    a.Planes[0] + y * a.Linesize[0],
+		    b.Planes[0] + y * b.Linesize[0],
+		    0,
+		    a.Size.Width
+		);
+	}
+	return res;
+}
+
+void Threshold(
+    const Frame &src, Frame &dst, uint8_t threshold, SIMDLevel level
+) {
+	checkGray(src, "src");
+	checkSize(dst, "dst", src.Size);
+	const auto kernel =
+	    find<ThresholdFunction>(level, FORT_VIDEO_KERNELS(threshold));
+	for (int y = 0; y < src.Size.Height; ++y) {
+		kernel(
+		    src.Planes[0] + y * src.Linesize[0],
+		    dst.Planes[0] + y * dst.Linesize[0],
+		    threshold,
+		    0,
+		    src.Size.Width
+		);
+	}
+}
+
+void Downsample2x(const Frame &src, Frame &dst, SIMDLevel level) {
+	Downsample2x(src, dst, 0, src.Size.Height / 2, level);
+}
+
+void Downsample2x(
+    const Frame &src, Frame &dst, int first, int last, SIMDLevel level
+) {
+	checkHalf(src, dst, first, last);
+	const auto kernel =
+	    find<DownsampleFunction>(level, FORT_VIDEO_KERNELS(downsample));
+	for (int y = first; y < last; ++y) {
+		const uint8_t *row0 = src.Planes[0] + 2 * y * src.Linesize[0];
+		kernel(
+		    row0,
+		    row0 + src.Linesize[0],
+		    dst.Planes[0] + y * dst.Linesize[0],
+		    0,
+		    dst.Size.Width
+		);
+	}
+}
+
+void GaussianDownsample2x(const Frame &src, Frame &dst, SIMDLevel level) {
+	GaussianDownsample2x(src, dst, 0, src.Size.Height / 2, level);
+}
+
+void GaussianDownsample2x(
+    const Frame &src, Frame &dst, int first, int last, SIMDLevel level
+) {
+	checkHalf(src, dst, first, last);
+	const auto vertical =
+	    find<BinomialFunction>(level, FORT_VIDEO_KERNELS(binomial));
+	const auto horizontal =
+	    find<DecimateFunction>(level, FORT_VIDEO_KERNELS(decimate));
+
+	const int width = src.Size.Width, height = src.Size.Height;
+	// vertical sums of a row, padded by two replicated columns on each
+	// side, and by the horizontal pass overread.
+	std::vector<uint16_t> padded(width + 4 + 8);
+	uint16_t             *sums = padded.data() + 2;
+
+	for (int y = first; y < last; ++y) {
+		const uint8_t *rows[5];
+		for (int i = 0; i < 5; ++i) {
+			const int row = std::clamp(2 * y + i - 2, 0, height - 1);
+			rows[i]       = src.Planes[0] + row * src.Linesize[0];
+		}
+		vertical(rows, sums, 0, width);
+		padded[0] = padded[1] = sums[0];
+		padded[width + 2] = padded[width + 3] = sums[width - 1];
+
+		horizontal(
+		    padded.data(),
+		    dst.Planes[0] + y * dst.Linesize[0],
+		    0,
+		    dst.Size.Width
+		);
+	}
+}
+
+Histogram ComputeHistogram(const Frame &src) {
+	checkGray(src, "src");
+	// consecutive equal pixels are frequent, and would serialize on a single
+	// counter. Four interleaved counters keep them independent.
+	std::array<Histogram, 4> counts{};
+	const int                width = src.Size.Width;
+	for (int y = 0; y < src.Size.Height; ++y) {
+		const uint8_t *row = src.Planes[0] + y * src.Linesize[0];
+		int            x   = 0;
+		for (; x + 8 <= width; x += 8) {
+			uint64_t v;
+			std::memcpy(&v, row + x, sizeof(v));
+			++counts[0][v & 0xff];
+			++counts[1][(v >> 8) & 0xff];
+			++counts[2][(v >> 16) & 0xff];
+			++counts[3][(v >> 24) & 0xff];
+			++counts[0][(v >> 32) & 0xff];
+			++counts[1][(v >> 40) & 0xff];
+			++counts[2][(v >> 48) & 0xff];
+			++counts[3][v >> 56];
+		}
+		for (; x < width; ++x) {
+			++counts[0][row[x]];
+		}
+	}
+	Histogram res;
+	for (size_t i = 0; i < res.size(); ++i) {
+		res[i] = counts[0][i] + counts[1][i] + counts[2][i] + counts[3][i];
+	}
+	return res;
+}
+
+void BoxBlur(const Frame &src, Frame &dst, int radius, SIMDLevel level) {
+	checkGray(src, "src");
+	checkSize(dst, "dst", src.Size);
+	if (radius < 0 || radius > 127) {
+		// (2 * 127 + 1) * 255 is the largest column sum fitting 16 bits.
+		throw cpptrace::invalid_argument{
+		    "radius must be in [0, 127], got " + std::to_string(radius),
+		};
+	}
+	const auto slide = find<SlideFunction>(level, FORT_VIDEO_KERNELS(slide));
+
+	const int  width = src.Size.Width, height = src.Size.Height;
+	const auto row   = [&](int y) {
+		return src.Planes[0] + std::clamp(y, 0, height - 1) * src.Linesize[0];
+	};
+
+	// Column sums over the window of the current row, padded by radius
+	// replicated columns on each side. The vertical pass slides them down
+	// one row at a time, the horizontal one runs along them. The extra last
+	// column keeps the final horizontal step in bounds.
+	std::vector<uint16_t> padded(width + 2 * radius + 1, 0);
+	uint16_t             *sums = padded.data() + radius;
+	for (int y = -radius; y <= radius; ++y) {
+		const uint8_t *r = row(y);
+		for (int x = 0; x < width; ++x) {
+			sums[x] += r[x];
+		}
+	}
+
+	// rounded division by the window area through a 40-bit fixed-point
+	// reciprocal, exact for any sum below 2^24.
+	const uint64_t area       = (2 * radius + 1) * (2 * radius + 1);
+	const uint64_t reciprocal = ((uint64_t(1) << 40) + area - 1) / area;
+
+	for (int y = 0; y < height; ++y) {
+		std::fill(padded.begin(), padded.begin() + radius, sums[0]);
+		std::fill(
+		    padded.begin() + radius + width,
+		    padded.end(),
+		    sums[width - 1]
+		);
+
+		uint8_t *out = dst.Planes[0] + y * dst.Linesize[0];
+		uint32_t sum = 0;
+		for (int x = 0; x < 2 * radius + 1; ++x) {
+			sum += padded[x];
+		}
+		for (int x = 0; x < width; ++x) {
+			out[x] = ((sum + area / 2) * reciprocal) >> 40;
+			sum += padded[x + 2 * radius + 1];
+			sum -= padded[x];
+		}
+
+		slide(sums, row(y + radius + 1), row(y - radius), 0, width);
+	}
+}
+
+bool HasLumaPlane(PixelFormat format) noexcept {
+	const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+	if (desc == nullptr || desc->nb_components == 0 ||
+	    (desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL |
+	                    AV_PIX_FMT_FLAG_BITSTREAM | AV_PIX_FMT_FLAG_HWACCEL)
+	    ) != 0) {
+		return false;
+	}
+	const auto &luma = desc->comp[0];
+	return luma.plane == 0 && luma.step == 1 && luma.offset == 0 &&
+	       luma.shift == 0 && luma.depth == 8;
+}
+
+Frame LumaView(const Frame &frame) {
+	if (!HasLumaPlane(frame.Format)) {
+		throw cpptrace::invalid_argument{
+		    std::to_string(frame.Format) + " has no 8-bit luma plane",
+		};
+	}
+	uint8_t *planes[4]   = {frame.Planes[0], nullptr, nullptr, nullptr};
+	int      linesize[4] = {frame.Linesize[0], 0, 0, 0};
+	return Frame::View(frame.Size, AV_PIX_FMT_GRAY8, planes, linesize);
+}
+
+} // namespace ops
+} // namespace video
+} // namespace fort
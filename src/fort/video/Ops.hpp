@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "Frame.hpp"
+#include "SIMD.hpp"
+
+namespace fort {
+namespace video {
+namespace ops {
+
+// Image kernels on AV_PIX_FMT_GRAY8 frames. Kernels respect Frame::Linesize,
+// so they accept Frame::SubView(). They are dispatched at run time on the
+// best available SIMD level, a lower one can be requested, and all levels
+// return exactly the same result. They throw cpptrace::invalid_argument if
+// a frame is not GRAY8 or does not have the expected size.
+
+using Histogram = std::array<uint32_t, 256>;
+
+// dst = |a - b|. All frames have the same size. dst may be a or b.
+void AbsDiff(
+    const Frame &a,
+    const Frame &b,
+    Frame       &dst,
+    SIMDLevel    level = BestSIMDLevel()
+);
+
+// Returns the sum of |a - b| over all pixels. Both frames have the same
+// size.
+uint64_t SumAbsDiff(
+    const Frame &a, const Frame &b, SIMDLevel level = BestSIMDLevel()
+);
+
+// dst = src > threshold ? 255 : 0. dst may be src.
+void Threshold(
+    const Frame &src,
+    Frame       &dst,
+    uint8_t      threshold,
+    SIMDLevel    level = BestSIMDLevel()
+);
+
+// Halves src, each dst pixel is the rounded mean of a 2x2 block. dst size
+// must be src size / 2, odd last row or column are ignored.
+void Downsample2x(
+    const Frame &src, Frame &dst, SIMDLevel level = BestSIMDLevel()
+);
+
+// Same as above, but only computes dst rows [first, last), which read src
+// rows [2 * first, 2 * last). It allows to process a frame by bands, while
+// it is produced.
+void Downsample2x(
+    const Frame &src,
+    Frame       &dst,
+    int          first,
+    int          last,
+    SIMDLevel    level = BestSIMDLevel()
+);
+
+// Halves src after a 5x5 binomial (Gaussian) low-pass filter, with
+// replicated borders. It aliases less than Downsample2x(). dst size must
+// be src size / 2.
+void GaussianDownsample2x(
+    const Frame &src, Frame &dst, SIMDLevel level = BestSIMDLevel()
+);
+
+// Computes dst rows [first, last), which read src rows [2 * first - 2,
+// 2 * last + 1], clamped to the frame.
+void GaussianDownsample2x(
+    const Frame &src,
+    Frame       &dst,
+    int          first,
+    int          last,
+    SIMDLevel    level = BestSIMDLevel()
+);
+
+// Counts the pixel values of src. A histogram does not vectorize, it uses
+// interleaved counters instead.
+Histogram ComputeHistogram(const Frame &src);
+
+// dst pixels are the rounded mean of the (2 * radius + 1)^2 window around
+// them, borders are replicated. radius must be in [0, 127]. dst must not
+// overlap src.
+void BoxBlur(
+    const Frame &src,
+    Frame       &dst,
+    int          radius,
+    SIMDLevel    level = BestSIMDLevel()
+);
+
+// Returns true if the first plane of format is 8-bit luma (or gray), for
+// instance with GRAY8, planar YUV or NV12.
+bool HasLumaPlane(PixelFormat format) noexcept;
+
+// Returns a GRAY8 view of the luma plane of frame. Throws
+// cpptrace::invalid_argument if !HasLumaPlane(frame.Format).
+Frame LumaView(const Frame &frame);
+
+} // namespace ops
+} // namespace video
+} // namespace fort
@@ -0,0 +1,137 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include <fort/video/Frame.hpp>
+#include <fort/video/Ops.hpp>
+
+namespace fort {
+namespace video {
+namespace ops {
+
+static void fillRandom(Frame &frame, uint32_t seed) {
+	std::mt19937                       rng{seed};
+	std::uniform_int_distribution<int> dist{0, 255};
+	for (int y = 0; y < frame.Size.Height; ++y) {
+		for (int x = 0; x < frame.Linesize[0]; ++x) {
+			frame.Planes[0][y * frame.Linesize[0] + x] = dist(rng);
+		}
+	}
+}
+
+// Runs kernel(src, dst, level) on a random GRAY8 frame, throughput is
+// expressed in source pixels.
+template <typename Kernel>
+static void runKernel(
+    benchmark::State &state, const Resolution &dstSize, Kernel &&kernel
+) {
+	const auto       level = SIMDLevel(state.range(0));
+	const Resolution size{int(state.range(1)), int(state.range(2))};
+	if (level > BestSIMDLevel()) {
+		state.SkipWithError(("unsupported " + to_string(level)).c_str());
+		return;
+	}
+	state.SetLabel(to_string(level));
+
+	Frame src{size, AV_PIX_FMT_GRAY8};
+	Frame dst{
+	    dstSize.Width == 0 ? size : dstSize,
+	    AV_PIX_FMT_GRAY8,
+	};
+	fillRandom(src, 0);
+
+	for (auto _ : state) {
+		kernel(src, dst, level);
+		benchmark::DoNotOptimize(dst.Planes[0]);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(
+	    int64_t(state.iterations()) * size.Width * size.Height
+	);
+}
+
+static void BM_AbsDiff(benchmark::State &state) {
+	Frame other{int(state.range(1)), int(state.range(2)), AV_PIX_FMT_GRAY8};
+	fillRandom(other, 1);
+	runKernel(state, {}, [&](const Frame &src, Frame &dst, SIMDLevel level) {
+		AbsDiff(src, other, dst, level);
+	});
+}
+
+static void BM_SumAbsDiff(benchmark::State &state) {
+	Frame other{int(state.range(1)), int(state.range(2)), AV_PIX_FMT_GRAY8};
+	fillRandom(other, 1);
+	runKernel(state, {}, [&](const Frame &src, Frame &, SIMDLevel level) {
+		benchmark::DoNotOptimize(SumAbsDiff(src, other, level));
+	});
+}
+
+static void BM_Threshold(benchmark::State &state) {
+	runKernel(state, {}, [](const Frame &src, Frame &dst, SIMDLevel level) {
+		Threshold(src, dst, 127, level);
+	});
+}
+
+static void BM_Downsample2x(benchmark::State &state) {
+	runKernel(
+	    state,
+	    {int(state.range(1)) / 2, int(state.range(2)) / 2},
+	    [](const Frame &src, Frame &dst, SIMDLevel level) {
+		    Downsample2x(src, dst, level);
+	    }
+	);
+}
+
+static void BM_Histogram(benchmark::State &state) {
+	runKernel(state, {}, [](const Frame &src, Frame &, SIMDLevel) {
+		auto hist = ComputeHistogram(src);
+		benchmark::DoNotOptimize(hist);
+	});
+}
+
+static void BM_BoxBlur(benchmark::State &state) {
+	const int radius = state.range(3);
+	runKernel(state, {}, [=](const Frame &src, Frame &dst, SIMDLevel level) {
+		BoxBlur(src, dst, radius, level);
+	});
+}
+
+static void levelsAndSizes(benchmark::internal::Benchmark *b) {
+	for (auto level : {SIMDLevel::Scalar, SIMDLevel::SSE41, SIMDLevel::AVX2}) {
+		b->Args({int(level), 1920, 1080});
+		b->Args({int(level), 3840, 2160});
+	}
+}
+
+// for kernels without SIMD specializations.
+static void sizes(benchmark::internal::Benchmark *b) {
+	b->Args({int(SIMDLevel::Scalar), 1920, 1080});
+	b->Args({int(SIMDLevel::Scalar), 3840, 2160});
+}
+
+static void levelsSizesAndRadii(benchmark::internal::Benchmark *b) {
+	for (auto level : {SIMDLevel::Scalar, SIMDLevel::SSE41, SIMDLevel::AVX2}) {
+		for (int radius : {1, 8}) {
+			b->Args({int(level), 1920, 1080, radius});
+			b->Args({int(level), 3840, 2160, radius});
+		}
+	}
+}
+
+BENCHMARK(BM_AbsDiff)->Apply(levelsAndSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SumAbsDiff)
+    ->Apply(levelsAndSizes)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Threshold)->Apply(levelsAndSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Downsample2x)
+    ->Apply(levelsAndSizes)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Histogram)->Apply(sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BoxBlur)
+    ->Apply(levelsSizesAndRadii)
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace ops
+} // namespace video
+} // namespace fort
@@ -0,0 +1,313 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cpptrace/cpptrace.hpp>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <fort/video/Frame.hpp>
+#include <fort/video/Ops.hpp>
+
+namespace fort {
+namespace video {
+namespace ops {
+
+class OpsTest : public ::testing::TestWithParam<SIMDLevel> {
+protected:
+	void SetUp() override {
+		if (GetParam() > BestSIMDLevel()) {
+			GTEST_SKIP() << to_string(GetParam()) << " is not supported";
+		}
+	}
+
+	static void FillRandom(Frame &frame, std::mt19937 &rng) {
+		std::uniform_int_distribution<int> dist{0, 255};
+		for (int y = 0; y < frame.Size.Height; ++y) {
+			for (int x = 0; x < frame.Size.Width; ++x) {
+				At(frame, x, y) = dist(rng);
+			}
+		}
+	}
+
+	static uint8_t &At(Frame &frame, int x, int y) {
+		return frame.Planes[0][y * frame.Linesize[0] + x];
+	}
+
+	static uint8_t At(const Frame &frame, int x, int y) {
+		return frame.Planes[0][y * frame.Linesize[0] + x];
+	}
+
+	static void ExpectPixels(
+	    const Frame                            &frame,
+	    const std::function<uint8_t(int, int)> &expected
+	) {
+		for (int y = 0; y < frame.Size.Height; ++y) {
+			for (int x = 0; x < frame.Size.Width; ++x) {
+				ASSERT_EQ(int(At(frame, x, y)), int(expected(x, y)))
+				    << "at (" << x << ", " << y << ")";
+			}
+		}
+	}
+
+	// Odd sizes exercise the scalar tails, and views of a larger frame odd
+	// linesizes and unaligned rows.
+	static std::vector<Resolution> Sizes() {
+		return {{1, 1}, {7, 5}, {16, 2}, {33, 17}, {97, 31}, {1920, 8}};
+	}
+
+	static Frame View(Frame &parent, const Resolution &size) {
+		return parent.SubView(3, 1, size.Width, size.Height);
+	}
+};
+
+TEST_P(OpsTest, AbsDiff) {
+	std::mt19937 rng{42};
+	for (const auto &size : Sizes()) {
+		SCOPED_TRACE(std::to_string(size.Width) + "x" +
+		             std::to_string(size.Height));
+		Frame a{size, AV_PIX_FMT_GRAY8}, dst{size, AV_PIX_FMT_GRAY8};
+		Frame parent{size.Width + 5, size.Height + 1, AV_PIX_FMT_GRAY8, 1};
+		Frame b = View(parent, size);
+		FillRandom(a, rng);
+		FillRandom(b, rng);
+
+		AbsDiff(a, b, dst, GetParam());
+		ExpectPixels(dst, [&](int x, int y) {
+			return std::abs(int(At(a, x, y)) - int(At(b, x, y)));
+		});
+
+		AbsDiff(a, b, a, GetParam());
+		ExpectPixels(a, [&](int x, int y) { return At(dst, x, y); });
+	}
+}
+
+TEST_P(OpsTest, SumAbsDiff) {
+	std::mt19937 rng{47};
+	for (const auto &size : Sizes()) {
+		Frame a{size, AV_PIX_FMT_GRAY8};
+		Frame parent{size.Width + 5, size.Height + 1, AV_PIX_FMT_GRAY8, 1};
+		Frame b = View(parent, size);
+		FillRandom(a, rng);
+		FillRandom(b, rng);
+		uint64_t expected = 0;
+		for (int y = 0; y < size.Height; ++y) {
+			for (int x = 0; x < size.Width; ++x) {
+				expected += std::abs(int(At(a, x, y)) - int(At(b, x, y)));
+			}
+		}
+		EXPECT_EQ(SumAbsDiff(a, b, GetParam()), expected);
+		EXPECT_EQ(SumAbsDiff(a, a, GetParam()), 0);
+	}
+}
+
+TEST_P(OpsTest, Threshold) {
+	std::mt19937 rng{43};
+	for (const auto &size : Sizes()) {
+		Frame parent{size.Width + 5, size.Height + 1, AV_PIX_FMT_GRAY8, 1};
+		Frame src = View(parent, size), dst{size, AV_PIX_FMT_GRAY8};
+		FillRandom(src, rng);
+		for (int threshold : {0, 1, 127, 128, 200, 254, 255}) {
+			SCOPED_TRACE(std::to_string(size.Width) + "x" +
+			             std::to_string(size.Height) +
+			             " threshold: " + std::to_string(threshold));
+			Threshold(src, dst, threshold, GetParam());
+			ExpectPixels(dst, [&](int x, int y) {
+				return At(src, x, y) > threshold ? 255 : 0;
+			});
+		}
+	}
+}
+
+TEST_P(OpsTest, Downsample2x) {
+	std::mt19937 rng{44};
+	for (const auto &size : std::vector<Resolution>{
+	         {2, 2},
+	         {7, 5},
+	         {33, 17},
+	         {130, 6},
+	         {1921, 9},
+	     }) {
+		SCOPED_TRACE(std::to_string(size.Width) + "x" +
+		             std::to_string(size.Height));
+		Frame parent{size.Width + 5, size.Height + 1, AV_PIX_FMT_GRAY8, 1};
+		Frame src = View(parent, size);
+		Frame dst{size.Width / 2, size.Height / 2, AV_PIX_FMT_GRAY8};
+		FillRandom(src, rng);
+
+		Downsample2x(src, dst, GetParam());
+		ExpectPixels(dst, [&](int x, int y) {
+			return (At(src, 2 * x, 2 * y) + At(src, 2 * x + 1, 2 * y) +
+			        At(src, 2 * x, 2 * y + 1) + At(src, 2 * x + 1, 2 * y + 1) +
+			        2) /
+			       4;
+		});
+	}
+}
+
+TEST_P(OpsTest, GaussianDownsample2x) {
+	std::mt19937 rng{48};
+	for (const auto &size : std::vector<Resolution>{
+	         {2, 2},
+	         {7, 5},
+	         {33, 17},
+	         {130, 6},
+	         {1921, 9},
+	     }) {
+		SCOPED_TRACE(std::to_string(size.Width) + "x" +
+		             std::to_string(size.Height));
+		Frame parent{size.Width + 5, size.Height + 1, AV_PIX_FMT_GRAY8, 1};
+		Frame src = View(parent, size);
+		Frame dst{size.Width / 2, size.Height / 2, AV_PIX_FMT_GRAY8};
+		FillRandom(src, rng);
+
+		GaussianDownsample2x(src, dst, GetParam());
+		const int weights[5] = {1, 4, 6, 4, 1};
+		ExpectPixels(dst, [&](int x, int y) {
+			int sum = 0;
+			for (int j = 0; j < 5; ++j) {
+				for (int i = 0; i < 5; ++i) {
+					sum += weights[i] * weights[j] *
+					       At(src,
+					          std::clamp(2 * x + i - 2, 0, size.Width - 1),
+					          std::clamp(2 * y + j - 2, 0, size.Height - 1));
+				}
+			}
+			return (sum + 128) / 256;
+		});
+	}
+}
+
+TEST_P(OpsTest, DownsamplesByBands) {
+	std::mt19937 rng{49};
+	Frame        src{97, 63, AV_PIX_FMT_GRAY8};
+	Frame        full{48, 31, AV_PIX_FMT_GRAY8};
+	Frame        bands{48, 31, AV_PIX_FMT_GRAY8};
+	FillRandom(src, rng);
+
+	Downsample2x(src, full, GetParam());
+	for (int y = 0; y < 31; y += 7) {
+		Downsample2x(src, bands, y, std::min(y + 7, 31), GetParam());
+	}
+	ExpectPixels(bands, [&](int x, int y) { return At(full, x, y); });
+
+	GaussianDownsample2x(src, full, GetParam());
+	for (int y = 0; y < 31; y += 5) {
+		GaussianDownsample2x(src, bands, y, std::min(y + 5, 31), GetParam());
+	}
+	ExpectPixels(bands, [&](int x, int y) { return At(full, x, y); });
+
+	EXPECT_THROW(
+	    Downsample2x(src, bands, 3, 2, GetParam()),
+	    cpptrace::invalid_argument
+	);
+	EXPECT_THROW(
+	    GaussianDownsample2x(src, bands, 0, 32, GetParam()),
+	    cpptrace::invalid_argument
+	);
+}
+
+TEST_P(OpsTest, Histogram) {
+	std::mt19937 rng{45};
+	for (const auto &size : Sizes()) {
+		Frame parent{size.Width + 5, size.Height + 1, AV_PIX_FMT_GRAY8, 1};
+		Frame src = View(parent, size);
+		FillRandom(src, rng);
+		Histogram expected{};
+		for (int y = 0; y < size.Height; ++y) {
+			for (int x = 0; x < size.Width; ++x) {
+				++expected[At(src, x, y)];
+			}
+		}
+		EXPECT_EQ(ComputeHistogram(src), expected);
+	}
+
+	Frame constant{64, 3, AV_PIX_FMT_GRAY8};
+	std::fill_n(constant.Planes[0], constant.Linesize[0] * 3, 17);
+	EXPECT_EQ(ComputeHistogram(constant)[17], 64 * 3);
+}
+
+TEST_P(OpsTest, BoxBlur) {
+	std::mt19937 rng{46};
+	for (const auto &size : Sizes()) {
+		Frame parent{size.Width + 5, size.Height + 1, AV_PIX_FMT_GRAY8, 1};
+		Frame src = View(parent, size), dst{size, AV_PIX_FMT_GRAY8};
+		FillRandom(src, rng);
+		for (int radius : {0, 1, 2, 5, 20}) {
+			SCOPED_TRACE(std::to_string(size.Width) + "x" +
+			             std::to_string(size.Height) +
+			             " radius: " + std::to_string(radius));
+			BoxBlur(src, dst, radius, GetParam());
+			const int area = (2 * radius + 1) * (2 * radius + 1);
+			ExpectPixels(dst, [&](int x, int y) {
+				int sum = 0;
+				for (int dy = -radius; dy <= radius; ++dy) {
+					for (int dx = -radius; dx <= radius; ++dx) {
+						sum += At(
+						    src,
+						    std::clamp(x + dx, 0, size.Width - 1),
+						    std::clamp(y + dy, 0, size.Height - 1)
+						);
+					}
+				}
+				return (sum + area / 2) / area;
+			});
+		}
+	}
+
+	Frame white{40, 40, AV_PIX_FMT_GRAY8}, dst{40, 40, AV_PIX_FMT_GRAY8};
+	std::fill_n(white.Planes[0], white.Linesize[0] * 40, 255);
+	BoxBlur(white, dst, 127, GetParam());
+	ExpectPixels(dst, [](int, int) { return 255; });
+}
+
+TEST_P(OpsTest, ChecksArguments) {
+	Frame gray{16, 16, AV_PIX_FMT_GRAY8}, small{8, 8, AV_PIX_FMT_GRAY8};
+	Frame yuv{16, 16, AV_PIX_FMT_YUV420P};
+	const auto level = GetParam();
+	using cpptrace::invalid_argument;
+	EXPECT_THROW(AbsDiff(gray, yuv, gray, level), invalid_argument);
+	EXPECT_THROW(AbsDiff(gray, small, gray, level), invalid_argument);
+	EXPECT_THROW(SumAbsDiff(gray, small, level), invalid_argument);
+	EXPECT_THROW(Threshold(yuv, yuv, 0, level), invalid_argument);
+	EXPECT_THROW(Downsample2x(gray, gray, level), invalid_argument);
+	EXPECT_NO_THROW(Downsample2x(gray, small, level));
+	EXPECT_THROW(ComputeHistogram(yuv), invalid_argument);
+	EXPECT_THROW(BoxBlur(gray, small, 1, level), invalid_argument);
+	EXPECT_THROW(BoxBlur(gray, yuv, 1, level), invalid_argument);
+	EXPECT_THROW(BoxBlur(gray, gray, 128, level), invalid_argument);
+}
+
+TEST(OpsLumaTest, ViewsLumaPlanes) {
+	EXPECT_TRUE(HasLumaPlane(AV_PIX_FMT_GRAY8));
+	EXPECT_TRUE(HasLumaPlane(AV_PIX_FMT_YUV420P));
+	EXPECT_TRUE(HasLumaPlane(AV_PIX_FMT_NV12));
+	EXPECT_FALSE(HasLumaPlane(AV_PIX_FMT_RGB24));
+	EXPECT_FALSE(HasLumaPlane(AV_PIX_FMT_NONE));
+
+	Frame yuv{16, 8, AV_PIX_FMT_YUV420P};
+	auto  luma = LumaView(yuv);
+	EXPECT_EQ(luma.Format, AV_PIX_FMT_GRAY8);
+	EXPECT_EQ(luma.Size, yuv.Size);
+	EXPECT_EQ(luma.Planes[0], yuv.Planes[0]);
+	EXPECT_EQ(luma.Linesize[0], yuv.Linesize[0]);
+	EXPECT_FALSE(luma.Owning());
+
+	Frame rgb{16, 8, AV_PIX_FMT_RGB24};
+	EXPECT_THROW(LumaView(rgb), cpptrace::invalid_argument);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    AllLevels,
+    OpsTest,
+    ::testing::Values(SIMDLevel::Scalar, SIMDLevel::SSE41, SIMDLevel::AVX2),
+    [](const ::testing::TestParamInfo<SIMDLevel> &info) {
+	    auto name = to_string(info.param);
+	    name.erase(std::remove(name.begin(), name.end(), '.'), name.end());
+	    return name;
+    }
+);
+
+} // namespace ops
+} // namespace video
+} // namespace fort
@@ -28,11 +28,13 @@ std::tuple<int, uint8_t> MapFormat(PixelFormat fmt) {
 		};
 	}
 }
-} // namespace details
 
-std::unique_ptr<video::Frame>
-ReadPNG(const std::filesystem::path &path, PixelFormat format) {
-	auto [fmt, _] = details::MapFormat(format);
+// Decodes path in a frame returned by allocate(width, height).
+template <typename Allocate>
+static auto readPNG(
+    const std::filesystem::path &path, PixelFormat format, Allocate &&allocate
+) -> decltype(allocate(0, 0)) {
+	auto [fmt, _] = MapFormat(format);
 
 	FILE *file = std::fopen(path.c_str(), "rb");
 	if (file == nullptr) {
@@ -46,13 +48,13 @@ ReadPNG(const std::filesystem::path &path, PixelFormat format) {
 		fclose(file);
 	};
 
-	details::SPNGCall(spng_set_png_file, ctx, file);
+	SPNGCall(spng_set_png_file, ctx, file);
 
 	struct spng_ihdr ihdr;
-	details::SPNGCall(spng_get_ihdr, ctx, &ihdr);
+	SPNGCall(spng_get_ihdr, ctx, &ihdr);
 
 	size_t decodedSize;
-	details::SPNGCall(spng_decoded_image_size, ctx, fmt, &decodedSize);
+	SPNGCall(spng_decoded_image_size, ctx, fmt, &decodedSize);
 
 	constexpr static size_t MAX_IMAGE_SIZE = 8192 * 8192;
 
@@ -66,10 +68,9 @@ ReadPNG(const std::filesystem::path &path, PixelFormat format) {
 		throw cpptrace::runtime_error(oss.str());
 	}
 
-	auto res =
-	    std::make_unique<video::Frame>(ihdr.width, ihdr.height, format, 32);
+	auto res = allocate(int(ihdr.width), int(ihdr.height));
 
-	details::SPNGCall(
+	SPNGCall(
 	    spng_decode_image,
 	    ctx,
 	    nullptr,
@@ -82,16 +83,16 @@ ReadPNG(const std::filesystem::path &path, PixelFormat format) {
 
 	try {
 		while (true) {
-			details::SPNGCall(spng_get_row_info, ctx, &rowInfo);
+			SPNGCall(spng_get_row_info, ctx, &rowInfo);
 
 			// note that video::Frame is not necessarly packed, use stride
 			// instead of width.
 			uint8_t *rowAddr =
 			    res->Planes[0] + res->Linesize[0] * rowInfo.row_num;
 
-			details::SPNGCall(spng_decode_row, ctx, rowAddr, res->Linesize[0]);
+			SPNGCall(spng_decode_row, ctx, rowAddr, res->Linesize[0]);
 		}
-	} catch (const details::SPNGError &e) {
+	} catch (const SPNGError &e) {
 		if (e.Code() != SPNG_EOI) {
 			throw;
 		}
@@ -99,6 +100,22 @@ ReadPNG(const std::filesystem::path &path, PixelFormat format) {
 
 	return res;
 }
+} // namespace details
+
+std::unique_ptr<video::Frame>
+ReadPNG(const std::filesystem::path &path, PixelFormat format) {
+	return details::readPNG(path, format, [format](int width, int height) {
+		return std::make_unique<video::Frame>(width, height, format, 32);
+	});
+}
+
+FramePool::FramePtr ReadPNG(
+    const std::filesystem::path &path, PixelFormat format, FramePool &pool
+) {
+	return details::readPNG(path, format, [&](int width, int height) {
+		return pool.Get({width, height}, format);
+	});
+}
 
 void WritePNG(const std::filesystem::path &path, const video::Frame &frame) {
 	auto [fmt, colorType] = details::MapFormat(frame.Format);
@@ -2,6 +2,7 @@
 
 #include <filesystem>
 #include <fort/video/Frame.hpp>
+#include <fort/video/FramePool.hpp>
 #include <fort/video/Types.hpp>
 #include <memory>
 
@@ -12,6 +13,11 @@ namespace video {
 std::unique_ptr<video::Frame>
 ReadPNG(const std::filesystem::path &path, PixelFormat = AV_PIX_FMT_GRAY8);
 
+// Reads a PNG in a frame recycled from pool.
+FramePool::FramePtr ReadPNG(
+    const std::filesystem::path &path, PixelFormat format, FramePool &pool
+);
+
 void WritePNG(const std::filesystem::path &path, const video::Frame &image);
 
 } // namespace video
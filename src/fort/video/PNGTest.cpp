@@ -121,6 +121,23 @@ TEST_F(PNGTest, CanReadGrayImage) {
 	}
 }
 
+TEST_F(PNGTest, CanReadInPooledFrames) {
+	auto     pool   = FramePool::Create();
+	uint8_t *planes = nullptr;
+	{
+		auto gray = ReadPNG(TempDir / "gray.png", AV_PIX_FMT_GRAY8, *pool);
+		planes    = gray->Planes[0];
+	}
+	auto gray = ReadPNG(TempDir / "gray.png", AV_PIX_FMT_GRAY8, *pool);
+	EXPECT_EQ(gray->Planes[0], planes);
+	EXPECT_EQ(pool->GetStats().Allocated, 1);
+	ASSERT_EQ(gray->Size, RESOLUTION);
+	for (int i = 0; i < SIZE; i++) {
+		SCOPED_TRACE(std::to_string(i));
+		EXPECT_EQ(gray->Planes[0][i], Gray[i]);
+	}
+}
+
 TEST_F(PNGTest, CanReadRGBImage) {
 	std::unique_ptr<video::Frame> rgb;
 
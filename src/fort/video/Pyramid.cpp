@@ -0,0 +1,138 @@
+#include "Pyramid.hpp"
+#include "Ops.hpp"
+#include "TypesIO.hpp"
+
+#include <algorithm>
+#include <cpptrace/cpptrace.hpp>
+#include <vector>
+
+namespace fort {
+namespace video {
+
+struct Pyramid::Implementation {
+	Params             d_params;
+	Resolution         d_size;
+	std::vector<Frame> d_levels;
+	// number of rows of each level already computed.
+	std::vector<int> d_done;
+	int              d_baseRows = 0;
+
+	Implementation(const Resolution &size, const Params &params)
+	    : d_params{params}
+	    , d_size{size} {
+		if (params.Levels <= 0 || (size.Width >> params.Levels) == 0 ||
+		    (size.Height >> params.Levels) == 0) {
+			throw cpptrace::invalid_argument{
+			    "cannot build " + std::to_string(params.Levels) +
+			    " pyramid levels of a " + std::to_string(size) + " frame",
+			};
+		}
+		d_levels.reserve(params.Levels);
+		Resolution s = size;
+		for (int i = 0; i < params.Levels; ++i) {
+			s = {s.Width / 2, s.Height / 2};
+			d_levels.emplace_back(s, AV_PIX_FMT_GRAY8);
+		}
+		d_done.resize(params.Levels, 0);
+	}
+
+	void Reset() noexcept {
+		d_baseRows = 0;
+		std::fill(d_done.begin(), d_done.end(), 0);
+	}
+
+	void Update(const Frame &frame, int rows) {
+		if (frame.Size != d_size) {
+			throw cpptrace::invalid_argument{
+			    "invalid frame size " + std::to_string(frame.Size) +
+			    ", expected " + std::to_string(d_size),
+			};
+		}
+		rows = std::clamp(rows, 0, d_size.Height);
+		if (rows <= d_baseRows) {
+			return;
+		}
+		d_baseRows = rows;
+
+		const Frame  base      = ops::LumaView(frame);
+		const Frame *src       = &base;
+		int          available = rows;
+		for (size_t i = 0; i < d_levels.size(); ++i) {
+			Frame &dst   = d_levels[i];
+			int    ready = readyRows(*src, dst, available);
+			if (ready > d_done[i]) {
+				downsample(*src, dst, d_done[i], ready);
+				d_done[i] = ready;
+			}
+			src       = &dst;
+			available = d_done[i];
+		}
+	}
+
+	// Returns the number of rows of dst computable from the available
+	// first rows of src.
+	int readyRows(const Frame &src, const Frame &dst, int available) const {
+		if (available == src.Size.Height) {
+			return dst.Size.Height;
+		}
+		if (d_params.Filter == PyramidFilter::Box) {
+			return std::min(available / 2, dst.Size.Height);
+		}
+		// row y reads src rows up to 2 * y + 2.
+		return std::clamp((available - 1) / 2, 0, dst.Size.Height);
+	}
+
+	void downsample(const Frame &src, Frame &dst, int first, int last) {
+		if (d_params.Filter == PyramidFilter::Box) {
+			ops::Downsample2x(src, dst, first, last);
+		} else {
+			ops::GaussianDownsample2x(src, dst, first, last);
+		}
+	}
+};
+
+Pyramid::Pyramid(const Resolution &size, const Params &params)
+    : self{std::make_unique<Implementation>(size, params)} {}
+
+Pyramid::~Pyramid() = default;
+
+const Pyramid::Params &Pyramid::GetParams() const noexcept {
+	return self->d_params;
+}
+
+Resolution Pyramid::BaseSize() const noexcept {
+	return self->d_size;
+}
+
+size_t Pyramid::Size() const noexcept {
+	return self->d_levels.size();
+}
+
+const Frame &Pyramid::operator[](size_t level) const {
+	return self->d_levels.at(level);
+}
+
+void Pyramid::Build(const Frame &frame) {
+	// bands small enough that each one is still cached when the next level
+	// reads it.
+	constexpr static int BAND_HEIGHT = 64;
+	self->Reset();
+	for (int rows = BAND_HEIGHT; !Complete(); rows += BAND_HEIGHT) {
+		self->Update(frame, rows);
+	}
+}
+
+void Pyramid::Reset() noexcept {
+	self->Reset();
+}
+
+void Pyramid::Update(const Frame &frame, int rows) {
+	self->Update(frame, rows);
+}
+
+bool Pyramid::Complete() const noexcept {
+	return self->d_baseRows == self->d_size.Height;
+}
+
+} // namespace video
+} // namespace fort
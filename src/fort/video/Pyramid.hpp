@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+
+#include "Frame.hpp"
+#include "Types.hpp"
+
+namespace fort {
+namespace video {
+
+enum class PyramidFilter {
+	// 2x2 mean, the cheapest.
+	Box,
+	// 5x5 binomial low-pass, less aliasing for multi-scale detection.
+	Gaussian,
+};
+
+// Pyramid holds successive halvings of the luma plane of frames, as GRAY8
+// frames. Level 0 is half the base size, level i is half of level i - 1.
+//
+// Levels are built in a single pass over the base rows: each new band of
+// rows is pushed through every level while it is still in cache, instead
+// of re-reading the whole image once per level. Reader::Read() can build
+// it during the conversion of decoded frames.
+class Pyramid {
+public:
+	struct Params {
+		int           Levels = 3;
+		PyramidFilter Filter = PyramidFilter::Box;
+	};
+
+	// Allocates the levels for base frames of size. Throws
+	// cpptrace::invalid_argument if the last level would be empty.
+	Pyramid(const Resolution &size, const Params &params);
+	~Pyramid();
+
+	const Params &GetParams() const noexcept;
+
+	Resolution BaseSize() const noexcept;
+
+	// Number of levels.
+	size_t Size() const noexcept;
+
+	const Frame &operator[](size_t level) const;
+
+	// Builds all levels from the luma plane of frame, which must have the
+	// base size and a format accepted by ops::HasLumaPlane().
+	void Build(const Frame &frame);
+
+	// Incremental building, for frames produced from top to bottom: Reset()
+	// starts a new frame, and each Update() processes the rows of frame
+	// made available since the last one. rows is the total number of
+	// available rows.
+	void Reset() noexcept;
+	void Update(const Frame &frame, int rows);
+
+	// Returns true once all the base rows were processed.
+	bool Complete() const noexcept;
+
+private:
+	struct Implementation;
+
+	std::unique_ptr<Implementation> self;
+};
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,92 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include <fort/video/Frame.hpp>
+#include <fort/video/Ops.hpp>
+#include <fort/video/Pyramid.hpp>
+
+namespace fort {
+namespace video {
+
+static void fillRandom(Frame &frame) {
+	std::mt19937                       rng{0};
+	std::uniform_int_distribution<int> dist{0, 255};
+	for (int y = 0; y < frame.Size.Height; ++y) {
+		for (int x = 0; x < frame.Linesize[0]; ++x) {
+			frame.Planes[0][y * frame.Linesize[0] + x] = dist(rng);
+		}
+	}
+}
+
+static void setThroughput(benchmark::State &state, const Resolution &size) {
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(
+	    int64_t(state.iterations()) * size.Width * size.Height
+	);
+}
+
+static void BM_PyramidBuild(benchmark::State &state) {
+	const auto       filter = PyramidFilter(state.range(0));
+	const Resolution size{int(state.range(1)), int(state.range(2))};
+	state.SetLabel(filter == PyramidFilter::Box ? "box" : "gaussian");
+
+	Frame frame{size, AV_PIX_FMT_GRAY8};
+	fillRandom(frame);
+	Pyramid pyramid{size, {.Levels = 4, .Filter = filter}};
+
+	for (auto _ : state) {
+		pyramid.Build(frame);
+		benchmark::ClobberMemory();
+	}
+	setThroughput(state, size);
+}
+
+// Builds the same levels one whole frame at a time, for comparison.
+static void BM_PyramidPerLevel(benchmark::State &state) {
+	const auto       filter = PyramidFilter(state.range(0));
+	const Resolution size{int(state.range(1)), int(state.range(2))};
+	state.SetLabel(filter == PyramidFilter::Box ? "box" : "gaussian");
+
+	Frame frame{size, AV_PIX_FMT_GRAY8};
+	fillRandom(frame);
+	std::vector<Frame> levels;
+	Resolution         s = size;
+	for (int i = 0; i < 4; ++i) {
+		s = {s.Width / 2, s.Height / 2};
+		levels.emplace_back(s, AV_PIX_FMT_GRAY8);
+	}
+
+	for (auto _ : state) {
+		const Frame *src = &frame;
+		for (auto &level : levels) {
+			if (filter == PyramidFilter::Box) {
+				ops::Downsample2x(*src, level);
+			} else {
+				ops::GaussianDownsample2x(*src, level);
+			}
+			src = &level;
+		}
+		benchmark::ClobberMemory();
+	}
+	setThroughput(state, size);
+}
+
+static void filtersAndSizes(benchmark::internal::Benchmark *b) {
+	for (auto filter : {PyramidFilter::Box, PyramidFilter::Gaussian}) {
+		b->Args({int(filter), 1920, 1080});
+		b->Args({int(filter), 3840, 2160});
+	}
+}
+
+BENCHMARK(BM_PyramidBuild)
+    ->Apply(filtersAndSizes)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_PyramidPerLevel)
+    ->Apply(filtersAndSizes)
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace video
+} // namespace fort
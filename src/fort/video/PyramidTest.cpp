@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <cpptrace/cpptrace.hpp>
+#include <cstring>
+#include <random>
+
+#include <fort/video/Frame.hpp>
+#include <fort/video/Ops.hpp>
+#include <fort/video/Pyramid.hpp>
+
+namespace fort {
+namespace video {
+
+class PyramidTest : public ::testing::TestWithParam<PyramidFilter> {
+protected:
+	static void FillRandom(Frame &frame, std::mt19937 &rng) {
+		std::uniform_int_distribution<int> dist{0, 255};
+		for (int y = 0; y < frame.Size.Height; ++y) {
+			for (int x = 0; x < frame.Size.Width; ++x) {
+				frame.Planes[0][y * frame.Linesize[0] + x] = dist(rng);
+			}
+		}
+	}
+
+	// Builds the expected levels by downsampling whole frames.
+	static std::vector<Frame> Reference(const Frame &frame, int levels) {
+		std::vector<Frame> res;
+		Frame              luma = ops::LumaView(frame);
+		const Frame       *src  = &luma;
+		// src points into res.
+		res.reserve(levels);
+		for (int i = 0; i < levels; ++i) {
+			res.emplace_back(
+			    src->Size.Width / 2,
+			    src->Size.Height / 2,
+			    AV_PIX_FMT_GRAY8
+			);
+			if (GetParam() == PyramidFilter::Box) {
+				ops::Downsample2x(*src, res.back());
+			} else {
+				ops::GaussianDownsample2x(*src, res.back());
+			}
+			src = &res.back();
+		}
+		return res;
+	}
+
+	static void ExpectSame(const Frame &a, const Frame &b) {
+		ASSERT_EQ(a.Size, b.Size);
+		for (int y = 0; y < a.Size.Height; ++y) {
+			ASSERT_EQ(
+			    0,
+			    memcmp(
+			        a.Planes[0] + y * a.Linesize[0],
+			        b.Planes[0] + y * b.Linesize[0],
+			        a.Size.Width
+			    )
+			) << "row " << y;
+		}
+	}
+};
+
+TEST_P(PyramidTest, BuildsLevels) {
+	std::mt19937 rng{42};
+	Frame        frame{101, 67, AV_PIX_FMT_YUV420P};
+	FillRandom(frame, rng);
+
+	Pyramid pyramid{frame.Size, {.Levels = 4, .Filter = GetParam()}};
+	ASSERT_EQ(pyramid.Size(), 4);
+	EXPECT_EQ(pyramid[0].Size, (Resolution{50, 33}));
+	EXPECT_EQ(pyramid[3].Size, (Resolution{6, 4}));
+	EXPECT_FALSE(pyramid.Complete());
+
+	pyramid.Build(frame);
+	EXPECT_TRUE(pyramid.Complete());
+	auto expected = Reference(frame, 4);
+	for (size_t i = 0; i < expected.size(); ++i) {
+		SCOPED_TRACE("level " + std::to_string(i));
+		ExpectSame(pyramid[i], expected[i]);
+	}
+}
+
+TEST_P(PyramidTest, BuildsIncrementally) {
+	std::mt19937 rng{43};
+	Frame        frame{256, 131, AV_PIX_FMT_GRAY8};
+	FillRandom(frame, rng);
+	auto expected = Reference(frame, 3);
+
+	Pyramid pyramid{frame.Size, {.Levels = 3, .Filter = GetParam()}};
+	for (int band : {1, 7, 16, 64}) {
+		SCOPED_TRACE("band " + std::to_string(band));
+		pyramid.Reset();
+		for (int rows = band; !pyramid.Complete(); rows += band) {
+			pyramid.Update(frame, rows);
+		}
+		for (size_t i = 0; i < expected.size(); ++i) {
+			SCOPED_TRACE("level " + std::to_string(i));
+			ExpectSame(pyramid[i], expected[i]);
+		}
+	}
+}
+
+TEST_P(PyramidTest, ChecksArguments) {
+	EXPECT_THROW(
+	    (Pyramid{{16, 16}, {.Levels = 0, .Filter = GetParam()}}),
+	    cpptrace::invalid_argument
+	);
+	EXPECT_THROW(
+	    (Pyramid{{64, 8}, {.Levels = 4, .Filter = GetParam()}}),
+	    cpptrace::invalid_argument
+	);
+	Pyramid pyramid{{16, 16}, {.Levels = 2, .Filter = GetParam()}};
+	Frame   wrongSize{16, 8, AV_PIX_FMT_GRAY8};
+	Frame   rgb{16, 16, AV_PIX_FMT_RGB24};
+	EXPECT_THROW(pyramid.Build(wrongSize), cpptrace::invalid_argument);
+	EXPECT_THROW(pyramid.Build(rgb), cpptrace::invalid_argument);
+	EXPECT_THROW(pyramid[2], std::out_of_range);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Filters,
+    PyramidTest,
+    ::testing::Values(PyramidFilter::Box, PyramidFilter::Gaussian),
+    [](const ::testing::TestParamInfo<PyramidFilter> &info) {
+	    return info.param == PyramidFilter::Box ? "Box" : "Gaussian";
+    }
+);
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,527 @@
+#include "RawVideo.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cpptrace/cpptrace.hpp>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/mathematics.h>
+#include <libavutil/pixdesc.h>
+}
+
+#include "TypesIO.hpp"
+#include "details/AVCall.hpp"
+
+namespace fort {
+namespace video {
+
+namespace {
+
+struct Y4MColorspace {
+	const char *Name;
+	PixelFormat Format;
+};
+
+// The first entry of a format is the one written.
+constexpr Y4MColorspace Y4M_COLORSPACES[] = {
+    {"420jpeg", AV_PIX_FMT_YUV420P},
+    {"420paldv", AV_PIX_FMT_YUV420P},
+    {"420mpeg2", AV_PIX_FMT_YUV420P},
+    {"420", AV_PIX_FMT_YUV420P},
+    {"422", AV_PIX_FMT_YUV422P},
+    {"444", AV_PIX_FMT_YUV444P},
+    {"444alpha", AV_PIX_FMT_YUVA444P},
+    {"mono", AV_PIX_FMT_GRAY8},
+    {"mono16", AV_PIX_FMT_GRAY16LE},
+    {"420p10", AV_PIX_FMT_YUV420P10LE},
+    {"422p10", AV_PIX_FMT_YUV422P10LE},
+    {"444p10", AV_PIX_FMT_YUV444P10LE},
+};
+
+constexpr char   Y4M_MAGIC[]           = "YUV4MPEG2";
+constexpr char   Y4M_FRAME_HEADER[]    = "FRAME\n";
+constexpr size_t Y4M_FRAME_HEADER_SIZE = sizeof(Y4M_FRAME_HEADER) - 1;
+
+// Layout of a frame in the file: planes are stored one after the other,
+// without any padding.
+struct PlaneLayout {
+	int    Count = 0;
+	int    Bytes[4]{};
+	int    Rows[4]{};
+	size_t Size = 0;
+};
+
+PlaneLayout planeLayout(const RawVideoFormat &format) {
+	const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format.Format);
+	if (desc == nullptr ||
+	    (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM |
+	                    AV_PIX_FMT_FLAG_PAL)) != 0) {
+		throw cpptrace::invalid_argument{
+		    "unsupported raw pixel format " + std::to_string(format.Format),
+		};
+	}
+	if (format.Size.Width <= 0 || format.Size.Height <= 0) {
+		throw cpptrace::invalid_argument{
+		    "invalid raw video size " + std::to_string(format.Size),
+		};
+	}
+
+	PlaneLayout res;
+	details::AVCall(
+	    av_image_fill_linesizes,
+	    res.Bytes,
+	    format.Format,
+	    format.Size.Width
+	);
+	res.Count = av_pix_fmt_count_planes(format.Format);
+	for (int i = 0; i < res.Count; ++i) {
+		const int shift = (i == 1 || i == 2) ? desc->log2_chroma_h : 0;
+		res.Rows[i]     = (format.Size.Height + (1 << shift) - 1) >> shift;
+		res.Size += size_t(res.Bytes[i]) * res.Rows[i];
+	}
+	return res;
+}
+
+void checkFrame(const Frame &frame, const RawVideoFormat &format) {
+	if (frame.Format == format.Format && frame.Size == format.Size) {
+		return;
+	}
+	throw std::invalid_argument{
+	    std::string{"invalid frame {format: "} + std::to_string(frame.Format) +
+	    ", size: " + std::to_string(frame.Size) +
+	    "}, expected {format: " + std::to_string(format.Format) +
+	    ", size: " + std::to_string(format.Size) + "}",
+	};
+}
+
+// Parses the value of a header token after its one letter tag.
+template <typename T> T parseY4MValue(const std::string &token) {
+	T    value{};
+	auto res =
+	    std::from_chars(token.data() + 1, token.data() + token.size(), value);
+	if (res.ec != std::errc{} || res.ptr != token.data() + token.size()) {
+		throw cpptrace::runtime_error{
+		    "invalid YUV4MPEG2 header token '" + token + "'",
+		};
+	}
+	return value;
+}
+
+// Parses a "F30000:1001" like token.
+Ratio<int> parseY4MRatio(const std::string &token) {
+	const auto colon = token.find(':');
+	if (colon == std::string::npos) {
+		throw cpptrace::runtime_error{
+		    "invalid YUV4MPEG2 header token '" + token + "'",
+		};
+	}
+	// parseY4MValue() skips the tag, here the 'F' and the ':'.
+	return {
+	    parseY4MValue<int>(token.substr(0, colon)),
+	    parseY4MValue<int>(token.substr(colon)),
+	};
+}
+
+} // namespace
+
+struct RawReader::Implementation {
+	RawVideoFormat d_format;
+	PlaneLayout    d_layout;
+
+	const uint8_t *d_data = nullptr;
+	size_t         d_size = 0;
+
+	// offset of the first frame data, and distance between two frames, when
+	// all frame headers have the same size.
+	size_t d_start = 0, d_stride = 0;
+	// offsets of each frame data otherwise.
+	std::vector<size_t> d_offsets;
+
+	size_t d_length = 0;
+	size_t d_next   = 0;
+
+	Implementation(const std::filesystem::path &path) {
+		map(path);
+		d_format = parseHeader();
+		d_layout = planeLayout(d_format);
+		d_stride = Y4M_FRAME_HEADER_SIZE + d_layout.Size;
+		d_length = (d_size - d_start) / d_stride;
+		if ((d_size - d_start) % d_stride != 0) {
+			// some frame headers have parameters, or the file is truncated.
+			index();
+		}
+		d_start += Y4M_FRAME_HEADER_SIZE;
+	}
+
+	Implementation(
+	    const std::filesystem::path &path, const RawVideoFormat &format
+	)
+	    : d_format{format}
+	    , d_layout{planeLayout(format)} {
+		map(path);
+		d_stride = d_layout.Size;
+		d_length = d_size / d_stride;
+	}
+
+	~Implementation() {
+		if (d_data != nullptr) {
+			munmap(const_cast<uint8_t *>(d_data), d_size);
+		}
+	}
+
+	void map(const std::filesystem::path &path) {
+		int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			throw std::system_error{
+			    errno,
+			    std::generic_category(),
+			    "open('" + path.string() + "')",
+			};
+		}
+		struct stat st;
+		if (fstat(fd, &st) != 0) {
+			int error = errno;
+			::close(fd);
+			throw std::system_error{error, std::generic_category(), "fstat()"};
+		}
+		d_size = st.st_size;
+		if (d_size == 0) {
+			::close(fd);
+			return;
+		}
+		void *data = mmap(nullptr, d_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		int   error = errno;
+		// the mapping stays valid after closing the descriptor.
+		::close(fd);
+		if (data == MAP_FAILED) {
+			throw std::system_error{error, std::generic_category(), "mmap()"};
+		}
+		d_data = reinterpret_cast<const uint8_t *>(data);
+		// frames are mostly read in order, this enables aggressive readahead.
+		madvise(data, d_size, MADV_SEQUENTIAL);
+	}
+
+	RawVideoFormat parseHeader() {
+		const auto *begin = reinterpret_cast<const char *>(d_data);
+		const char *end   = nullptr;
+		if (d_size > 0) {
+			end = reinterpret_cast<const char *>(
+			    std::memchr(begin, '\n', d_size)
+			);
+		}
+		if (end == nullptr ||
+		    std::strncmp(begin, Y4M_MAGIC, sizeof(Y4M_MAGIC) - 1) != 0) {
+			throw cpptrace::runtime_error{"missing YUV4MPEG2 header"};
+		}
+		d_start = end - begin + 1;
+
+		RawVideoFormat     res{.Size = {0, 0}, .Format = AV_PIX_FMT_YUV420P};
+		std::istringstream tokens{std::string{begin, end}};
+		std::string        token;
+		tokens >> token;
+		while (tokens >> token) {
+			switch (token[0]) {
+			case 'W':
+				res.Size.Width = parseY4MValue<int>(token);
+				break;
+			case 'H':
+				res.Size.Height = parseY4MValue<int>(token);
+				break;
+			case 'F':
+				res.Framerate = parseY4MRatio(token);
+				break;
+			case 'C':
+				res.Format = parseColorspace(token.substr(1));
+				break;
+			default:
+				// interlacing, aspect ratio and extensions are ignored.
+				break;
+			}
+		}
+		if (res.Framerate.Num <= 0 || res.Framerate.Den <= 0) {
+			res.Framerate = {25, 1};
+		}
+		return res;
+	}
+
+	static PixelFormat parseColorspace(const std::string &name) {
+		for (const auto &c : Y4M_COLORSPACES) {
+			if (name == c.Name) {
+				return c.Format;
+			}
+		}
+		throw cpptrace::runtime_error{
+		    "unsupported YUV4MPEG2 colorspace '" + name + "'",
+		};
+	}
+
+	void index() {
+		size_t offset = d_start;
+		while (offset + Y4M_FRAME_HEADER_SIZE <= d_size) {
+			if (std::memcmp(d_data + offset, "FRAME", 5) != 0) {
+				throw cpptrace::runtime_error{
+				    "invalid YUV4MPEG2 frame header at offset " +
+				    std::to_string(offset),
+				};
+			}
+			auto end = reinterpret_cast<const uint8_t *>(
+			    std::memchr(d_data + offset, '\n', d_size - offset)
+			);
+			if (end == nullptr) {
+				break;
+			}
+			offset = end + 1 - d_data;
+			if (offset + d_layout.Size > d_size) {
+				break;
+			}
+			d_offsets.push_back(offset);
+			offset += d_layout.Size;
+		}
+		d_length = d_offsets.size();
+	}
+
+	const uint8_t *frameData(size_t index) const {
+		if (d_offsets.empty() == false) {
+			return d_data + d_offsets[index];
+		}
+		const size_t offset = d_start + index * d_stride;
+		if (d_stride != d_layout.Size &&
+		    std::memcmp(
+		        d_data + offset - Y4M_FRAME_HEADER_SIZE,
+		        Y4M_FRAME_HEADER,
+		        Y4M_FRAME_HEADER_SIZE
+		    ) != 0) {
+			throw cpptrace::runtime_error{
+			    "invalid YUV4MPEG2 frame header for frame " +
+			    std::to_string(index),
+			};
+		}
+		return d_data + offset;
+	}
+
+	bool Read(Frame &frame) {
+		checkFrame(frame, d_format);
+		if (d_next >= d_length) {
+			return false;
+		}
+
+		const uint8_t *data = frameData(d_next);
+		for (int i = 0; i < d_layout.Count; ++i) {
+			av_image_copy_plane(
+			    frame.Planes[i],
+			    frame.Linesize[i],
+			    data,
+			    d_layout.Bytes[i],
+			    d_layout.Bytes[i],
+			    d_layout.Rows[i]
+			);
+			data += size_t(d_layout.Bytes[i]) * d_layout.Rows[i];
+		}
+		frame.Index = d_next;
+		const int64_t ns = av_rescale(
+		    d_next,
+		    int64_t(1e9) * d_format.Framerate.Den,
+		    d_format.Framerate.Num
+		);
+		frame.PTS = Duration{ns};
+		++d_next;
+		return true;
+	}
+};
+
+RawReader::RawReader(const std::filesystem::path &path)
+    : self{std::make_unique<Implementation>(path)} {}
+
+RawReader::RawReader(
+    const std::filesystem::path &path, const RawVideoFormat &format
+)
+    : self{std::make_unique<Implementation>(path, format)} {}
+
+RawReader::~RawReader() = default;
+
+const RawVideoFormat &RawReader::VideoFormat() const noexcept {
+	return self->d_format;
+}
+
+Resolution RawReader::Size() const noexcept {
+	return self->d_format.Size;
+}
+
+size_t RawReader::Length() const noexcept {
+	return self->d_length;
+}
+
+size_t RawReader::Position() const noexcept {
+	return self->d_next;
+}
+
+size_t RawReader::SeekFrame(size_t position) {
+	self->d_next = std::min(position, self->d_length);
+	return self->d_next;
+}
+
+bool RawReader::Read(Frame &frame) {
+	return self->Read(frame);
+}
+
+std::unique_ptr<video::Frame> RawReader::CreateFrame(int alignement) const {
+	return std::make_unique<video::Frame>(
+	    self->d_format.Size,
+	    self->d_format.Format,
+	    alignement
+	);
+}
+
+FramePool::FramePtr
+RawReader::CreateFrame(FramePool &pool, int alignement) const {
+	return pool.Get(self->d_format.Size, self->d_format.Format, alignement);
+}
+
+struct RawWriter::Implementation {
+	Params         d_params;
+	RawVideoFormat d_format;
+	PlaneLayout    d_layout;
+
+	std::shared_ptr<Sink> d_sink;
+	// set when d_sink is our own file, closed by Close().
+	std::shared_ptr<BufferedFileSink> d_file;
+
+	Implementation(Params &&params, const RawVideoFormat &format)
+	    : d_params{std::move(params)}
+	    , d_format{format}
+	    , d_layout{planeLayout(format)} {
+		const char *colorspace = nullptr;
+		if (d_params.Y4M) {
+			colorspace = findColorspace(format.Format);
+			if (format.Framerate.Num <= 0 || format.Framerate.Den <= 0) {
+				throw cpptrace::invalid_argument{
+				    "invalid framerate " + std::to_string(format.Framerate.Num) +
+				    "/" + std::to_string(format.Framerate.Den),
+				};
+			}
+		}
+
+		if (d_params.Sink) {
+			d_sink = d_params.Sink;
+		} else if (d_params.FileBuffer.BufferSize > 0) {
+			d_file = std::make_shared<BufferedFileSink>(
+			    d_params.Path,
+			    d_params.FileBuffer
+			);
+			d_sink = d_file;
+		} else {
+			int fd = open(
+			    d_params.Path.c_str(),
+			    O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+			    0644
+			);
+			if (fd < 0) {
+				throw std::system_error{
+				    errno,
+				    std::generic_category(),
+				    "open('" + d_params.Path.string() + "')",
+				};
+			}
+			d_sink = std::make_shared<FileDescriptorSink>(fd, true);
+		}
+
+		if (d_params.Y4M) {
+			std::ostringstream header;
+			header << Y4M_MAGIC << " W" << format.Size.Width << " H"
+			       << format.Size.Height << " F" << format.Framerate.Num << ":"
+			       << format.Framerate.Den << " Ip A1:1 C" << colorspace
+			       << "\n";
+			const auto str = header.str();
+			d_sink->Write(
+			    reinterpret_cast<const uint8_t *>(str.data()),
+			    str.size()
+			);
+		}
+	}
+
+	~Implementation() {
+		try {
+			close();
+		} catch (...) {
+		}
+	}
+
+	static const char *findColorspace(PixelFormat format) {
+		for (const auto &c : Y4M_COLORSPACES) {
+			if (c.Format == format) {
+				return c.Name;
+			}
+		}
+		throw cpptrace::invalid_argument{
+		    "pixel format " + std::to_string(format) +
+		        " is not supported by YUV4MPEG2",
+		};
+	}
+
+	void Write(const Frame &frame) {
+		checkFrame(frame, d_format);
+		if (!d_sink) {
+			throw cpptrace::logic_error{"writer is closed"};
+		}
+		if (d_params.Y4M) {
+			d_sink->Write(
+			    reinterpret_cast<const uint8_t *>(Y4M_FRAME_HEADER),
+			    Y4M_FRAME_HEADER_SIZE
+			);
+		}
+		for (int i = 0; i < d_layout.Count; ++i) {
+			const size_t bytes = d_layout.Bytes[i];
+			if (size_t(frame.Linesize[i]) == bytes) {
+				d_sink->Write(frame.Planes[i], bytes * d_layout.Rows[i]);
+				continue;
+			}
+			for (int y = 0; y < d_layout.Rows[i]; ++y) {
+				d_sink->Write(
+				    frame.Planes[i] + size_t(y) * frame.Linesize[i],
+				    bytes
+				);
+			}
+		}
+	}
+
+	void close() {
+		if (!d_sink) {
+			return;
+		}
+		auto sink = std::move(d_sink);
+		auto file = std::move(d_file);
+		sink->Flush();
+		if (file) {
+			file->Close();
+		}
+	}
+};
+
+RawWriter::RawWriter(Params &&params, const RawVideoFormat &format)
+    : self{std::make_unique<Implementation>(std::move(params), format)} {}
+
+RawWriter::~RawWriter() = default;
+
+void RawWriter::Write(const Frame &frame) {
+	self->Write(frame);
+}
+
+void RawWriter::Close() {
+	self->close();
+}
+
+} // namespace video
+} // namespace fort
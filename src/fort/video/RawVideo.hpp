@@ -0,0 +1,97 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+#include "Frame.hpp"
+#include "FramePool.hpp"
+#include "Sink.hpp"
+#include "Types.hpp"
+
+namespace fort {
+namespace video {
+
+// Geometry of an uncompressed video stream.
+struct RawVideoFormat {
+	Resolution  Size;
+	PixelFormat Format    = AV_PIX_FMT_GRAY8;
+	Ratio<int>  Framerate = {25, 1};
+};
+
+// RawReader reads uncompressed frames from a YUV4MPEG2 (.y4m) or a
+// headerless rawvideo file, without libavformat nor libavcodec. The file is
+// memory mapped, and frames are copied directly from the mapping to the
+// Frame planes.
+class RawReader {
+public:
+	// Opens a YUV4MPEG2 file, described by its header.
+	RawReader(const std::filesystem::path &path);
+	// Opens a headerless rawvideo file of consecutive frames in format. A
+	// truncated last frame is ignored.
+	RawReader(const std::filesystem::path &path, const RawVideoFormat &format);
+
+	~RawReader();
+
+	const RawVideoFormat &VideoFormat() const noexcept;
+
+	Resolution Size() const noexcept;
+
+	size_t Length() const noexcept;
+
+	size_t Position() const noexcept;
+
+	// Moves to position, clamped to Length(). Returns the new position.
+	size_t SeekFrame(size_t position);
+
+	// Reads the next frame, which must have the format and size of the
+	// stream. Returns false at the end of the file.
+	bool Read(Frame &frame);
+
+	std::unique_ptr<video::Frame> CreateFrame(int alignement = 32) const;
+
+	// Returns a frame for Read() recycled from pool.
+	FramePool::FramePtr CreateFrame(FramePool &pool, int alignement = 32) const;
+
+private:
+	struct Implementation;
+
+	std::unique_ptr<Implementation> self;
+};
+
+// RawWriter writes uncompressed frames to a YUV4MPEG2 or a headerless
+// rawvideo file, without libavformat nor libavcodec.
+class RawWriter {
+public:
+	struct Params {
+		std::filesystem::path Path;
+		// Writes a YUV4MPEG2 header and frame markers. Otherwise frames are
+		// written back to back. YUV4MPEG2 only supports planar YUV and gray
+		// formats.
+		bool Y4M = true;
+		// If set, the output is written to this sink instead of Path.
+		std::shared_ptr<video::Sink> Sink;
+		// Path is written through a BufferedFileSink with these options,
+		// unless FileBuffer.BufferSize is zero.
+		BufferedFileSink::Options FileBuffer = {
+		    .BufferSize = 16 * 1024 * 1024,
+		};
+	};
+
+	RawWriter(Params &&params, const RawVideoFormat &format);
+	// Closes the output, ignoring errors. Use Close() to get them.
+	~RawWriter();
+
+	// Writes a frame, which must have the format and size of the stream.
+	void Write(const Frame &frame);
+
+	// Flushes and closes the output. No frame can be written afterwards.
+	void Close();
+
+private:
+	struct Implementation;
+
+	std::unique_ptr<Implementation> self;
+};
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,248 @@
+#include <cpptrace/cpptrace.hpp>
+#include <filesystem>
+#include <fort/video/Frame.hpp>
+#include <fort/video/RawVideo.hpp>
+#include <fort/video/Reader.hpp>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+#include <unistd.h>
+
+extern "C" {
+#include <libavutil/log.h>
+}
+
+namespace fort {
+namespace video {
+
+class RawVideoTest : public ::testing::Test {
+protected:
+	static std::filesystem::path TempDir;
+
+	static void SetUpTestSuite() {
+		std::string tmpDirTemplate = std::filesystem::temp_directory_path() /
+		                             "fort-video-raw-tests-XXXXXX";
+		TempDir = mkdtemp(const_cast<char *>(tmpDirTemplate.c_str()));
+		av_log_set_level(AV_LOG_QUIET);
+	}
+
+	static void TearDownTestSuite() {
+		std::filesystem::remove_all(TempDir);
+	}
+
+	// Fills the visible part of each plane, padding is left untouched.
+	static void Fill(Frame &frame, std::mt19937 &rng) {
+		const int rows[3] = {
+		    frame.Size.Height,
+		    (frame.Size.Height + 1) / 2,
+		    (frame.Size.Height + 1) / 2,
+		};
+		const int cols[3] = {
+		    frame.Size.Width,
+		    (frame.Size.Width + 1) / 2,
+		    (frame.Size.Width + 1) / 2,
+		};
+		const int planes = frame.Format == AV_PIX_FMT_YUV420P ? 3 : 1;
+		for (int p = 0; p < planes; ++p) {
+			for (int y = 0; y < rows[p]; ++y) {
+				for (int x = 0; x < cols[p]; ++x) {
+					frame.Planes[p][y * frame.Linesize[p] + x] = rng();
+				}
+			}
+		}
+	}
+
+	static void ExpectSamePlanes(const Frame &a, const Frame &b) {
+		const int rows[3] = {a.Size.Height, (a.Size.Height + 1) / 2};
+		const int cols[3] = {a.Size.Width, (a.Size.Width + 1) / 2};
+		const int planes  = a.Format == AV_PIX_FMT_YUV420P ? 3 : 1;
+		for (int p = 0; p < planes; ++p) {
+			const int r = rows[p > 0], c = cols[p > 0];
+			for (int y = 0; y < r; ++y) {
+				ASSERT_EQ(
+				    0,
+				    memcmp(
+				        a.Planes[p] + y * a.Linesize[p],
+				        b.Planes[p] + y * b.Linesize[p],
+				        c
+				    )
+				) << "plane " << p << " row " << y;
+			}
+		}
+	}
+};
+
+std::filesystem::path RawVideoTest::TempDir;
+
+TEST_F(RawVideoTest, Y4MRoundTrip) {
+	constexpr int        LENGTH = 10;
+	const RawVideoFormat format{
+	    .Size      = {41, 31},
+	    .Format    = AV_PIX_FMT_YUV420P,
+	    .Framerate = {30000, 1001},
+	};
+	auto path = TempDir / "roundtrip.y4m";
+
+	std::mt19937                        rng{42};
+	std::vector<std::unique_ptr<Frame>> frames;
+	{
+		RawWriter w{{.Path = path}, format};
+		for (int i = 0; i < LENGTH; ++i) {
+			frames.push_back(std::make_unique<Frame>(41, 31, format.Format));
+			Fill(*frames.back(), rng);
+			w.Write(*frames.back());
+		}
+		EXPECT_NO_THROW(w.Close());
+		EXPECT_THROW(w.Write(*frames.back()), cpptrace::logic_error);
+	}
+
+	const size_t frameSize = 41 * 31 + 2 * 21 * 16;
+	const size_t header =
+	    std::string{"YUV4MPEG2 W41 H31 F30000:1001 Ip A1:1 C420jpeg\n"}.size();
+	EXPECT_EQ(
+	    std::filesystem::file_size(path),
+	    header + LENGTH * (6 + frameSize)
+	);
+
+	RawReader r{path};
+	EXPECT_EQ(r.Size(), format.Size);
+	EXPECT_EQ(r.VideoFormat().Format, AV_PIX_FMT_YUV420P);
+	EXPECT_EQ(r.VideoFormat().Framerate.Num, 30000);
+	EXPECT_EQ(r.VideoFormat().Framerate.Den, 1001);
+	ASSERT_EQ(r.Length(), LENGTH);
+
+	auto frame = r.CreateFrame(64);
+	for (int i = 0; i < LENGTH; ++i) {
+		ASSERT_TRUE(r.Read(*frame));
+		EXPECT_EQ(frame->Index, i);
+		EXPECT_EQ(frame->PTS.count(), i * 1001000000000LL / 30000);
+		ExpectSamePlanes(*frame, *frames[i]);
+	}
+	EXPECT_FALSE(r.Read(*frame));
+
+	EXPECT_EQ(r.SeekFrame(3), 3);
+	ASSERT_TRUE(r.Read(*frame));
+	EXPECT_EQ(frame->Index, 3);
+	ExpectSamePlanes(*frame, *frames[3]);
+	EXPECT_EQ(r.SeekFrame(100), LENGTH);
+}
+
+TEST_F(RawVideoTest, RawVideoRoundTrip) {
+	constexpr int        LENGTH = 7;
+	const RawVideoFormat format{.Size = {40, 30}};
+	auto                 path = TempDir / "roundtrip.gray";
+
+	std::mt19937                        rng{43};
+	std::vector<std::unique_ptr<Frame>> frames;
+	{
+		RawWriter w{
+		    {.Path = path, .Y4M = false, .FileBuffer = {.BufferSize = 0}},
+		    format,
+		};
+		for (int i = 0; i < LENGTH; ++i) {
+			frames.push_back(std::make_unique<Frame>(40, 30, format.Format));
+			Fill(*frames.back(), rng);
+			w.Write(*frames.back());
+		}
+	}
+	// a truncated frame is ignored.
+	std::ofstream{path, std::ios::app} << "abc";
+	EXPECT_EQ(std::filesystem::file_size(path), LENGTH * 40 * 30 + 3);
+
+	RawReader r{path, format};
+	ASSERT_EQ(r.Length(), LENGTH);
+	Frame frame{40, 30, AV_PIX_FMT_GRAY8};
+	r.SeekFrame(LENGTH - 2);
+	for (int i = LENGTH - 2; i < LENGTH; ++i) {
+		ASSERT_TRUE(r.Read(frame));
+		EXPECT_EQ(frame.Index, i);
+		ExpectSamePlanes(frame, *frames[i]);
+	}
+	EXPECT_FALSE(r.Read(frame));
+}
+
+TEST_F(RawVideoTest, ReadsY4MFrameParameters) {
+	auto path = TempDir / "parameters.y4m";
+	{
+		std::ofstream file{path, std::ios::binary};
+		file << "YUV4MPEG2 W4 H2 F24:1 It A1:1 Cmono XYSCSS=MONO\n"
+		     << "FRAME Ip Xextension\n"
+		     << "01234567"
+		     << "FRAME\n"
+		     << "abcdefgh"
+		     << "FRAME\n"
+		     << "xyz";
+	}
+
+	RawReader r{path};
+	EXPECT_EQ(r.VideoFormat().Format, AV_PIX_FMT_GRAY8);
+	EXPECT_EQ(r.Size(), (Resolution{4, 2}));
+	ASSERT_EQ(r.Length(), 2);
+
+	Frame frame{4, 2, AV_PIX_FMT_GRAY8, 1};
+	auto  data = [&frame]() {
+		return std::string(reinterpret_cast<char *>(frame.Planes[0]), 8);
+	};
+	ASSERT_TRUE(r.Read(frame));
+	EXPECT_EQ(data(), "01234567");
+	ASSERT_TRUE(r.Read(frame));
+	EXPECT_EQ(data(), "abcdefgh");
+	EXPECT_FALSE(r.Read(frame));
+}
+
+TEST_F(RawVideoTest, ChecksFormats) {
+	auto path = TempDir / "invalid.y4m";
+	std::ofstream{path} << "not a y4m file\n";
+	EXPECT_THROW(RawReader{path}, cpptrace::runtime_error);
+
+	std::ofstream{path} << "YUV4MPEG2 W4 H2 C411\n";
+	EXPECT_THROW(RawReader{path}, cpptrace::runtime_error);
+
+	const RawVideoFormat rgb{.Size = {4, 2}, .Format = AV_PIX_FMT_RGB24};
+	EXPECT_THROW((RawWriter{{.Path = path}, rgb}), cpptrace::invalid_argument);
+	EXPECT_NO_THROW((RawWriter{{.Path = path, .Y4M = false}, rgb}));
+
+	RawWriter{{.Path = path}, {.Size = {4, 2}}};
+	RawReader r{path};
+	EXPECT_EQ(r.Length(), 0);
+	Frame frame{4, 4, AV_PIX_FMT_GRAY8};
+	EXPECT_THROW(r.Read(frame), std::invalid_argument);
+}
+
+TEST_F(RawVideoTest, Y4MIsReadableByReader) {
+	auto path = TempDir / "interop.y4m";
+
+	std::mt19937                        rng{44};
+	std::vector<std::unique_ptr<Frame>> frames;
+	{
+		RawWriter w{
+		    {.Path = path},
+		    {
+		        .Size      = {40, 30},
+		        .Format    = AV_PIX_FMT_YUV420P,
+		        .Framerate = {24, 1},
+		    },
+		};
+		for (int i = 0; i < 5; ++i) {
+			frames.push_back(
+			    std::make_unique<Frame>(40, 30, AV_PIX_FMT_YUV420P)
+			);
+			Fill(*frames.back(), rng);
+			w.Write(*frames.back());
+		}
+	}
+
+	Reader r{path, AV_PIX_FMT_YUV420P};
+	EXPECT_EQ(r.Size(), (Resolution{40, 30}));
+	auto frame = r.CreateFrame();
+	for (int i = 0; i < 5; ++i) {
+		ASSERT_TRUE(r.Read(*frame));
+		ExpectSamePlanes(*frame, *frames[i]);
+	}
+	EXPECT_FALSE(r.Read(*frame));
+}
+
+} // namespace video
+} // namespace fort
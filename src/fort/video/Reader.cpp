@@ -8,6 +8,7 @@ extern "C" {
 #include <libavformat/avformat.h>
 #include <libavutil/avutil.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 #include <libswscale/swscale.h>
 }
 
@@ -21,10 +22,14 @@ extern "C" {
 #include <fort/utils/ObjectPool.hpp>
 
 #include "Frame.hpp"
+#include "Ops.hpp"
+#include "StaticScene.hpp"
 #include "Types.hpp"
 #include "TypesIO.hpp"
 #include "details/AVCall.hpp"
 #include "details/AVTypes.hpp"
+#include "details/Scale.hpp"
+#include "details/ScaleContextCache.hpp"
 
 namespace fort {
 namespace video {
@@ -49,7 +54,7 @@ struct Reader::Implementation {
 	details::AVPacketPtr d_packet = details::AVPacketPtr{av_packet_alloc()};
 	details::AVFramePtr  d_frame  = details::AVFramePtr{av_frame_alloc()};
 
-	details::SwsContextPtr d_scaleContext;
+	details::ScaleContextCache::ContextPtr d_scaleContext;
 
 	PixelFormat          d_format = AV_PIX_FMT_GRAY8;
 	Resolution           d_size;
@@ -57,10 +62,19 @@ struct Reader::Implementation {
 	size_t d_next   = 0;
 	bool   d_queued = false;
 
+	using PacketPool =
+	    utils::ObjectPool<AVPacket, AVPacket *(*)(), void (*)(AVPacket *)>;
+
+	PacketPool::Ptr d_packets =
+	    PacketPool::Create(av_packet_alloc, [](AVPacket *pkt) {
+		    av_packet_free(&pkt);
+	    });
+
 	Implementation(
 	    const std::filesystem::path &path,
 	    PixelFormat                  format,
-	    std::tuple<int, int>         targetSize
+	    std::tuple<int, int>         targetSize,
+	    const ScaleOptions          &scale
 	)
 	    : d_context{open(path), [](AVFormatContext *c) {
 		                if (c) {
@@ -107,18 +121,15 @@ struct Reader::Implementation {
 		d_size = {outputWidth, outputHeight};
 		if (d_codec->width != outputWidth || d_codec->height != outputHeight ||
 		    d_codec->pix_fmt != format) {
-			d_scaleContext = SwsContextPtr{sws_getContext(
-			    d_codec->width,
-			    d_codec->height,
+			const Resolution decoded{d_codec->width, d_codec->height};
+			d_scaleContext = ScaleContextCache::Default().Get(
+			    decoded,
 			    d_codec->pix_fmt,
-			    outputWidth,
-			    outputHeight,
+			    d_size,
 			    d_format,
-			    SWS_BILINEAR,
-			    nullptr,
-			    nullptr,
-			    nullptr
-			)};
+			    ScaleFlags(scale),
+			    ScaleThreads(decoded, d_size)
+			);
 		}
 	}
 
@@ -170,7 +181,7 @@ struct Reader::Implementation {
 		return true;
 	}
 
-	bool Receive(Frame &frame) {
+	bool Receive(Frame &frame, Pyramid *pyramid = nullptr) {
 		if (d_queued == false) {
 			return false;
 		}
@@ -185,33 +196,153 @@ struct Reader::Implementation {
 			    std::to_string(frame.Size)};
 		}
 
+		if (pyramid != nullptr) {
+			convert(frame, *pyramid);
+		} else if (d_scaleContext) {
+			details::Scale(d_scaleContext.get(), Decoded(), frame);
+		} else {
+			convert(frame, 0, d_codec->height);
+		}
+		frame.PTS   = FramePTS(*d_frame);
+		frame.Index = FrameIndex(*d_frame);
+		d_next      = frame.Index + 1;
+		return true;
+	}
+
+	// Converts by bands of decoded rows, and builds pyramid from each
+	// converted band while it is still in cache.
+	void convert(Frame &frame, Pyramid &pyramid) {
+		constexpr static int BAND_HEIGHT = 64;
+		if (pyramid.BaseSize() != d_size || !ops::HasLumaPlane(d_format)) {
+			throw cpptrace::invalid_argument{
+			    "cannot build a pyramid of " +
+			    std::to_string(pyramid.BaseSize()) + " from " +
+			    std::to_string(d_format) + " " + std::to_string(d_size) +
+			    " frames",
+			};
+		}
+		pyramid.Reset();
+		int rows = 0;
+		for (int y = 0; y < d_codec->height; y += BAND_HEIGHT) {
+			const int height = std::min(BAND_HEIGHT, d_codec->height - y);
+			rows += convert(frame, y, height);
+			pyramid.Update(frame, rows);
+		}
+	}
+
+	// Converts the decoded rows [y, y + height) to frame, and returns the
+	// number of frame rows it produced. Bands must be converted in order.
+	int convert(Frame &frame, int y, int height) {
+		const uint8_t *src[4];
+		slice(src, d_frame->data, d_frame->linesize, d_codec->pix_fmt, y);
 		if (d_scaleContext) {
-			details::AVCall(
+			return details::AVCall(
 			    sws_scale,
 			    d_scaleContext.get(),
-			    d_frame->data,
+			    src,
 			    d_frame->linesize,
-			    0,
-			    d_codec->height,
+			    y,
+			    height,
 			    frame.Planes,
 			    frame.Linesize
 			);
+		}
 
-		} else {
-			av_image_copy(
-			    frame.Planes,
-			    frame.Linesize,
-			    const_cast<const uint8_t **>(d_frame->data),
-			    d_frame->linesize,
-			    d_format,
-			    d_codec->width,
-			    d_codec->height
-			);
+		uint8_t *dst[4];
+		slice(
+		    const_cast<const uint8_t **>(dst),
+		    frame.Planes,
+		    frame.Linesize,
+		    d_format,
+		    y
+		);
+		av_image_copy(
+		    dst,
+		    frame.Linesize,
+		    src,
+		    d_frame->linesize,
+		    d_format,
+		    d_codec->width,
+		    height
+		);
+		return height;
+	}
+
+	// Offsets planes to row y of an image in format.
+	static void slice(
+	    const uint8_t *res[4],
+	    uint8_t *const planes[4],
+	    const int      linesize[4],
+	    PixelFormat    format,
+	    int            y
+	) {
+		const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+		for (int i = 0; i < 4; ++i) {
+			const bool chroma = i == 1 || i == 2;
+			if (planes[i] == nullptr || desc == nullptr ||
+			    (i == 1 && (desc->flags & AV_PIX_FMT_FLAG_PAL) != 0)) {
+				res[i] = planes[i];
+				continue;
+			}
+			const int shift = chroma ? desc->log2_chroma_h : 0;
+			res[i]          = planes[i] + (y >> shift) * linesize[i];
+		}
+	}
+
+	// Returns a view of the decoded frame.
+	Frame Decoded() const {
+		return Frame::View(
+		    {d_frame->width, d_frame->height},
+		    AVPixelFormat(d_frame->format),
+		    d_frame->data,
+		    d_frame->linesize
+		);
+	}
+
+	// Filters the decoded frame before its conversion, and skips it if it
+	// is static. Its format must be supported by filter.
+	bool Filter(StaticSceneFilter &filter) {
+		if (filter.Accept(Decoded())) {
+			return true;
+		}
+		d_next   = FrameIndex(*d_frame) + 1;
+		d_queued = false;
+		av_frame_unref(d_frame.get());
+		return false;
+	}
+
+	PacketPool::ObjectPtr ReadPacket() {
+		auto pkt = d_packets->Get(av_packet_unref);
+		while (true) {
+			int error = av_read_frame(d_context.get(), pkt.get());
+			if (error == AVERROR_EOF) {
+				return nullptr;
+			} else if (error < 0) {
+				throw details::AVError(error, av_read_frame);
+			}
+			if (pkt->stream_index == d_index) {
+				return pkt;
+			}
+			av_packet_unref(pkt.get());
+		}
+	}
+
+	void SeekPacket(int64_t pts) {
+		details::AVCall(
+		    av_seek_frame,
+		    d_context.get(),
+		    d_index,
+		    pts,
+		    AVSEEK_FLAG_BACKWARD
+		);
+		avcodec_flush_buffers(d_codec.get());
+		if (d_queued) {
+			av_frame_unref(d_frame.get());
+			d_queued = false;
+		}
+		if (!d_packet) {
+			d_packet = details::AVPacketPtr{av_packet_alloc()};
 		}
-		frame.PTS   = FramePTS(*d_frame);
-		frame.Index = FrameIndex(*d_frame);
-		d_next      = frame.Index + 1;
-		return true;
 	}
 
 	AVStream *Stream() const noexcept {
@@ -289,9 +420,11 @@ struct Reader::Implementation {
 Reader::Reader(
     const std::filesystem::path &path,
     PixelFormat                  format,
-    std::tuple<int, int>         targetSize
+    std::tuple<int, int>         targetSize,
+    const ScaleOptions          &scale
 )
-    : self{std::make_unique<Implementation>(path, format, targetSize)} {}
+    : self{std::make_unique<Implementation>(path, format, targetSize, scale)} {
+}
 
 Reader::~Reader() = default;
 
@@ -336,6 +469,28 @@ bool Reader::Read(Frame &frame) {
 	return Receive(frame);
 }
 
+bool Reader::Read(Frame &frame, Pyramid &pyramid) {
+	if (!self->d_queued && !Grab()) {
+		return false;
+	}
+	return self->Receive(frame, &pyramid);
+}
+
+bool Reader::Read(Frame &frame, StaticSceneFilter &filter) {
+	while (self->d_queued || Grab()) {
+		const auto decoded = AVPixelFormat(self->d_frame->format);
+		if (StaticSceneFilter::Supports(decoded)) {
+			// skips static frames before their conversion.
+			if (self->Filter(filter)) {
+				return Receive(frame);
+			}
+		} else if (Receive(frame) && filter.Accept(frame)) {
+			return true;
+		}
+	}
+	return false;
+}
+
 bool Reader::Grab() {
 	return self->Grab();
 }
@@ -390,5 +545,32 @@ std::unique_ptr<video::Frame> Reader::CreateFrame(int alignement) const {
 	    alignement
 	);
 }
+
+FramePool::FramePtr
+Reader::CreateFrame(FramePool &pool, int alignement) const {
+	return pool.Get(self->d_size, self->d_format, alignement);
+}
+
+const AVCodecParameters *Reader::CodecParameters() const noexcept {
+	return self->Stream()->codecpar;
+}
+
+AVRational Reader::TimeBase() const noexcept {
+	return self->Stream()->time_base;
+}
+
+std::unique_ptr<AVPacket, std::function<void(AVPacket *)>>
+Reader::ReadPacket() {
+	return self->ReadPacket();
+}
+
+void Reader::SeekPacket(video::Duration time) {
+	self->SeekPacket(av_rescale_q(
+	    time.count(),
+	    {1, int64_t(1e9)},
+	    self->Stream()->time_base
+	));
+}
+
 } // namespace video
 } // namespace fort
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Frame.hpp"
+#include "FramePool.hpp"
+#include "Pyramid.hpp"
+#include "StaticScene.hpp"
 #include "Types.hpp"
 #include <filesystem>
 #include <functional>
@@ -11,10 +14,13 @@ namespace video {
 
 class Reader {
 public:
+	// Frames are converted to format and targetSize if they differ from
+	// the decoded ones, with the scale options.
 	Reader(
 	    const std::filesystem::path &path,
 	    PixelFormat                     = AV_PIX_FMT_GRAY8,
-	    std::tuple<int, int> targetSize = {-1, -1}
+	    std::tuple<int, int> targetSize = {-1, -1},
+	    const ScaleOptions  &scale      = {}
 	);
 
 	~Reader();
@@ -39,8 +45,40 @@ public:
 
 	bool Read(Frame &frame);
 
+	// Reads the next frame, and builds pyramid from its luma plane during
+	// the conversion: the frame is converted by bands of rows, each pushed
+	// through the pyramid levels while in cache. pyramid base size must be
+	// Size(), and the format must have a luma plane.
+	bool Read(Frame &frame, Pyramid &pyramid);
+
+	// Reads the next frame accepted by filter, static frames are decoded
+	// but skipped. When the decoded format has a luma plane, frames are
+	// filtered before their conversion, which is only done for accepted
+	// ones. Returns false at the end of the stream.
+	bool Read(Frame &frame, StaticSceneFilter &filter);
+
 	std::unique_ptr<video::Frame> CreateFrame(int alignement = 32) const;
 
+	// Returns a frame for Read() recycled from pool.
+	FramePool::FramePtr CreateFrame(FramePool &pool, int alignement = 32) const;
+
+	// Packet level access, for stream copy without decoding. Packets are not
+	// sent to the decoder, so it should not be mixed with Grab()/Read().
+
+	// Parameters of the compressed video stream.
+	const AVCodecParameters *CodecParameters() const noexcept;
+
+	// Time base of the packets timestamps.
+	AVRational TimeBase() const noexcept;
+
+	// Reads the next compressed packet of the video stream, or nullptr at the
+	// end of the file.
+	std::unique_ptr<AVPacket, std::function<void(AVPacket *)>> ReadPacket();
+
+	// Positions the stream on the last key frame at or before time, such that
+	// the next ReadPacket() returns it.
+	void SeekPacket(video::Duration time);
+
 private:
 	struct Implementation;
 
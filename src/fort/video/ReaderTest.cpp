@@ -1,6 +1,8 @@
 #include "fort/video/Reader.hpp"
 #include <gtest/gtest.h>
 
+#include <cpptrace/cpptrace.hpp>
+
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
@@ -175,5 +177,94 @@ TEST_F(ReaderTest, CanReadOneEveryTwo) {
 	}
 }
 
+TEST_F(ReaderTest, CanBuildPyramidsWhileReading) {
+	for (auto format : {AV_PIX_FMT_GRAY8, AV_PIX_FMT_YUV420P}) {
+		SCOPED_TRACE(av_get_pix_fmt_name(format));
+		Reader  r{TempDir / "video.mp4", format};
+		Pyramid pyramid{r.Size(), {.Levels = 2}};
+		Pyramid expected{r.Size(), {.Levels = 2}};
+
+		auto frame = r.CreateFrame();
+		for (size_t i = 0; i < 10; ++i) {
+			ASSERT_TRUE(r.Read(*frame, pyramid));
+			EXPECT_EQ(frame->Index, i);
+			EXPECT_TRUE(pyramid.Complete());
+			expected.Build(*frame);
+			for (size_t l = 0; l < pyramid.Size(); ++l) {
+				const auto &a = pyramid[l], &b = expected[l];
+				for (int y = 0; y < a.Size.Height; ++y) {
+					ASSERT_EQ(
+					    0,
+					    memcmp(
+					        a.Planes[0] + y * a.Linesize[0],
+					        b.Planes[0] + y * b.Linesize[0],
+					        a.Size.Width
+					    )
+					) << "level " << l << " row " << y;
+				}
+			}
+		}
+	}
+
+	Reader  r{TempDir / "video.mp4", AV_PIX_FMT_RGB24};
+	Pyramid pyramid{r.Size(), {.Levels = 2}};
+	auto    frame = r.CreateFrame();
+	EXPECT_THROW(r.Read(*frame, pyramid), cpptrace::invalid_argument);
+}
+
+TEST_F(ReaderTest, CanSkipStaticFrames) {
+	Reader            r{TempDir / "video.mp4"};
+	StaticSceneFilter filter{{.Threshold = 2.5}};
+
+	auto   frame = r.CreateFrame();
+	size_t count = 0;
+	int    last  = -10;
+	while (r.Read(*frame, filter)) {
+		SCOPED_TRACE(std::to_string(frame->Index));
+		// frames brighten by one every frame.
+		EXPECT_GE(int(frame->Planes[0][0]) - last, 2);
+		last = frame->Planes[0][0];
+		++count;
+	}
+	EXPECT_EQ(r.Position(), LENGTH);
+	EXPECT_LT(count, LENGTH / 2);
+	EXPECT_EQ(filter.GetStats().Frames, LENGTH);
+	EXPECT_EQ(filter.GetStats().Skipped, LENGTH - count);
+}
+
+TEST_F(ReaderTest, CanChooseScaleAlgorithm) {
+	Reader reference{TempDir / "video.mp4", AV_PIX_FMT_GRAY8, {20, 15}};
+	auto   expected = reference.CreateFrame();
+	ASSERT_TRUE(reference.Read(*expected));
+
+	for (auto algorithm :
+	     {ScaleAlgorithm::Point,
+	      ScaleAlgorithm::FastBilinear,
+	      ScaleAlgorithm::Area,
+	      ScaleAlgorithm::Bicubic,
+	      ScaleAlgorithm::Lanczos}) {
+		SCOPED_TRACE(int(algorithm));
+		Reader r{
+		    TempDir / "video.mp4",
+		    AV_PIX_FMT_GRAY8,
+		    {20, 15},
+		    {.Algorithm = algorithm, .AccurateRounding = true},
+		};
+		auto frame = r.CreateFrame();
+		ASSERT_TRUE(r.Read(*frame));
+		ASSERT_EQ(frame->Size, (Resolution{20, 15}));
+		// frames are uniform, all algorithms agree up to rounding.
+		for (int y = 0; y < 15; ++y) {
+			for (int x = 0; x < 20; ++x) {
+				ASSERT_NEAR(
+				    frame->Planes[0][y * frame->Linesize[0] + x],
+				    expected->Planes[0][y * expected->Linesize[0] + x],
+				    2
+				) << "x: " << x << " y: " << y;
+			}
+		}
+	}
+}
+
 } // namespace video
 } // namespace fort
@@ -0,0 +1,149 @@
+#include "Remux.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+#include <cpptrace/cpptrace.hpp>
+
+#include "Reader.hpp"
+#include "TypesIO.hpp"
+#include "details/AVCall.hpp"
+
+#include <fort/utils/Defer.hpp>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/mathematics.h>
+}
+
+namespace fort {
+namespace video {
+
+namespace details {
+static std::string describe(const AVCodecParameters *par) {
+	return "{codec: " + std::to_string(par->codec_id) +
+	       ", size: " + std::to_string(Resolution{par->width, par->height}) +
+	       ", format: " + std::to_string(PixelFormat(par->format)) +
+	       ", profile: " + std::to_string(par->profile) +
+	       ", extradata: " + std::to_string(par->extradata_size) + " bytes}";
+}
+
+void CheckCompatible(
+    const AVCodecParameters     *expected,
+    const AVCodecParameters     *actual,
+    const std::filesystem::path &path
+) {
+	// the output only carries the first clip's extradata (SPS/PPS for
+	// H264), which must decode every clip.
+	if (expected->codec_id != actual->codec_id ||
+	    expected->width != actual->width ||
+	    expected->height != actual->height ||
+	    expected->format != actual->format ||
+	    expected->profile != actual->profile ||
+	    expected->extradata_size != actual->extradata_size ||
+	    (expected->extradata_size > 0 &&
+	     std::memcmp(
+	         expected->extradata,
+	         actual->extradata,
+	         expected->extradata_size
+	     ) != 0)) {
+		throw cpptrace::invalid_argument{
+		    "cannot concatenate " + path.string() + ": stream " +
+		    describe(actual) + " differs from " + describe(expected),
+		};
+	}
+}
+} // namespace details
+
+void Remux(Writer::Params &&output, const std::vector<Clip> &clips) {
+	std::unique_ptr<Writer> writer;
+	AVCodecParameters      *codecpar = avcodec_parameters_alloc();
+	AVRational              timeBase;
+	// end of the last written clip and last written dts, in timeBase.
+	int64_t offset = 0, lastDTS = AV_NOPTS_VALUE;
+
+	defer {
+		avcodec_parameters_free(&codecpar);
+	};
+
+	for (const auto &clip : clips) {
+		Reader reader{clip.Path};
+		if (!writer) {
+			details::AVCall(
+			    avcodec_parameters_copy,
+			    codecpar,
+			    reader.CodecParameters()
+			);
+			timeBase = reader.TimeBase();
+			writer =
+			    std::make_unique<Writer>(std::move(output), codecpar, timeBase);
+		} else {
+			details::CheckCompatible(
+			    codecpar,
+			    reader.CodecParameters(),
+			    clip.Path
+			);
+		}
+
+		if (clip.Start > video::Duration{0}) {
+			reader.SeekPacket(clip.Start);
+		}
+
+		const int64_t end =
+		    clip.End == video::Duration::max()
+		        ? std::numeric_limits<int64_t>::max()
+		        : av_rescale_q(clip.End.count(), {1, int(1e9)}, timeBase);
+		const int64_t frameDuration = av_rescale_q(
+		    reader.AverageFrameDuration().count(),
+		    {1, int(1e9)},
+		    timeBase
+		);
+
+		int64_t shift = AV_NOPTS_VALUE, clipEnd = offset;
+		while (auto pkt = reader.ReadPacket()) {
+			if (pkt->pts == AV_NOPTS_VALUE || pkt->dts == AV_NOPTS_VALUE) {
+				// they cannot be shifted to follow the previous clip.
+				throw cpptrace::invalid_argument{
+				    "cannot remux " + clip.Path.string() +
+				    ": packet without timestamps",
+				};
+			}
+			av_packet_rescale_ts(pkt.get(), reader.TimeBase(), timeBase);
+			bool keyFrame = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+			if (shift == AV_NOPTS_VALUE) {
+				if (keyFrame == false) {
+					// seeking may land on non-key packets before the key one.
+					continue;
+				}
+				// the first presented frame starts at offset, but decoding
+				// timestamps must stay monotonic.
+				shift = offset - pkt->pts;
+				if (lastDTS != AV_NOPTS_VALUE) {
+					shift = std::max(shift, lastDTS + 1 - pkt->dts);
+				}
+			}
+
+			if (keyFrame && pkt->pts >= end) {
+				break;
+			}
+
+			pkt->pts += shift;
+			pkt->dts += shift;
+			lastDTS = pkt->dts;
+			clipEnd = std::max(
+			    clipEnd,
+			    pkt->pts + (pkt->duration > 0 ? pkt->duration : frameDuration)
+			);
+			writer->Write(pkt.get());
+		}
+		offset = clipEnd;
+	}
+	if (writer) {
+		writer->Close();
+	}
+}
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "Types.hpp"
+#include "Writer.hpp"
+
+namespace fort {
+namespace video {
+
+// A part of a video file to copy.
+struct Clip {
+	std::filesystem::path Path;
+	// Start is rounded down to the last key frame at or before it.
+	video::Duration Start = video::Duration{0};
+	// The clip ends just before the first key frame at or after End.
+	video::Duration End = video::Duration::max();
+};
+
+// Copies and concatenates clips in a single output file, without decoding nor
+// re-encoding. Timestamps are made continuous across clips. All clips must
+// share the same codec, resolution, pixel format, profile and codec
+// extradata, otherwise it throws cpptrace::invalid_argument.
+void Remux(Writer::Params &&output, const std::vector<Clip> &clips);
+
+} // namespace video
+} // namespace fort
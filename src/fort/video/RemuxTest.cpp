@@ -0,0 +1,146 @@
+#include <cpptrace/cpptrace.hpp>
+#include <filesystem>
+#include <fort/video/Frame.hpp>
+#include <fort/video/Reader.hpp>
+#include <fort/video/Remux.hpp>
+#include <fort/video/Writer.hpp>
+#include <gtest/gtest.h>
+#include <string>
+
+extern "C" {
+#include <libavutil/log.h>
+}
+
+namespace fort {
+namespace video {
+
+class RemuxTest : public ::testing::Test {
+protected:
+	static std::filesystem::path TempDir;
+	constexpr static int         LENGTH = 255;
+	// Encoder::Params default to a key frame every 60 frames.
+	constexpr static int         KEYINT = 60;
+
+	static void SetUpTestSuite() {
+		std::string tmpDirTemplate = std::filesystem::temp_directory_path() /
+		                             "fort-video-remux-tests-XXXXXX";
+		TempDir = mkdtemp(const_cast<char *>(tmpDirTemplate.c_str()));
+		av_log_set_level(AV_LOG_QUIET);
+
+		Writer w{
+		    Writer::Params{.Path = TempDir / "video.mp4"},
+		    Encoder::Params{
+		        .Size{40, 30},
+		        .Framerate = {24, 1},
+		        .Format    = AV_PIX_FMT_GRAY8,
+		    }};
+
+		Frame frame{40, 30, AV_PIX_FMT_GRAY8, 16};
+		for (int i = 0; i < LENGTH; i++) {
+			memset(frame.Planes[0], i, 40 * 30);
+			w.Write(frame);
+		}
+
+		// same codec and size, but another pixel format.
+		Writer yuv{
+		    Writer::Params{.Path = TempDir / "yuv.mp4"},
+		    Encoder::Params{
+		        .Size{40, 30},
+		        .Framerate = {24, 1},
+		        .Format    = AV_PIX_FMT_YUV420P,
+		    }};
+		for (int i = 0; i < KEYINT; i++) {
+			yuv.Write(frame);
+		}
+	}
+
+	static void TearDownTestSuite() {
+		std::filesystem::remove_all(TempDir);
+	}
+
+	static Duration FrameTime(int index) {
+		return Duration{int64_t(index * 1e9) / 24};
+	}
+
+	static void ExpectFrames(
+	    const std::filesystem::path &path, const std::vector<int> &expected
+	) {
+		Reader r{path};
+		EXPECT_EQ(r.Length(), expected.size());
+		auto f = r.CreateFrame();
+		for (size_t i = 0; i < expected.size(); ++i) {
+			SCOPED_TRACE("frame " + std::to_string(i));
+			ASSERT_TRUE(r.Read(*f));
+			EXPECT_EQ(f->Index, i);
+			EXPECT_NEAR(f->Planes[0][0], expected[i], 1);
+		}
+		EXPECT_FALSE(r.Read(*f));
+	}
+
+	static std::vector<int> Range(int start, int end) {
+		std::vector<int> res;
+		for (int i = start; i < end; ++i) {
+			res.push_back(i);
+		}
+		return res;
+	}
+};
+
+std::filesystem::path RemuxTest::TempDir;
+
+TEST_F(RemuxTest, CopiesWholeFile) {
+	auto path = TempDir / "copy.mp4";
+	Remux({.Path = path}, {{.Path = TempDir / "video.mp4"}});
+	ExpectFrames(path, Range(0, LENGTH));
+}
+
+TEST_F(RemuxTest, TrimsOnKeyFrames) {
+	auto path = TempDir / "trim.mp4";
+	Remux(
+	    {.Path = path},
+	    {{
+	        .Path  = TempDir / "video.mp4",
+	        .Start = FrameTime(KEYINT + 12),
+	        .End   = FrameTime(2 * KEYINT),
+	    }}
+	);
+	ExpectFrames(path, Range(KEYINT, 2 * KEYINT));
+}
+
+TEST_F(RemuxTest, Concatenates) {
+	auto path = TempDir / "concat.mp4";
+	Remux(
+	    {.Path = path},
+	    {
+	        {
+	            .Path = TempDir / "video.mp4",
+	            .End  = FrameTime(KEYINT),
+	        },
+	        {
+	            .Path  = TempDir / "video.mp4",
+	            .Start = FrameTime(3 * KEYINT),
+	        },
+	    }
+	);
+	auto expected = Range(0, KEYINT);
+	for (int i = 3 * KEYINT; i < LENGTH; ++i) {
+		expected.push_back(i);
+	}
+	ExpectFrames(path, expected);
+}
+
+TEST_F(RemuxTest, RejectsIncompatibleClips) {
+	EXPECT_THROW(
+	    Remux(
+	        {.Path = TempDir / "incompatible.mp4"},
+	        {
+	            {.Path = TempDir / "video.mp4"},
+	            {.Path = TempDir / "yuv.mp4"},
+	        }
+	    ),
+	    cpptrace::invalid_argument
+	);
+}
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+
+namespace fort {
+namespace video {
+
+// Instruction sets the image kernels are specialized for, from the least to
+// the most capable.
+enum class SIMDLevel {
+	Scalar = 0,
+	SSE41  = 1,
+	AVX2   = 2,
+};
+
+// Returns the most capable level supported by the running CPU.
+inline SIMDLevel BestSIMDLevel() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+	static SIMDLevel level = []() {
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) {
+			return SIMDLevel::AVX2;
+		}
+		if (__builtin_cpu_supports("sse4.1")) {
+			return SIMDLevel::SSE41;
+		}
+		return SIMDLevel::Scalar;
+	}();
+	return level;
+#else
+	return SIMDLevel::Scalar;
+#endif
+}
+
+inline std::string to_string(SIMDLevel level) {
+	switch (level) {
+	case SIMDLevel::AVX2:
+		return "AVX2";
+	case SIMDLevel::SSE41:
+		return "SSE4.1";
+	default:
+		return "Scalar";
+	}
+}
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,165 @@
+#include "SegmentedWriter.hpp"
+
+#include <deque>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+#include <cpptrace/cpptrace.hpp>
+
+#include "details/Muxer.hpp"
+#include "details/PTSGenerator.hpp"
+
+extern "C" {
+#include <libavutil/mathematics.h>
+}
+
+namespace fort {
+namespace video {
+
+struct SegmentedWriter::Implementation {
+	Params                          d_params;
+	std::unique_ptr<Encoder>        d_encoder;
+	std::unique_ptr<details::Muxer> d_muxer;
+
+	size_t                d_segment = 0;
+	details::PTSGenerator d_pts;
+	// number of frames and first pts of the segment being sent to the
+	// encoder, which may be ahead of the one being muxed.
+	size_t  d_frames      = 0;
+	int64_t d_segmentPTS  = 0;
+	int64_t d_maxDuration = 0;
+	// pts of the forced key frames that did not come out of the encoder yet.
+	std::deque<int64_t> d_boundaries;
+	// pts of the first frame of the muxed segment, removed from the packets so
+	// each segment starts at zero.
+	int64_t d_offset = 0;
+	bool    d_closed = false;
+
+	Implementation(Params &&params, Encoder::Params &&encoderParams)
+	    : d_params{std::move(params)}
+	    , d_encoder{std::make_unique<Encoder>(std::move(encoderParams))}
+	    , d_pts{d_params.Output.UseFramePTS, timeBase()} {
+		d_maxDuration = av_rescale_q(
+		    d_params.SegmentDuration.count(),
+		    {1, int(1e9)},
+		    timeBase()
+		);
+		d_muxer = openSegment();
+	}
+
+	~Implementation() {
+		try {
+			Close();
+		} catch (...) {
+		}
+	}
+
+	void Close() {
+		if (std::exchange(d_closed, true)) {
+			return;
+		}
+		if (d_muxer->Failed() == false) {
+			d_encoder->Flush();
+			drain();
+		}
+		d_muxer->Close();
+	}
+
+	AVRational timeBase() const {
+		return d_encoder->CodecContext()->time_base;
+	}
+
+	std::unique_ptr<details::Muxer> openSegment() {
+		auto params = d_params.Output;
+		params.Path = SegmentPath(d_params.Output.Path, d_segment);
+		return std::make_unique<details::Muxer>(
+		    params,
+		    d_encoder->CodecContext()
+		);
+	}
+
+	bool boundaryReached(int64_t pts) const noexcept {
+		return (d_params.SegmentFrames > 0 &&
+		        d_frames >= d_params.SegmentFrames) ||
+		       (d_maxDuration > 0 && pts - d_segmentPTS >= d_maxDuration);
+	}
+
+	void Write(const Frame &frame) {
+		if (d_closed) {
+			throw cpptrace::logic_error{"writer is closed"};
+		}
+		int64_t pts      = d_pts(frame);
+		bool    keyFrame = false;
+		if (boundaryReached(pts)) {
+			keyFrame     = true;
+			d_frames     = 0;
+			d_segmentPTS = pts;
+			d_boundaries.push_back(pts);
+		}
+		++d_frames;
+		d_encoder->Send(frame, pts, keyFrame);
+		drain();
+	}
+
+	void drain() {
+		while (true) {
+			auto pkt = d_encoder->Receive();
+			if (!pkt) {
+				break;
+			}
+			write(pkt.get());
+		}
+	}
+
+	void write(AVPacket *pkt) {
+		// The forced key frame is the first packet in decoding order of the
+		// new segment, all the packets before it belong to the previous one.
+		if (d_boundaries.empty() == false &&
+		    (pkt->flags & AV_PKT_FLAG_KEY) != 0 &&
+		    pkt->pts >= d_boundaries.front()) {
+			d_boundaries.pop_front();
+			// reports the errors of the end of the segment.
+			d_muxer->Close();
+			d_muxer.reset();
+			++d_segment;
+			d_muxer  = openSegment();
+			d_offset = pkt->pts;
+		}
+		pkt->pts -= d_offset;
+		pkt->dts -= d_offset;
+		d_muxer->Write(pkt, timeBase());
+	}
+};
+
+SegmentedWriter::SegmentedWriter(
+    Params &&params, Encoder::Params &&encoderParams
+)
+    : self{std::make_unique<Implementation>(
+          std::move(params), std::move(encoderParams)
+      )} {}
+
+SegmentedWriter::~SegmentedWriter() = default;
+
+void SegmentedWriter::Write(const Frame &frame) {
+	self->Write(frame);
+}
+
+void SegmentedWriter::Close() {
+	self->Close();
+}
+
+size_t SegmentedWriter::Segment() const noexcept {
+	return self->d_segment;
+}
+
+std::filesystem::path
+SegmentedWriter::SegmentPath(const std::filesystem::path &path, size_t index) {
+	std::ostringstream filename;
+	filename << path.stem().string() << "." << std::setw(4)
+	         << std::setfill('0') << index << path.extension().string();
+	return path.parent_path() / filename.str();
+}
+
+} // namespace video
+} // namespace fort
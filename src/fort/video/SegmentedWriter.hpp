@@ -0,0 +1,50 @@
+#pragma once
+
+#include <filesystem>
+
+#include "Encoder.hpp"
+#include "Frame.hpp"
+#include "Types.hpp"
+#include "Writer.hpp"
+
+namespace fort {
+namespace video {
+
+// SegmentedWriter writes a stream split in several files, rolling to a new
+// file after a given number of frames or a given duration. A key frame is
+// forced at each boundary and the same Encoder is used for all segments, so
+// no frame is lost between two segments.
+class SegmentedWriter {
+public:
+	struct Params {
+		// Output.Path is used as a template: segment i is written to
+		// <parent>/<stem>.<i>.<extension>, with i zero-padded on 4 digits.
+		Writer::Params Output;
+		// Maximal number of frames per segment, 0 for no limit.
+		size_t SegmentFrames = 0;
+		// Maximal duration of a segment, 0 for no limit.
+		Duration SegmentDuration = Duration{0};
+	};
+
+	SegmentedWriter(Params &&params, Encoder::Params &&encoderParams);
+	~SegmentedWriter();
+
+	void Write(const Frame &frame);
+
+	// Encodes the remaining frames and closes the last segment, reporting
+	// errors like Writer::Close().
+	void Close();
+
+	// Index of the segment currently written.
+	size_t Segment() const noexcept;
+
+	static std::filesystem::path
+	SegmentPath(const std::filesystem::path &path, size_t index);
+
+private:
+	struct Implementation;
+	std::unique_ptr<Implementation> self;
+};
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,97 @@
+#include <filesystem>
+#include <fort/video/Frame.hpp>
+#include <fort/video/Reader.hpp>
+#include <fort/video/SegmentedWriter.hpp>
+#include <gtest/gtest.h>
+#include <string>
+
+extern "C" {
+#include <libavutil/log.h>
+}
+
+namespace fort {
+namespace video {
+
+class SegmentedWriterTest : public ::testing::Test {
+protected:
+	static std::filesystem::path TempDir;
+
+	static void SetUpTestSuite() {
+		std::string tmpDirTemplate = std::filesystem::temp_directory_path() /
+		                             "fort-video-segmented-writer-tests-XXXXXX";
+		TempDir = mkdtemp(const_cast<char *>(tmpDirTemplate.c_str()));
+		av_log_set_level(AV_LOG_QUIET);
+	}
+
+	static void TearDownTestSuite() {
+		std::filesystem::remove_all(TempDir);
+	}
+
+	static void Encode(SegmentedWriter::Params &&params, size_t count) {
+		SegmentedWriter w{
+		    std::move(params),
+		    Encoder::Params{
+		        .Size{40, 30},
+		        .Framerate = {24, 1},
+		        .Format    = AV_PIX_FMT_GRAY8,
+		    }};
+
+		Frame frame{40, 30, AV_PIX_FMT_GRAY8, 16};
+		for (size_t i = 0; i < count; i++) {
+			memset(frame.Planes[0], i, 40 * 30);
+			w.Write(frame);
+		}
+	}
+
+	static void ExpectSegments(
+	    const std::filesystem::path &path, const std::vector<size_t> &lengths
+	) {
+		size_t first = 0;
+		for (size_t i = 0; i < lengths.size(); ++i) {
+			SCOPED_TRACE("segment " + std::to_string(i));
+			auto segmentPath = SegmentedWriter::SegmentPath(path, i);
+			ASSERT_TRUE(std::filesystem::exists(segmentPath));
+			Reader r{segmentPath};
+			EXPECT_EQ(r.Length(), lengths[i]);
+			auto f = r.CreateFrame();
+			for (size_t j = 0; j < lengths[i]; ++j) {
+				SCOPED_TRACE("frame " + std::to_string(j));
+				ASSERT_TRUE(r.Read(*f));
+				EXPECT_EQ(f->Index, j);
+				EXPECT_NEAR(f->Planes[0][0], first + j, 1);
+			}
+			EXPECT_FALSE(r.Read(*f));
+			first += lengths[i];
+		}
+		EXPECT_FALSE(std::filesystem::exists(
+		    SegmentedWriter::SegmentPath(path, lengths.size())
+		));
+	}
+};
+
+std::filesystem::path SegmentedWriterTest::TempDir;
+
+TEST_F(SegmentedWriterTest, SegmentPath) {
+	EXPECT_EQ(
+	    SegmentedWriter::SegmentPath("/foo/bar.mp4", 12),
+	    "/foo/bar.0012.mp4"
+	);
+}
+
+TEST_F(SegmentedWriterTest, SplitsOnFrameCount) {
+	auto path = TempDir / "frames.mp4";
+	Encode({.Output{.Path = path}, .SegmentFrames = 30}, 100);
+	ExpectSegments(path, {30, 30, 30, 10});
+}
+
+TEST_F(SegmentedWriterTest, SplitsOnDuration) {
+	auto path = TempDir / "duration.mp4";
+	Encode(
+	    {.Output{.Path = path}, .SegmentDuration = std::chrono::seconds(2)},
+	    100
+	);
+	ExpectSegments(path, {48, 48, 4});
+}
+
+} // namespace video
+} // namespace fort
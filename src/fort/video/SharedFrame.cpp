@@ -0,0 +1,56 @@
+#include "SharedFrame.hpp"
+
+#include <atomic>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+
+namespace fort {
+namespace video {
+
+SharedFrame SharedFrame::Copy(const Frame &frame, FramePool &pool) {
+	std::shared_ptr<Frame> res = pool.Get(frame.Size, frame.Format);
+	av_image_copy(
+	    res->Planes,
+	    res->Linesize,
+	    const_cast<const uint8_t **>(frame.Planes),
+	    frame.Linesize,
+	    frame.Format,
+	    frame.Size.Width,
+	    frame.Size.Height
+	);
+	res->Index = frame.Index;
+	res->PTS   = frame.PTS;
+	return SharedFrame{std::move(res)};
+}
+
+SharedFrame::SharedFrame(Frame &&frame)
+    : d_frame{std::make_shared<Frame>(std::move(frame))} {}
+
+SharedFrame::SharedFrame(FramePool::FramePtr &&frame)
+    : d_frame{std::move(frame)} {}
+
+SharedFrame::SharedFrame(std::shared_ptr<Frame> &&frame)
+    : d_frame{std::move(frame)} {}
+
+long SharedFrame::UseCount() const noexcept {
+	return d_frame.use_count();
+}
+
+Frame &SharedFrame::Mutable(FramePool &pool) {
+	// a count of one cannot increase concurrently, as only this handle
+	// could be copied.
+	if (d_frame.use_count() > 1) {
+		*this = Copy(*d_frame, pool);
+		return *d_frame;
+	}
+	// use_count() is a relaxed load. Another thread which just released its
+	// handle after reading the planes did it with a release decrement, this
+	// fence orders our writes after its reads.
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return *d_frame;
+}
+
+} // namespace video
+} // namespace fort
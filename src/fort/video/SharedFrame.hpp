@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+
+#include "Frame.hpp"
+#include "FramePool.hpp"
+
+namespace fort {
+namespace video {
+
+// SharedFrame is a reference counted handle on an immutable Frame. Copies
+// of the handle share the same planes, and can be passed to consumers on
+// different threads. Mutable() gives write access, copying the frame
+// first if it is shared (copy-on-write).
+class SharedFrame {
+public:
+	// Returns a shared copy of frame, allocated from pool.
+	static SharedFrame
+	Copy(const Frame &frame, FramePool &pool = *FramePool::Default());
+
+	// An empty handle.
+	SharedFrame() = default;
+	// Takes ownership of frame. A Frame::View does not own its planes,
+	// which must then outlive every handle, including the ones kept by an
+	// EncoderPool until the frame is encoded asynchronously.
+	SharedFrame(Frame &&frame);
+	// Takes ownership of a pooled frame, which returns to its pool when the
+	// last handle is released.
+	SharedFrame(FramePool::FramePtr &&frame);
+
+	const Frame &operator*() const noexcept {
+		return *d_frame;
+	}
+
+	const Frame *operator->() const noexcept {
+		return d_frame.get();
+	}
+
+	explicit operator bool() const noexcept {
+		return bool(d_frame);
+	}
+
+	// Number of handles sharing the frame.
+	long UseCount() const noexcept;
+
+	// Returns the frame for modification. If other handles share it, this
+	// handle is first detached on a copy allocated from pool, so the others
+	// are unaffected. The reference is valid until the handle is copied.
+	Frame &Mutable(FramePool &pool = *FramePool::Default());
+
+private:
+	SharedFrame(std::shared_ptr<Frame> &&frame);
+
+	std::shared_ptr<Frame> d_frame;
+};
+
+} // namespace video
+} // namespace fort
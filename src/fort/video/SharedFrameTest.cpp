@@ -0,0 +1,90 @@
+#include <fort/video/SharedFrame.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace fort {
+namespace video {
+
+TEST(SharedFrameTest, SharesPlanes) {
+	Frame frame{40, 30, AV_PIX_FMT_GRAY8};
+	frame.Index        = 7;
+	frame.Planes[0][0] = 42;
+	uint8_t *planes    = frame.Planes[0];
+
+	SharedFrame a{std::move(frame)};
+	SharedFrame b = a;
+	EXPECT_EQ(a.UseCount(), 2);
+	EXPECT_EQ(a->Planes[0], planes);
+	EXPECT_EQ(b->Planes[0], planes);
+	EXPECT_EQ((*b).Index, 7);
+	EXPECT_FALSE(SharedFrame{});
+}
+
+TEST(SharedFrameTest, CopiesOnWrite) {
+	auto pool = FramePool::Create();
+
+	SharedFrame a{Frame{40, 30, AV_PIX_FMT_GRAY8}};
+	a.Mutable().Planes[0][0] = 1;
+	const uint8_t *planes    = a->Planes[0];
+	// a unique handle is modified in place.
+	a.Mutable(*pool).Planes[0][1] = 2;
+	EXPECT_EQ(a->Planes[0], planes);
+	EXPECT_EQ(pool->GetStats().Allocated, 0);
+
+	SharedFrame b = a;
+	b.Mutable(*pool).Planes[0][0] = 3;
+	EXPECT_NE(b->Planes[0], planes);
+	EXPECT_EQ(a->Planes[0], planes);
+	EXPECT_EQ(a->Planes[0][0], 1);
+	EXPECT_EQ(b->Planes[0][0], 3);
+	EXPECT_EQ(b->Planes[0][1], 2);
+	EXPECT_EQ(a.UseCount(), 1);
+	EXPECT_EQ(b.UseCount(), 1);
+	EXPECT_EQ(pool->GetStats().InUse, 1);
+}
+
+TEST(SharedFrameTest, PooledFramesReturnOnLastRelease) {
+	auto pool = FramePool::Create();
+	{
+		SharedFrame a{pool->Get({16, 16}, AV_PIX_FMT_GRAY8)};
+		{
+			SharedFrame b = a;
+			EXPECT_EQ(pool->GetStats().InUse, 1);
+		}
+		EXPECT_EQ(pool->GetStats().InUse, 1);
+	}
+	EXPECT_EQ(pool->GetStats().InUse, 0);
+	EXPECT_EQ(pool->GetStats().Available, 1);
+}
+
+TEST(SharedFrameTest, CanBeReadFromSeveralThreads) {
+	Frame frame{64, 64, AV_PIX_FMT_GRAY8};
+	for (int y = 0; y < 64; ++y) {
+		memset(frame.Planes[0] + y * frame.Linesize[0], y, 64);
+	}
+	SharedFrame shared{std::move(frame)};
+
+	std::vector<std::thread> consumers;
+	std::vector<int>         sums(4, 0);
+	for (int t = 0; t < 4; ++t) {
+		consumers.emplace_back([copy = shared, &sum = sums[t]]() mutable {
+			for (int y = 0; y < 64; ++y) {
+				sum += copy->Planes[0][y * copy->Linesize[0]];
+			}
+			// a consumer may modify its own version.
+			copy.Mutable().Planes[0][0] = 255;
+		});
+	}
+	for (auto &c : consumers) {
+		c.join();
+	}
+	for (int sum : sums) {
+		EXPECT_EQ(sum, 63 * 64 / 2);
+	}
+	EXPECT_EQ(shared->Planes[0][0], 0);
+	EXPECT_EQ(shared.UseCount(), 1);
+}
+
+} // namespace video
+} // namespace fort
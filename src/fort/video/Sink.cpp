@@ -0,0 +1,348 @@
+#include "Sink.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cpptrace/cpptrace.hpp>
+
+namespace fort {
+namespace video {
+
+int64_t Sink::Seek(int64_t, int) {
+	throw cpptrace::logic_error{"sink is not seekable"};
+}
+
+int64_t Sink::Size() const {
+	return -1;
+}
+
+void MemorySink::Write(const uint8_t *data, size_t size) {
+	if (d_position + size > d_data.size()) {
+		d_data.resize(d_position + size);
+	}
+	std::copy(data, data + size, d_data.begin() + d_position);
+	d_position += size;
+}
+
+int64_t MemorySink::Seek(int64_t offset, int whence) {
+	int64_t position;
+	switch (whence) {
+	case SEEK_SET:
+		position = offset;
+		break;
+	case SEEK_CUR:
+		position = d_position + offset;
+		break;
+	case SEEK_END:
+		position = d_data.size() + offset;
+		break;
+	default:
+		throw cpptrace::invalid_argument{
+		    "invalid whence " + std::to_string(whence),
+		};
+	}
+	if (position < 0) {
+		throw cpptrace::invalid_argument{
+		    "invalid seek position " + std::to_string(position),
+		};
+	}
+	d_position = position;
+	return position;
+}
+
+int64_t MemorySink::Size() const {
+	return d_data.size();
+}
+
+const std::vector<uint8_t> &MemorySink::Data() const noexcept {
+	return d_data;
+}
+
+FileDescriptorSink::FileDescriptorSink(int fd, bool owned)
+    : d_fd{fd}
+    , d_owned{owned}
+    , d_seekable{lseek(fd, 0, SEEK_CUR) != -1} {}
+
+FileDescriptorSink::~FileDescriptorSink() {
+	if (d_owned) {
+		close(d_fd);
+	}
+}
+
+void FileDescriptorSink::Write(const uint8_t *data, size_t size) {
+	while (size > 0) {
+		ssize_t written = write(d_fd, data, size);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::system_error{errno, std::generic_category(), "write()"};
+		}
+		data += written;
+		size -= written;
+	}
+}
+
+bool FileDescriptorSink::Seekable() const noexcept {
+	return d_seekable;
+}
+
+int64_t FileDescriptorSink::Seek(int64_t offset, int whence) {
+	off_t res = lseek(d_fd, offset, whence);
+	if (res < 0) {
+		throw std::system_error{errno, std::generic_category(), "lseek()"};
+	}
+	return res;
+}
+
+int64_t FileDescriptorSink::Size() const {
+	struct stat infos;
+	if (fstat(d_fd, &infos) != 0 || !S_ISREG(infos.st_mode)) {
+		return -1;
+	}
+	return infos.st_size;
+}
+
+BufferedFileSink::BufferedFileSink(
+    const std::filesystem::path &path, const Options &options
+)
+    : d_direct{options.Direct}
+    , d_options{options}
+    , d_alignment{size_t(sysconf(_SC_PAGESIZE))}
+    , d_buffer{nullptr, free} {
+	if (options.BufferSize == 0) {
+		throw cpptrace::invalid_argument{"BufferSize must be positive"};
+	}
+	d_options.BufferSize =
+	    (options.BufferSize + d_alignment - 1) / d_alignment * d_alignment;
+
+	// data is read back when seeking in already written parts.
+	constexpr int flags = O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC;
+	if (d_direct) {
+		d_fd = open(path.c_str(), flags | O_DIRECT, 0644);
+		if (d_fd < 0 && errno == EINVAL) {
+			// the file system does not support O_DIRECT (e.g. tmpfs).
+			d_direct = false;
+		}
+	}
+	if (d_fd < 0 && d_direct == false) {
+		d_fd = open(path.c_str(), flags, 0644);
+	}
+	if (d_fd < 0) {
+		throw std::system_error{
+		    errno,
+		    std::generic_category(),
+		    "open('" + path.string() + "')",
+		};
+	}
+
+	void *buffer = nullptr;
+	if (posix_memalign(&buffer, d_alignment, d_options.BufferSize) != 0) {
+		::close(d_fd);
+		throw std::bad_alloc{};
+	}
+	d_buffer.reset(reinterpret_cast<uint8_t *>(buffer));
+}
+
+BufferedFileSink::~BufferedFileSink() {
+	try {
+		Close();
+	} catch (...) {
+	}
+	if (d_fd >= 0) {
+		::close(d_fd);
+	}
+}
+
+void BufferedFileSink::Write(const uint8_t *data, size_t size) {
+	if (d_fd < 0) {
+		throw cpptrace::logic_error{"sink is closed"};
+	}
+	const auto capacity = d_options.BufferSize;
+	auto       buffer   = d_buffer.get();
+	while (size > 0) {
+		if (d_position < d_bufferStart ||
+		    d_position >= d_bufferStart + int64_t(capacity)) {
+			moveBuffer(d_position);
+		}
+		const size_t offset = d_position - d_bufferStart;
+		if (offset > d_fill) {
+			// seeked past the end of the file.
+			std::memset(buffer + d_fill, 0, offset - d_fill);
+		}
+		const size_t n = std::min(size, capacity - offset);
+		std::memcpy(buffer + offset, data, n);
+		d_clean = std::min(d_clean, std::min(offset, d_fill));
+		d_fill  = std::max(d_fill, offset + n);
+
+		d_position += n;
+		d_size = std::max(d_size, d_position);
+		data += n;
+		size -= n;
+	}
+}
+
+int64_t BufferedFileSink::Seek(int64_t offset, int whence) {
+	int64_t position;
+	switch (whence) {
+	case SEEK_SET:
+		position = offset;
+		break;
+	case SEEK_CUR:
+		position = d_position + offset;
+		break;
+	case SEEK_END:
+		position = d_size + offset;
+		break;
+	default:
+		throw cpptrace::invalid_argument{
+		    "invalid whence " + std::to_string(whence),
+		};
+	}
+	if (position < 0) {
+		throw cpptrace::invalid_argument{
+		    "invalid seek position " + std::to_string(position),
+		};
+	}
+	// the buffer is only moved on the next write.
+	d_position = position;
+	return position;
+}
+
+int64_t BufferedFileSink::Size() const {
+	return d_size;
+}
+
+void BufferedFileSink::Flush() {
+	if (d_fd < 0) {
+		return;
+	}
+	writeBuffer();
+	if (d_direct && ftruncate(d_fd, d_size) != 0) {
+		throw std::system_error{errno, std::generic_category(), "ftruncate()"};
+	}
+	if (d_options.Sync == SyncPolicy::OnFlush) {
+		sync();
+	}
+}
+
+void BufferedFileSink::Close() {
+	if (d_fd < 0) {
+		return;
+	}
+	writeBuffer();
+	if (d_direct && ftruncate(d_fd, d_size) != 0) {
+		throw std::system_error{errno, std::generic_category(), "ftruncate()"};
+	}
+	if (d_options.Sync != SyncPolicy::Never) {
+		sync();
+	}
+	int fd = std::exchange(d_fd, -1);
+	if (::close(fd) != 0) {
+		throw std::system_error{errno, std::generic_category(), "close()"};
+	}
+}
+
+bool BufferedFileSink::Direct() const noexcept {
+	return d_direct;
+}
+
+void BufferedFileSink::writeBuffer() {
+	if (d_clean >= d_fill) {
+		return;
+	}
+	// O_DIRECT needs aligned offsets and sizes, the padding past the end of
+	// the file is truncated by Flush() and Close().
+	const size_t begin = d_clean / d_alignment * d_alignment;
+	size_t       end   = d_fill;
+	if (d_direct) {
+		end = (d_fill + d_alignment - 1) / d_alignment * d_alignment;
+		std::memset(d_buffer.get() + d_fill, 0, end - d_fill);
+	}
+
+	for (size_t written = begin; written < end;) {
+		ssize_t res = pwrite(
+		    d_fd,
+		    d_buffer.get() + written,
+		    end - written,
+		    d_bufferStart + written
+		);
+		if (res < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::system_error{errno, std::generic_category(), "pwrite()"};
+		}
+		written += res;
+	}
+	d_clean = d_fill;
+
+	d_unsynced += end - begin;
+	if (d_options.Sync == SyncPolicy::Periodic &&
+	    d_unsynced >= d_options.SyncBytes) {
+		sync();
+	}
+}
+
+void BufferedFileSink::moveBuffer(int64_t position) {
+	writeBuffer();
+	d_bufferStart = position / d_alignment * d_alignment;
+	d_fill        = 0;
+	d_clean       = 0;
+	if (d_bufferStart >= d_size) {
+		return;
+	}
+
+	const size_t toLoad =
+	    std::min(int64_t(d_options.BufferSize), d_size - d_bufferStart);
+	const size_t length =
+	    d_direct ? (toLoad + d_alignment - 1) / d_alignment * d_alignment
+	             : toLoad;
+	size_t loaded = 0;
+	while (loaded < toLoad) {
+		ssize_t res = pread(
+		    d_fd,
+		    d_buffer.get() + loaded,
+		    length - loaded,
+		    d_bufferStart + loaded
+		);
+		if (res < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::system_error{errno, std::generic_category(), "pread()"};
+		}
+		if (res == 0) {
+			throw cpptrace::runtime_error{"unexpected end of file"};
+		}
+		loaded += res;
+	}
+	d_fill  = toLoad;
+	d_clean = toLoad;
+}
+
+void BufferedFileSink::sync() {
+	if (fdatasync(d_fd) != 0) {
+		throw std::system_error{errno, std::generic_category(), "fdatasync()"};
+	}
+	d_unsynced = 0;
+}
+
+CallbackSink::CallbackSink(Callback &&callback)
+    : d_callback{std::move(callback)} {}
+
+void CallbackSink::Write(const uint8_t *data, size_t size) {
+	d_callback(data, size);
+}
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace fort {
+namespace video {
+
+// Sink is a user supplied destination for a Writer output, instead of a
+// file path. Containers which rewrite their header at the end (like
+// non-fragmented MP4) need a Seekable() sink.
+class Sink {
+public:
+	virtual ~Sink() = default;
+
+	// Writes all size bytes or throws an exception.
+	virtual void Write(const uint8_t *data, size_t size) = 0;
+
+	virtual bool Seekable() const noexcept {
+		return false;
+	}
+
+	// Moves the write position like lseek(2), and returns the new one.
+	virtual int64_t Seek(int64_t offset, int whence);
+
+	// Total size of the written data, or -1 if unknown.
+	virtual int64_t Size() const;
+
+	// Pushes any data buffered by the sink to its destination. Called on
+	// Writer::Params::FlushPeriod, and at the end of the output.
+	virtual void Flush() {}
+};
+
+// MemorySink writes in a growable memory buffer.
+class MemorySink : public Sink {
+public:
+	void Write(const uint8_t *data, size_t size) override;
+
+	bool Seekable() const noexcept override {
+		return true;
+	}
+
+	int64_t Seek(int64_t offset, int whence) override;
+
+	int64_t Size() const override;
+
+	const std::vector<uint8_t> &Data() const noexcept;
+
+private:
+	std::vector<uint8_t> d_data;
+	size_t               d_position = 0;
+};
+
+// FileDescriptorSink writes to a file descriptor, which can be a pipe or a
+// socket. It is seekable only if the descriptor is.
+class FileDescriptorSink : public Sink {
+public:
+	// If owned is true, fd is closed on destruction.
+	FileDescriptorSink(int fd, bool owned = false);
+	~FileDescriptorSink();
+
+	FileDescriptorSink(const FileDescriptorSink &)            = delete;
+	FileDescriptorSink &operator=(const FileDescriptorSink &) = delete;
+
+	void Write(const uint8_t *data, size_t size) override;
+
+	bool Seekable() const noexcept override;
+
+	int64_t Seek(int64_t offset, int whence) override;
+
+	int64_t Size() const override;
+
+private:
+	int  d_fd;
+	bool d_owned;
+	bool d_seekable;
+};
+
+// BufferedFileSink writes a file through a large page-aligned buffer, so the
+// file system only sees a few large sequential writes instead of many small
+// ones. With Direct, the file is opened with O_DIRECT and bypasses the page
+// cache, which avoids many concurrent writers evicting each other's cache.
+class BufferedFileSink : public Sink {
+public:
+	enum class SyncPolicy {
+		// Never calls fdatasync(2).
+		Never,
+		// Syncs when the file is closed.
+		OnClose,
+		// Syncs on each Flush(), and when the file is closed.
+		OnFlush,
+		// Syncs every SyncBytes written to the file, and when it is closed.
+		Periodic,
+	};
+
+	struct Options {
+		// Size of the buffer, rounded up to the page size. Zero disables
+		// the sink in Writer::Params.
+		size_t BufferSize = 0;
+		// Opens the file with O_DIRECT if the file system supports it.
+		bool       Direct    = false;
+		SyncPolicy Sync      = SyncPolicy::OnClose;
+		size_t     SyncBytes = 64 * 1024 * 1024;
+	};
+
+	BufferedFileSink(const std::filesystem::path &path, const Options &options);
+	// Closes the file, ignoring errors. Use Close() to get them.
+	~BufferedFileSink();
+
+	BufferedFileSink(const BufferedFileSink &)            = delete;
+	BufferedFileSink &operator=(const BufferedFileSink &) = delete;
+
+	void Write(const uint8_t *data, size_t size) override;
+
+	bool Seekable() const noexcept override {
+		return true;
+	}
+
+	int64_t Seek(int64_t offset, int whence) override;
+
+	int64_t Size() const override;
+
+	void Flush() override;
+
+	// Writes all buffered data and closes the file.
+	void Close();
+
+	// True if the file is opened with O_DIRECT.
+	bool Direct() const noexcept;
+
+private:
+	// Writes the buffer to the file, padded to the alignment if needed.
+	void writeBuffer();
+	// Moves the buffer to the aligned block containing position, loading
+	// the file data it covers.
+	void moveBuffer(int64_t position);
+	void sync();
+
+	int     d_fd = -1;
+	bool    d_direct;
+	Options d_options;
+	size_t  d_alignment;
+
+	std::unique_ptr<uint8_t, void (*)(void *)> d_buffer;
+	// file offset of the buffer, always aligned, and number of valid bytes
+	// in it. Bytes after d_fill are past the end of the file. The first
+	// d_clean bytes are already written to the file.
+	int64_t d_bufferStart = 0;
+	size_t  d_fill        = 0;
+	size_t  d_clean       = 0;
+
+	int64_t d_position = 0;
+	int64_t d_size     = 0;
+	size_t  d_unsynced = 0;
+};
+
+// CallbackSink passes all written data to a function. It is not seekable.
+class CallbackSink : public Sink {
+public:
+	using Callback = std::function<void(const uint8_t *data, size_t size)>;
+
+	CallbackSink(Callback &&callback);
+
+	void Write(const uint8_t *data, size_t size) override;
+
+private:
+	Callback d_callback;
+};
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include <fort/video/Sink.hpp>
+
+namespace fort {
+namespace video {
+
+// Writes like a Muxer does, in chunks of its IO buffer size.
+constexpr static size_t CHUNK_SIZE = 64 * 1024;
+constexpr static size_t FILE_SIZE  = 64 * 1024 * 1024;
+
+enum class SinkKind {
+	FileDescriptor = 0,
+	Buffered       = 1,
+	Direct         = 2,
+};
+
+static std::unique_ptr<Sink>
+openSink(SinkKind kind, const std::filesystem::path &path, int &fd) {
+	fd = -1;
+	switch (kind) {
+	case SinkKind::FileDescriptor:
+		fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		return std::make_unique<FileDescriptorSink>(fd, true);
+	case SinkKind::Buffered:
+	case SinkKind::Direct:
+		return std::make_unique<BufferedFileSink>(
+		    path,
+		    BufferedFileSink::Options{
+		        .BufferSize = 4 * 1024 * 1024,
+		        .Direct     = kind == SinkKind::Direct,
+		    }
+		);
+	}
+	return nullptr;
+}
+
+static void BM_ConcurrentWriters(benchmark::State &state) {
+	const auto kind = SinkKind(state.range(0));
+	const auto path = std::filesystem::temp_directory_path() /
+	                  ("fort-video-sink-benchmark-" +
+	                   std::to_string(state.thread_index()) + ".bin");
+	std::vector<uint8_t> chunk(CHUNK_SIZE, 42);
+	state.SetLabel(
+	    kind == SinkKind::FileDescriptor ? "write"
+	    : kind == SinkKind::Buffered     ? "buffered"
+	                                     : "direct"
+	);
+
+	for (auto _ : state) {
+		int  fd;
+		auto sink = openSink(kind, path, fd);
+		for (size_t written = 0; written < FILE_SIZE; written += CHUNK_SIZE) {
+			sink->Write(chunk.data(), chunk.size());
+		}
+		// all sinks pay for the data to be on disk.
+		sink->Flush();
+		if (fd >= 0) {
+			fdatasync(fd);
+		}
+	}
+	std::filesystem::remove(path);
+	state.SetBytesProcessed(int64_t(state.iterations()) * FILE_SIZE);
+}
+
+BENCHMARK(BM_ConcurrentWriters)
+    ->DenseRange(0, 2)
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(12)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,281 @@
+#include <cpptrace/cpptrace.hpp>
+#include <filesystem>
+#include <fort/video/Frame.hpp>
+#include <fort/video/Reader.hpp>
+#include <fort/video/Sink.hpp>
+#include <fort/video/Writer.hpp>
+#include <fort/video/details/AVCall.hpp>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <unistd.h>
+
+extern "C" {
+#include <libavutil/log.h>
+}
+
+namespace fort {
+namespace video {
+
+class SinkTest : public ::testing::Test {
+protected:
+	static std::filesystem::path TempDir;
+	constexpr static int         LENGTH = 50;
+
+	static void SetUpTestSuite() {
+		std::string tmpDirTemplate = std::filesystem::temp_directory_path() /
+		                             "fort-video-sink-tests-XXXXXX";
+		TempDir = mkdtemp(const_cast<char *>(tmpDirTemplate.c_str()));
+		av_log_set_level(AV_LOG_QUIET);
+	}
+
+	static void TearDownTestSuite() {
+		std::filesystem::remove_all(TempDir);
+	}
+
+	static std::unique_ptr<Writer> NewWriter(Writer::Params &&params) {
+		auto w = std::make_unique<Writer>(
+		    std::move(params),
+		    Encoder::Params{
+		        .Size{40, 30},
+		        .Framerate = {24, 1},
+		        .Format    = AV_PIX_FMT_GRAY8,
+		    }
+		);
+
+		Frame frame{40, 30, AV_PIX_FMT_GRAY8, 16};
+		for (int i = 0; i < LENGTH; i++) {
+			memset(frame.Planes[0], 3 * i, 40 * 30);
+			w->Write(frame);
+		}
+		return w;
+	}
+
+	static void Encode(Writer::Params &&params) {
+		NewWriter(std::move(params))->Close();
+	}
+
+	static void ExpectVideo(
+	    const std::vector<uint8_t> &data, const std::string &extension
+	) {
+		auto path = TempDir / ("dump" + extension);
+		{
+			std::ofstream file{path, std::ios_base::binary};
+			file.write((const char *)data.data(), data.size());
+		}
+		Reader r{path};
+		auto   f = r.CreateFrame();
+		for (int i = 0; i < LENGTH; i++) {
+			SCOPED_TRACE(std::to_string(i));
+			ASSERT_TRUE(r.Read(*f));
+			EXPECT_NEAR(f->Planes[0][0], 3 * i, 1);
+		}
+		EXPECT_FALSE(r.Read(*f));
+	}
+};
+
+std::filesystem::path SinkTest::TempDir;
+
+TEST_F(SinkTest, MemorySinkIsSeekable) {
+	auto sink = std::make_shared<MemorySink>();
+	Encode({.Path = "memory.mp4", .Sink = sink});
+	ASSERT_FALSE(sink->Data().empty());
+	ExpectVideo(sink->Data(), ".mp4");
+}
+
+TEST_F(SinkTest, CallbackSink) {
+	std::vector<uint8_t> data;
+	Encode({
+	    .Format = "mpegts",
+	    .Sink   = std::make_shared<CallbackSink>(
+            [&data](const uint8_t *buffer, size_t size) {
+                data.insert(data.end(), buffer, buffer + size);
+            }
+        ),
+	});
+	ExpectVideo(data, ".ts");
+}
+
+TEST_F(SinkTest, FileDescriptorSinkOnPipe) {
+	int fds[2];
+	ASSERT_EQ(pipe(fds), 0);
+
+	std::vector<uint8_t> data;
+	std::thread          drain{[&data, fd = fds[0]]() {
+        uint8_t buffer[4096];
+        ssize_t size;
+        while ((size = read(fd, buffer, sizeof(buffer))) > 0) {
+            data.insert(data.end(), buffer, buffer + size);
+        }
+        close(fd);
+    }};
+
+	{
+		auto sink = std::make_shared<FileDescriptorSink>(fds[1], true);
+		EXPECT_FALSE(sink->Seekable());
+		Encode({.Path = "pipe.ts", .Sink = std::move(sink)});
+	}
+	drain.join();
+	ExpectVideo(data, ".ts");
+}
+
+TEST_F(SinkTest, NonSeekableMP4MustBeFragmented) {
+	auto noop = [](const uint8_t *, size_t) {};
+	EXPECT_THROW(
+	    {
+		    Encode({
+		        .Path = "callback.mp4",
+		        .Sink = std::make_shared<CallbackSink>(noop),
+		    });
+	    },
+	    details::AVError
+	);
+
+	EXPECT_NO_THROW({
+		Encode({
+		    .Path       = "callback.mp4",
+		    .Fragmented = true,
+		    .Sink       = std::make_shared<CallbackSink>(noop),
+		});
+	});
+}
+
+TEST_F(SinkTest, SinkErrorsArePropagated) {
+	struct UploadError : public std::exception {};
+
+	EXPECT_THROW(
+	    {
+		    Encode({
+		        .Path        = "failing.ts",
+		        .FlushPeriod = Duration{0},
+		        .Sink        = std::make_shared<CallbackSink>(
+                    [](const uint8_t *, size_t) { throw UploadError{}; }
+                ),
+		    });
+	    },
+	    UploadError
+	);
+}
+
+TEST_F(SinkTest, CloseReportsSinkErrors) {
+	struct UploadError : public std::exception {};
+
+	struct BreakableSink : public MemorySink {
+		bool Broken = false;
+
+		void Write(const uint8_t *data, size_t size) override {
+			if (Broken) {
+				throw UploadError{};
+			}
+			MemorySink::Write(data, size);
+		}
+	};
+
+	// the moov atom of a MP4 is always written last.
+	auto sink         = std::make_shared<BreakableSink>();
+	auto writer       = NewWriter({.Path = "broken.mp4", .Sink = sink});
+	sink->Broken      = true;
+	EXPECT_THROW(writer->Close(), UploadError);
+	EXPECT_NO_THROW(writer->Close()) << "already closed";
+	EXPECT_NO_THROW(writer.reset());
+
+	sink         = std::make_shared<BreakableSink>();
+	writer       = NewWriter({.Path = "broken.mp4", .Sink = sink});
+	sink->Broken = true;
+	EXPECT_NO_THROW(writer.reset()) << "the destructor ignores errors";
+}
+
+TEST_F(SinkTest, BufferedFileSinkMatchesMemorySink) {
+	for (bool direct : {false, true}) {
+		SCOPED_TRACE(direct ? "direct" : "buffered");
+		auto path = TempDir / (direct ? "direct.bin" : "buffered.bin");
+		BufferedFileSink file{
+		    path,
+		    {.BufferSize = 10000, .Direct = direct},
+		};
+		MemorySink expected;
+
+		auto readFile = [&path]() {
+			std::ifstream in{path, std::ios_base::binary};
+			return std::vector<uint8_t>{
+			    std::istreambuf_iterator<char>(in),
+			    std::istreambuf_iterator<char>(),
+			};
+		};
+
+		std::mt19937                          rng{42};
+		std::uniform_int_distribution<size_t> sizes{1, 30000};
+		std::vector<uint8_t>                  data(30000);
+		for (int i = 0; i < 200; ++i) {
+			for (auto &v : data) {
+				v = rng();
+			}
+			const size_t size = sizes(rng);
+			file.Write(data.data(), size);
+			expected.Write(data.data(), size);
+			switch (rng() % 8) {
+			case 0: {
+				// like a muxer rewriting a header.
+				int64_t position = rng() % expected.Size();
+				EXPECT_EQ(file.Seek(position, SEEK_SET), position);
+				expected.Seek(position, SEEK_SET);
+				break;
+			}
+			case 1:
+				EXPECT_EQ(file.Seek(0, SEEK_END), expected.Seek(0, SEEK_END));
+				break;
+			case 2:
+				file.Flush();
+				ASSERT_EQ(readFile(), expected.Data());
+				break;
+			default:
+				break;
+			}
+			EXPECT_EQ(file.Size(), expected.Size());
+		}
+		file.Close();
+		EXPECT_EQ(readFile(), expected.Data());
+		EXPECT_THROW(file.Write(data.data(), 1), cpptrace::logic_error);
+	}
+}
+
+TEST_F(SinkTest, WriterCanUseAFileBuffer) {
+	for (bool direct : {false, true}) {
+		SCOPED_TRACE(direct ? "direct" : "buffered");
+		auto path = TempDir / (direct ? "direct.mp4" : "buffered.mp4");
+		Encode({
+		    .Path       = path,
+		    .FileBuffer = {.BufferSize = 1024 * 1024, .Direct = direct},
+		});
+		std::ifstream        in{path, std::ios_base::binary};
+		std::vector<uint8_t> data{
+		    std::istreambuf_iterator<char>(in),
+		    std::istreambuf_iterator<char>(),
+		};
+		ExpectVideo(data, ".mp4");
+	}
+}
+
+TEST_F(SinkTest, CloseReportsFileBufferErrors) {
+	if (!std::filesystem::exists("/dev/full")) {
+		GTEST_SKIP() << "/dev/full is not available";
+	}
+	// the whole output fits in the buffer, and is only written on close.
+	EXPECT_THROW(
+	    {
+		    Encode({
+		        .Path       = "/dev/full",
+		        .Format     = "mp4",
+		        .FileBuffer = {.BufferSize = 1024 * 1024},
+		    });
+	    },
+	    std::system_error
+	);
+}
+
+} // namespace video
+} // namespace fort
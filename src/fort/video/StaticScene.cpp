@@ -0,0 +1,150 @@
+#include "StaticScene.hpp"
+#include "Ops.hpp"
+#include "TypesIO.hpp"
+
+#include <algorithm>
+#include <cpptrace/cpptrace.hpp>
+#include <optional>
+#include <vector>
+
+namespace fort {
+namespace video {
+
+struct StaticSceneFilter::Implementation {
+	Params d_params;
+	Stats  d_stats;
+	double d_difference = 0.0;
+	size_t d_skipped    = 0;
+
+	// successive halvings of the current frame luma, the last one is
+	// compared to d_reference.
+	std::vector<Frame>   d_levels;
+	std::optional<Frame> d_reference;
+	Resolution           d_size;
+	bool                 d_copyLuma = false;
+
+	Implementation(const Params &params)
+	    : d_params{params} {
+		if (d_params.Downsamples < 0 || d_params.Threshold < 0.0) {
+			throw cpptrace::invalid_argument{
+			    "invalid static scene parameters {Downsamples: " +
+			    std::to_string(d_params.Downsamples) +
+			    ", Threshold: " + std::to_string(d_params.Threshold) + "}",
+			};
+		}
+	}
+
+	bool Accept(const Frame &frame) {
+		if (!Supports(frame.Format)) {
+			throw cpptrace::invalid_argument{
+			    "static scene detection is not supported for " +
+			    std::to_string(frame.Format),
+			};
+		}
+		if (frame.Size != d_size) {
+			resize(frame.Size);
+		}
+
+		++d_stats.Frames;
+		const Frame &current = downsample(frame);
+
+		if (!d_reference) {
+			d_difference = 0.0;
+			return accept();
+		}
+
+		d_difference = double(ops::SumAbsDiff(current, *d_reference)) /
+		               (current.Size.Width * current.Size.Height);
+		if (d_difference > d_params.Threshold ||
+		    (d_params.MaxSkipped > 0 && d_skipped >= d_params.MaxSkipped)) {
+			return accept();
+		}
+		++d_skipped;
+		++d_stats.Skipped;
+		return false;
+	}
+
+	bool accept() {
+		d_skipped = 0;
+		if (!d_reference) {
+			const Frame &last = d_levels.back();
+			d_reference.emplace(last.Size, last.Format);
+		}
+		std::swap(*d_reference, d_levels.back());
+		return true;
+	}
+
+	void resize(const Resolution &size) {
+		d_size = size;
+		d_reference.reset();
+		d_levels.clear();
+		Resolution s = size;
+		for (int i = 0; i < d_params.Downsamples; ++i) {
+			if (s.Width < 2 || s.Height < 2) {
+				break;
+			}
+			s = {s.Width / 2, s.Height / 2};
+			d_levels.emplace_back(s, AV_PIX_FMT_GRAY8);
+		}
+		d_copyLuma = d_levels.empty();
+		if (d_copyLuma) {
+			// the reference must outlive the frame, so an unscaled luma
+			// plane is copied.
+			d_levels.emplace_back(size, AV_PIX_FMT_GRAY8);
+		}
+	}
+
+	const Frame &downsample(const Frame &frame) {
+		if (d_copyLuma) {
+			auto &dst = d_levels.back();
+			for (int y = 0; y < frame.Size.Height; ++y) {
+				std::copy_n(
+				    frame.Planes[0] + y * frame.Linesize[0],
+				    frame.Size.Width,
+				    dst.Planes[0] + y * dst.Linesize[0]
+				);
+			}
+			return dst;
+		}
+
+		const Frame  luma = ops::LumaView(frame);
+		const Frame *src  = &luma;
+		for (auto &level : d_levels) {
+			ops::Downsample2x(*src, level);
+			src = &level;
+		}
+		return *src;
+	}
+};
+
+StaticSceneFilter::StaticSceneFilter()
+    : StaticSceneFilter{Params{}} {}
+
+StaticSceneFilter::StaticSceneFilter(const Params &params)
+    : self{std::make_unique<Implementation>(params)} {}
+
+StaticSceneFilter::~StaticSceneFilter() = default;
+
+bool StaticSceneFilter::Supports(PixelFormat format) noexcept {
+	return ops::HasLumaPlane(format);
+}
+
+bool StaticSceneFilter::Accept(const Frame &frame) {
+	return self->Accept(frame);
+}
+
+double StaticSceneFilter::Difference() const noexcept {
+	return self->d_difference;
+}
+
+StaticSceneFilter::Stats StaticSceneFilter::GetStats() const noexcept {
+	return self->d_stats;
+}
+
+void StaticSceneFilter::Reset() noexcept {
+	self->d_reference.reset();
+	self->d_skipped = 0;
+}
+
+} // namespace video
+} // namespace fort
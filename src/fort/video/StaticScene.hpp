@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+
+#include "Frame.hpp"
+#include "Types.hpp"
+
+namespace fort {
+namespace video {
+
+// StaticSceneFilter detects frames that barely differ from the last
+// accepted one, so a static scene can be dropped or flagged before any
+// further processing. Frames are compared on their luma plane, downsampled
+// to make the comparison cheap and insensitive to sensor noise.
+//
+// Comparing against the last accepted frame, rather than the previous one,
+// ensures a slow drift is eventually accepted.
+class StaticSceneFilter {
+public:
+	struct Params {
+		// Number of times the luma plane is halved before comparison.
+		int Downsamples = 2;
+		// Mean absolute luma difference per downsampled pixel, at or below
+		// which a frame is static.
+		double Threshold = 2.0;
+		// A static frame is accepted anyway after this many consecutive
+		// ones were rejected. Zero never does.
+		size_t MaxSkipped = 0;
+	};
+
+	struct Stats {
+		size_t Frames  = 0;
+		size_t Skipped = 0;
+	};
+
+	StaticSceneFilter();
+	StaticSceneFilter(const Params &params);
+	~StaticSceneFilter();
+
+	// Returns true if format has an 8-bit luma (or gray) first plane, which
+	// is all the filter reads.
+	static bool Supports(PixelFormat format) noexcept;
+
+	// Returns false if frame is static. The first frame, or one of a
+	// different size, is always accepted. Throws
+	// cpptrace::invalid_argument if the format is not supported.
+	bool Accept(const Frame &frame);
+
+	// Mean absolute difference computed by the last Accept() call.
+	double Difference() const noexcept;
+
+	Stats GetStats() const noexcept;
+
+	// Forgets the reference frame, so the next one is accepted.
+	void Reset() noexcept;
+
+private:
+	struct Implementation;
+
+	std::unique_ptr<Implementation> self;
+};
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cpptrace/cpptrace.hpp>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <fort/video/Frame.hpp>
+#include <fort/video/StaticScene.hpp>
+
+namespace fort {
+namespace video {
+
+class StaticSceneTest : public ::testing::Test {
+protected:
+	static void Fill(Frame &frame, uint8_t value) {
+		for (int y = 0; y < frame.Size.Height; ++y) {
+			memset(
+			    frame.Planes[0] + y * frame.Linesize[0],
+			    value,
+			    frame.Size.Width
+			);
+		}
+	}
+
+	// Adds uniform noise in [-amplitude, amplitude] to frame.
+	static void
+	AddNoise(Frame &frame, int amplitude, std::mt19937 &rng, uint8_t base) {
+		std::uniform_int_distribution<int> dist{-amplitude, amplitude};
+		for (int y = 0; y < frame.Size.Height; ++y) {
+			for (int x = 0; x < frame.Size.Width; ++x) {
+				frame.Planes[0][y * frame.Linesize[0] + x] =
+				    std::clamp(base + dist(rng), 0, 255);
+			}
+		}
+	}
+};
+
+TEST_F(StaticSceneTest, SupportsLumaFormats) {
+	EXPECT_TRUE(StaticSceneFilter::Supports(AV_PIX_FMT_GRAY8));
+	EXPECT_TRUE(StaticSceneFilter::Supports(AV_PIX_FMT_YUV420P));
+	EXPECT_TRUE(StaticSceneFilter::Supports(AV_PIX_FMT_NV12));
+	EXPECT_FALSE(StaticSceneFilter::Supports(AV_PIX_FMT_RGB24));
+	EXPECT_FALSE(StaticSceneFilter::Supports(AV_PIX_FMT_NONE));
+
+	StaticSceneFilter filter;
+	Frame             rgb{16, 16, AV_PIX_FMT_RGB24};
+	EXPECT_THROW(filter.Accept(rgb), cpptrace::invalid_argument);
+	EXPECT_THROW(
+	    StaticSceneFilter({.Downsamples = -1}),
+	    cpptrace::invalid_argument
+	);
+}
+
+TEST_F(StaticSceneTest, SkipsNoisyStaticFrames) {
+	std::mt19937      rng{42};
+	StaticSceneFilter filter{{.Downsamples = 2, .Threshold = 2.0}};
+	Frame             frame{64, 48, AV_PIX_FMT_GRAY8};
+
+	AddNoise(frame, 8, rng, 100);
+	EXPECT_TRUE(filter.Accept(frame));
+	for (int i = 0; i < 10; ++i) {
+		// downsampling averages the noise out.
+		AddNoise(frame, 8, rng, 100);
+		EXPECT_FALSE(filter.Accept(frame));
+		EXPECT_LE(filter.Difference(), 2.0);
+	}
+	AddNoise(frame, 8, rng, 110);
+	EXPECT_TRUE(filter.Accept(frame));
+	EXPECT_NEAR(filter.Difference(), 10.0, 1.0);
+
+	EXPECT_EQ(filter.GetStats().Frames, 12);
+	EXPECT_EQ(filter.GetStats().Skipped, 10);
+}
+
+TEST_F(StaticSceneTest, ComparesToLastAcceptedFrame) {
+	StaticSceneFilter filter{{.Threshold = 2.0}};
+	Frame             frame{32, 32, AV_PIX_FMT_YUV420P};
+	memset(frame.Planes[1], 0, frame.Linesize[1] * 16);
+
+	// a slow drift is eventually accepted.
+	std::vector<int> accepted;
+	for (int i = 0; i < 10; ++i) {
+		Fill(frame, 50 + i);
+		if (filter.Accept(frame)) {
+			accepted.push_back(i);
+		}
+	}
+	EXPECT_EQ(accepted, (std::vector<int>{0, 3, 6, 9}));
+
+	// chroma is ignored.
+	memset(frame.Planes[1], 255, frame.Linesize[1] * 16);
+	EXPECT_FALSE(filter.Accept(frame));
+
+	filter.Reset();
+	EXPECT_TRUE(filter.Accept(frame));
+
+	// a new size resets the reference.
+	Frame small{8, 8, AV_PIX_FMT_GRAY8};
+	Fill(small, 59);
+	EXPECT_TRUE(filter.Accept(small));
+	EXPECT_FALSE(filter.Accept(small));
+}
+
+TEST_F(StaticSceneTest, HonorsMaxSkipped) {
+	StaticSceneFilter filter{{.Downsamples = 0, .MaxSkipped = 3}};
+	Frame             frame{5, 3, AV_PIX_FMT_GRAY8};
+	Fill(frame, 10);
+
+	std::vector<int> accepted;
+	for (int i = 0; i < 10; ++i) {
+		if (filter.Accept(frame)) {
+			accepted.push_back(i);
+		}
+	}
+	EXPECT_EQ(accepted, (std::vector<int>{0, 4, 8}));
+}
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,220 @@
+#include "Transcode.hpp"
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cpptrace/cpptrace.hpp>
+
+#include <unistd.h>
+
+#include <fort/utils/Defer.hpp>
+
+#include "Reader.hpp"
+#include "Remux.hpp"
+#include "SegmentedWriter.hpp"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/mathematics.h>
+}
+
+namespace fort {
+namespace video {
+
+namespace details {
+struct Chunk {
+	video::Duration       Start, End;
+	std::filesystem::path Path;
+};
+
+// Lists the key frames timestamps, and groups them in chunks of at least
+// chunkDuration.
+std::vector<Chunk> SplitOnKeyFrames(
+    const std::filesystem::path &input, video::Duration chunkDuration
+) {
+	Reader             reader{input};
+	std::vector<Chunk> res;
+	const auto         timeBase = reader.TimeBase();
+	while (auto pkt = reader.ReadPacket()) {
+		if ((pkt->flags & AV_PKT_FLAG_KEY) == 0 || pkt->pts == AV_NOPTS_VALUE) {
+			continue;
+		}
+		const video::Duration pts{
+		    av_rescale_q(pkt->pts, timeBase, {1, int(1e9)}),
+		};
+		if (res.empty() || pts - res.back().Start >= chunkDuration) {
+			if (res.empty() == false) {
+				res.back().End = pts;
+			}
+			res.push_back({.Start = pts, .End = video::Duration::max()});
+		}
+	}
+	if (res.empty()) {
+		throw cpptrace::runtime_error{
+		    "no key frame found in " + input.string(),
+		};
+	}
+	return res;
+}
+
+void EncodeChunk(
+    const std::filesystem::path &input,
+    const Chunk                 &chunk,
+    Writer::Params             &&output,
+    Encoder::Params             &&encoding
+) {
+	Reader reader{
+	    input,
+	    encoding.Format,
+	    {encoding.Size.Width, encoding.Size.Height},
+	};
+	output.Path        = chunk.Path;
+	output.UseFramePTS = true;
+
+	Writer writer{std::move(output), std::move(encoding)};
+	auto   frame = reader.CreateFrame();
+	if (chunk.Start > video::Duration{0}) {
+		reader.SeekTime(chunk.Start);
+	}
+	// The first frame is always a key frame for the encoder, so each chunk
+	// can be concatenated on its own.
+	while (reader.Read(*frame) && frame->PTS < chunk.End) {
+		if (frame->PTS < chunk.Start) {
+			continue;
+		}
+		writer.Write(*frame);
+	}
+	writer.Close();
+}
+
+} // namespace details
+
+void Transcode(
+    const std::filesystem::path &input,
+    Writer::Params             &&output,
+    Encoder::Params            &&encoding,
+    const TranscodeParams       &params
+) {
+	if (params.ChunkDuration <= video::Duration{0}) {
+		throw cpptrace::invalid_argument{"ChunkDuration must be positive"};
+	}
+	{
+		Reader reader{input};
+		if (encoding.Size.Width <= 0 || encoding.Size.Height <= 0) {
+			encoding.Size = reader.Size();
+		}
+		if (encoding.Framerate.Num <= 0 || encoding.Framerate.Den <= 0) {
+			// microsecond precision is enough for the rate control.
+			encoding.Framerate = {
+			    1000000,
+			    int(reader.AverageFrameDuration().count() / 1000),
+			};
+		}
+		if (encoding.TimeBase.Num <= 0 || encoding.TimeBase.Den <= 0) {
+			const auto tb     = reader.TimeBase();
+			encoding.TimeBase = {tb.num, tb.den};
+		}
+	}
+
+	auto chunks  = details::SplitOnKeyFrames(input, params.ChunkDuration);
+	auto tempDir = params.TempDir;
+	auto stem    = output.Path.stem().string();
+	if (output.Path.empty()) {
+		// writing to a Sink, the current directory may not be writable, and
+		// concurrent transcodes need distinct names.
+		static std::atomic<size_t> count{0};
+		stem = "fort-video-transcode-" + std::to_string(getpid()) + "-" +
+		       std::to_string(count++);
+		if (tempDir.empty()) {
+			tempDir = std::filesystem::temp_directory_path();
+		}
+	} else if (tempDir.empty()) {
+		tempDir = output.Path.parent_path();
+	}
+	auto extension = output.Path.extension();
+	if (extension.empty()) {
+		extension = ".mkv";
+	}
+	const auto pattern = tempDir / ("." + stem + ".chunk" + extension.string());
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		chunks[i].Path = SegmentedWriter::SegmentPath(pattern, i);
+	}
+
+	defer {
+		for (const auto &c : chunks) {
+			std::error_code ec;
+			std::filesystem::remove(c.Path, ec);
+		}
+	};
+
+	size_t jobs = params.Jobs;
+	if (jobs == 0) {
+		jobs = std::max(1U, std::thread::hardware_concurrency());
+	}
+	jobs = std::min(jobs, chunks.size());
+	if (encoding.Threads == 0) {
+		// chunk encoders would otherwise each use all the cores.
+		encoding.Threads =
+		    std::max(1, int(std::thread::hardware_concurrency() / jobs));
+	}
+
+	std::atomic<size_t>      next{0};
+	std::mutex               mutex;
+	std::exception_ptr       error;
+	std::vector<std::thread> workers;
+	// workers reference the locals above, they must be joined before
+	// leaving, even if one cannot be started.
+	const auto joinAll = [&]() {
+		for (auto &w : workers) {
+			w.join();
+		}
+	};
+	try {
+		for (size_t j = 0; j < jobs; ++j) {
+			workers.emplace_back([&]() {
+				while (true) {
+					size_t i = next++;
+					if (i >= chunks.size()) {
+						return;
+					}
+					try {
+						details::EncodeChunk(
+						    input,
+						    chunks[i],
+						    Writer::Params{.Format = output.Format},
+						    Encoder::Params{encoding}
+						);
+					} catch (...) {
+						std::lock_guard<std::mutex> lock{mutex};
+						if (!error) {
+							error = std::current_exception();
+						}
+						// stops the other workers early.
+						next = chunks.size();
+					}
+				}
+			});
+		}
+	} catch (...) {
+		next = chunks.size();
+		joinAll();
+		throw;
+	}
+	joinAll();
+	if (error) {
+		std::rethrow_exception(error);
+	}
+
+	std::vector<Clip> clips;
+	clips.reserve(chunks.size());
+	for (const auto &c : chunks) {
+		clips.push_back({.Path = c.Path});
+	}
+	Remux(std::move(output), clips);
+}
+
+} // namespace video
+} // namespace fort
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+
+#include "Encoder.hpp"
+#include "Types.hpp"
+#include "Writer.hpp"
+
+namespace fort {
+namespace video {
+
+struct TranscodeParams {
+	// Target duration of the chunks encoded in parallel. Chunks are cut on
+	// the input key frames, so they can be longer.
+	video::Duration ChunkDuration = std::chrono::minutes(5);
+	// Number of chunks encoded concurrently, 0 uses the number of cores.
+	// Unless encoding.Threads is set, the cores are shared between jobs.
+	size_t Jobs = 0;
+	// Directory for the temporary chunks, defaults to the output directory,
+	// or to the system temporary directory when writing to a Sink.
+	std::filesystem::path TempDir;
+};
+
+// Re-encodes input into output. The input is split in chunks on its key
+// frames, which are decoded and encoded in parallel in temporary files, and
+// then concatenated without re-encoding with continuous timestamps.
+//
+// If encoding.Size is left to zero, the input size is used. If
+// encoding.Framerate is left to zero, the input average frame rate is used.
+// Input timestamps are preserved within each chunk.
+void Transcode(
+    const std::filesystem::path &input,
+    Writer::Params             &&output,
+    Encoder::Params            &&encoding,
+    const TranscodeParams       &params = {}
+);
+
+} // namespace video
+} // namespace fort
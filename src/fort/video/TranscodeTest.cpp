@@ -0,0 +1,111 @@
+#include <cpptrace/cpptrace.hpp>
+#include <filesystem>
+#include <fort/video/Frame.hpp>
+#include <fort/video/Reader.hpp>
+#include <fort/video/Transcode.hpp>
+#include <fort/video/Writer.hpp>
+#include <gtest/gtest.h>
+#include <string>
+
+extern "C" {
+#include <libavutil/log.h>
+}
+
+namespace fort {
+namespace video {
+
+class TranscodeTest : public ::testing::Test {
+protected:
+	static std::filesystem::path TempDir;
+	constexpr static size_t      LENGTH = 120;
+
+	static void SetUpTestSuite() {
+		std::string tmpDirTemplate = std::filesystem::temp_directory_path() /
+		                             "fort-video-transcode-tests-XXXXXX";
+		TempDir = mkdtemp(const_cast<char *>(tmpDirTemplate.c_str()));
+		av_log_set_level(AV_LOG_QUIET);
+
+		// 5s with a key frame every second.
+		Writer w{
+		    {.Path = TempDir / "input.mp4"},
+		    {
+		        .Size{40, 30},
+		        .ParamKeyValues = "keyint=24:min-keyint=24:scenecut=0",
+		        .Framerate      = {24, 1},
+		        .Format         = AV_PIX_FMT_GRAY8,
+		    },
+		};
+		Frame frame{40, 30, AV_PIX_FMT_GRAY8, 16};
+		for (size_t i = 0; i < LENGTH; i++) {
+			memset(frame.Planes[0], 2 * i, 40 * 30);
+			w.Write(frame);
+		}
+	}
+
+	static void TearDownTestSuite() {
+		std::filesystem::remove_all(TempDir);
+	}
+
+	static void ExpectTranscoded(const std::filesystem::path &path) {
+		Reader r{path};
+		EXPECT_EQ(r.Length(), LENGTH);
+		auto f = r.CreateFrame();
+		for (size_t i = 0; i < LENGTH; ++i) {
+			SCOPED_TRACE("frame " + std::to_string(i));
+			ASSERT_TRUE(r.Read(*f));
+			EXPECT_NEAR(f->Planes[0][0], 2 * i, 2);
+			EXPECT_NEAR(f->PTS.count(), int64_t(i * 1e9) / 24, 1e6);
+		}
+		EXPECT_FALSE(r.Read(*f));
+	}
+};
+
+std::filesystem::path TranscodeTest::TempDir;
+
+TEST_F(TranscodeTest, InParallelChunks) {
+	auto path = TempDir / "chunked.mp4";
+	EXPECT_NO_THROW({
+		Transcode(
+		    TempDir / "input.mp4",
+		    {.Path = path},
+		    {.Format = AV_PIX_FMT_GRAY8, .BitRate = 1024 * 1024},
+		    {.ChunkDuration = std::chrono::seconds(1), .Jobs = 3}
+		);
+	});
+	ExpectTranscoded(path);
+
+	// temporary chunks are removed.
+	for (const auto &entry : std::filesystem::directory_iterator(TempDir)) {
+		EXPECT_EQ(entry.path().string().find(".chunk"), std::string::npos)
+		    << entry.path();
+	}
+}
+
+TEST_F(TranscodeTest, InASingleChunk) {
+	auto path = TempDir / "single.mp4";
+	EXPECT_NO_THROW({
+		Transcode(
+		    TempDir / "input.mp4",
+		    {.Path = path},
+		    {.Format = AV_PIX_FMT_GRAY8}
+		);
+	});
+	ExpectTranscoded(path);
+}
+
+TEST_F(TranscodeTest, ChecksChunkDuration) {
+	EXPECT_THROW(
+	    {
+		    Transcode(
+		        TempDir / "input.mp4",
+		        {.Path = TempDir / "invalid.mp4"},
+		        {.Format = AV_PIX_FMT_GRAY8},
+		        {.ChunkDuration = Duration{0}}
+		    );
+	    },
+	    cpptrace::invalid_argument
+	);
+}
+
+} // namespace video
+} // namespace fort
@@ -37,5 +37,31 @@ struct Resolution {
 	}
 };
 
+// Interpolation used to resize frames, from the fastest to the sharpest.
+// Area is best to downscale, as it averages all covered pixels.
+enum class ScaleAlgorithm {
+	Point,
+	FastBilinear,
+	Bilinear,
+	Area,
+	Bicubic,
+	Gauss,
+	Spline,
+	Lanczos,
+};
+
+// Options of the conversions between sizes and pixel formats.
+struct ScaleOptions {
+	ScaleAlgorithm Algorithm = ScaleAlgorithm::Bilinear;
+	// Rounds exactly rather than with the faster approximations, slower.
+	bool AccurateRounding = false;
+	// Interpolates chroma to full width when producing packed RGB, instead
+	// of repeating subsampled values.
+	bool FullChromaInterpolation = false;
+	// Reads chroma of packed RGB input at full width, instead of
+	// subsampling it first.
+	bool FullChromaInput = false;
+};
+
 } // namespace video
 } // namespace fort
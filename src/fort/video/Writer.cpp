@@ -1,8 +1,13 @@
 #include "Writer.hpp"
 #include "Encoder.hpp"
+#include "TypesIO.hpp"
 #include "details/AVCall.hpp"
-#include <fort/utils/Defer.hpp>
+#include "details/Muxer.hpp"
+#include "details/PTSGenerator.hpp"
+#include <cpptrace/cpptrace.hpp>
 #include <iostream>
+#include <stdexcept>
+#include <utility>
 
 #include <libavutil/mathematics.h>
 #include <memory>
@@ -21,53 +26,181 @@ namespace fort {
 namespace video {
 
 struct Writer::Implementation {
+	Resolution                      d_expectedSize;
+	PixelFormat                     d_expectedFormat = AV_PIX_FMT_NONE;
+	std::unique_ptr<Encoder>        d_encoder;
+	std::unique_ptr<details::Muxer> d_muxer;
+	AVRational                      d_timeBase;
+	details::PTSGenerator           d_pts;
 
-	using AVFormatContextPtr = std::
-	    unique_ptr<AVFormatContext, std::function<void(AVFormatContext *)>>;
+	// only used with an EncoderPool, frames are copied to d_frames so the
+	// caller can reuse its own.
+	std::unique_ptr<EncoderPool::Stream> d_stream;
+	FramePool::Ptr                       d_frames;
 
-	AVFormatContextPtr       d_context;
-	std::unique_ptr<Encoder> d_encoder;
-	AVStream	            *d_stream;
-	int64_t                  d_next = 0;
+	std::unique_ptr<StaticSceneFilter> d_staticScene;
+
+	bool d_closed = false;
 
 	Implementation(Params &&muxerParams, Encoder::Params &&encoderParams)
-	    : d_context{nullptr, [](AVFormatContext *) {}}
-	    , d_encoder{std::make_unique<Encoder>(std::move(encoderParams))} {
-		open(muxerParams);
+	    : d_expectedSize{encoderParams.Size}
+	    , d_expectedFormat{encoderParams.Format}
+	    , d_encoder{newEncoder(muxerParams, std::move(encoderParams))}
+	    , d_muxer{std::make_unique<details::Muxer>(
+	          muxerParams,
+	          d_encoder->CodecContext()
+	      )}
+	    , d_timeBase{d_encoder->CodecContext()->time_base}
+	    , d_pts{muxerParams.UseFramePTS, d_timeBase} {
+		if (muxerParams.SkipStaticFrames) {
+			if (!muxerParams.UseFramePTS) {
+				throw cpptrace::invalid_argument{
+				    "SkipStaticFrames requires UseFramePTS",
+				};
+			}
+			if (!StaticSceneFilter::Supports(d_expectedFormat)) {
+				throw cpptrace::invalid_argument{
+				    "SkipStaticFrames does not support " +
+				    std::to_string(d_expectedFormat),
+				};
+			}
+			d_staticScene = std::make_unique<StaticSceneFilter>(
+			    *muxerParams.SkipStaticFrames
+			);
+		}
+		if (!muxerParams.Pool) {
+			return;
+		}
+		d_stream = std::make_unique<EncoderPool::Stream>(muxerParams.Pool);
+		d_frames = muxerParams.Frames ? muxerParams.Frames
+		                              : FramePool::Default();
+	}
+
+	static std::unique_ptr<Encoder>
+	newEncoder(const Params &muxerParams, Encoder::Params &&encoderParams) {
+		if (muxerParams.Pool && encoderParams.Threads == 0) {
+			encoderParams.Threads = muxerParams.Pool->EncoderThreads();
+		}
+		return std::make_unique<Encoder>(std::move(encoderParams));
 	}
 
+	Implementation(
+	    Params                 &&muxerParams,
+	    const AVCodecParameters *codecpar,
+	    AVRational               timeBase
+	)
+	    : d_muxer{std::make_unique<details::Muxer>(
+	          muxerParams,
+	          codecpar,
+	          timeBase
+	      )}
+	    , d_timeBase{timeBase}
+	    , d_pts{false, timeBase} {}
+
 	~Implementation() {
-		using namespace fort::video::details;
-		d_encoder->Flush();
-		while (true) {
-			auto pkt = d_encoder->Receive();
+		try {
+			Close();
+		} catch (...) {
+		}
+	}
 
-			if (!pkt) {
-				break;
+	void Close() {
+		if (std::exchange(d_closed, true)) {
+			return;
+		}
+		if (d_stream) {
+			d_stream->Wait();
+		}
+		if (d_encoder && d_muxer->Failed() == false) {
+			d_encoder->Flush();
+			while (true) {
+				auto pkt = d_encoder->Receive();
+
+				if (!pkt) {
+					break;
+				}
+
+				Write(pkt.get());
 			}
+		}
+		d_muxer->Close();
+	}
 
-			Write(pkt.get());
+	void Write(AVPacket *pkt) {
+		d_muxer->Write(pkt, d_timeBase);
+	}
+
+	void Write(const Frame &frame, const std::vector<Encoder::Region> &regions) {
+		checkEncoder();
+		if (skip(frame)) {
+			return;
+		}
+		if (d_stream) {
+			checkFrame(frame);
+			submit(SharedFrame::Copy(frame, *d_frames), regions);
+			return;
 		}
+		encode(frame, d_pts(frame), regions);
+	}
 
-		if ((d_context->oformat->flags & AVFMT_NOFILE) == 0 &&
-		    d_context->pb != nullptr) {
-			AVCall(av_write_trailer, d_context.get());
-			avio_closep(&d_context->pb);
+	void
+	Write(const SharedFrame &frame, const std::vector<Encoder::Region> &regions) {
+		checkEncoder();
+		if (skip(*frame)) {
+			return;
+		}
+		if (d_stream) {
+			checkFrame(*frame);
+			submit(frame, regions);
+			return;
 		}
+		encode(*frame, d_pts(*frame), regions);
 	}
 
-	void Write(AVPacket *pkt) {
-		pkt->stream_index = d_stream->index;
-		av_packet_rescale_ts(
-		    pkt,
-		    d_encoder->CodecContext()->time_base,
-		    d_stream->time_base
-		);
-		details::AVCall(av_interleaved_write_frame, d_context.get(), pkt);
+	void checkEncoder() const {
+		if (d_closed) {
+			throw cpptrace::logic_error{"writer is closed"};
+		}
+		if (!d_encoder) {
+			throw cpptrace::logic_error{
+			    "cannot write frames on a stream copy Writer",
+			};
+		}
 	}
 
-	void Write(const Frame &frame) {
-		d_encoder->Send(frame, d_next++);
+	bool skip(const Frame &frame) {
+		if (!d_staticScene) {
+			return false;
+		}
+		checkFrame(frame);
+		return !d_staticScene->Accept(frame);
+	}
+
+	void checkFrame(const Frame &frame) const {
+		if (frame.Format != d_expectedFormat || frame.Size != d_expectedSize) {
+			throw std::invalid_argument{
+			    "invalid input frame {format: " + std::to_string(frame.Format) +
+			    ", size: " + std::to_string(frame.Size) +
+			    "}, expected {format: " + std::to_string(d_expectedFormat) +
+			    ", size: " + std::to_string(d_expectedSize) + "}",
+			};
+		}
+	}
+
+	void
+	submit(const SharedFrame &frame, const std::vector<Encoder::Region> &regions) {
+		d_encoder->ReportBacklog(d_stream->Stats().Queued);
+		d_stream->Submit([this, frame, pts = d_pts(*frame), regions]() {
+			encode(*frame, pts, regions);
+		});
+	}
+
+	void encode(
+	    const Frame                        &frame,
+	    int64_t                             pts,
+	    const std::vector<Encoder::Region> &regions
+	) {
+		d_encoder->Send(frame, pts, false, regions);
 		while (true) {
 			auto pkt = d_encoder->Receive();
 
@@ -78,65 +211,6 @@ struct Writer::Implementation {
 			Write(pkt.get());
 		}
 	}
-
-	void open(const Params &params) {
-		using namespace fort::video::details;
-		AVFormatContext *ctx{nullptr};
-
-		AVCall(
-		    avformat_alloc_output_context2,
-		    &ctx,
-		    nullptr,
-		    nullptr,
-		    params.Path.c_str()
-		);
-
-		d_context = AVFormatContextPtr{ctx, avformat_free_context};
-
-		// we don't use a smart pointer as the stream is owned by the context.
-		d_stream =
-		    AVAlloc<AVStream>(avformat_new_stream, d_context.get(), nullptr);
-
-		d_stream->time_base = d_encoder->CodecContext()->time_base;
-		AVCall(
-		    avcodec_parameters_from_context,
-		    d_stream->codecpar,
-		    d_encoder->CodecContext()
-		);
-
-		if (d_context->oformat->flags & AVFMT_GLOBALHEADER) {
-			d_context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
-		}
-		d_stream->id = d_context->nb_streams - 1;
-
-		if ((d_context->oformat->flags & AVFMT_NOFILE) == 0) {
-			AVCall(
-			    avio_open,
-			    &d_context->pb,
-			    params.Path.c_str(),
-			    AVIO_FLAG_WRITE
-			);
-		}
-
-		AVDictionary *opts{nullptr};
-		defer {
-			if (opts != nullptr) {
-				av_dict_free(&opts);
-			}
-		};
-		if (!params.MuxerOptionKey.empty() &&
-		    !params.MuxerOptionValue.empty()) {
-			AVCall(
-			    av_dict_set,
-			    &opts,
-			    params.MuxerOptionKey.c_str(),
-			    params.MuxerOptionValue.c_str(),
-			    0
-			);
-		}
-
-		AVCall(avformat_write_header, d_context.get(), &opts);
-	}
 };
 
 Writer::Writer(Params &&muxerParams, Encoder::Params &&encoderParams)
@@ -144,14 +218,56 @@ Writer::Writer(Params &&muxerParams, Encoder::Params &&encoderParams)
           std::move(muxerParams), std::move(encoderParams)
       )} {}
 
+Writer::Writer(
+    Params                 &&muxerParams,
+    const AVCodecParameters *codecpar,
+    AVRational               timeBase
+)
+    : self{std::make_unique<Implementation>(
+          std::move(muxerParams), codecpar, timeBase
+      )} {}
+
 Writer::~Writer() = default;
 
 void Writer::Write(AVPacket *pkt) {
 	self->Write(pkt);
 }
 
-void Writer::Write(const Frame &frame) {
-	self->Write(frame);
+void Writer::Write(
+    const Frame &frame, const std::vector<Encoder::Region> &regions
+) {
+	self->Write(frame, regions);
+}
+
+void Writer::Write(
+    const SharedFrame &frame, const std::vector<Encoder::Region> &regions
+) {
+	self->Write(frame, regions);
+}
+
+void Writer::Close() {
+	self->Close();
+}
+
+Encoder::Stats Writer::EncoderStats() const {
+	if (!self->d_encoder) {
+		return {};
+	}
+	return self->d_encoder->GetStats();
+}
+
+StaticSceneFilter::Stats Writer::StaticSceneStats() const {
+	if (!self->d_staticScene) {
+		return {};
+	}
+	return self->d_staticScene->GetStats();
+}
+
+EncoderPool::StreamStats Writer::PoolStats() const {
+	if (!self->d_stream) {
+		return {};
+	}
+	return self->d_stream->Stats();
 }
 
 } // namespace video
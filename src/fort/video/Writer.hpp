@@ -1,9 +1,16 @@
 #pragma once
 
 #include <filesystem>
+#include <map>
+#include <optional>
 
 #include "Encoder.hpp"
+#include "EncoderPool.hpp"
 #include "Frame.hpp"
+#include "FramePool.hpp"
+#include "SharedFrame.hpp"
+#include "Sink.hpp"
+#include "StaticScene.hpp"
 
 namespace fort {
 namespace video {
@@ -14,13 +21,79 @@ public:
 		std::filesystem::path Path;
 		std::string           MuxerOptionKey;
 		std::string           MuxerOptionValue;
+		// Additional muxer options, merged with MuxerOptionKey/Value.
+		std::map<std::string, std::string> MuxerOptions;
+		// Uses Frame::PTS, relative to the first written frame, instead of
+		// the frame count as timestamps. This allows to drop frames, or to
+		// write variable frame rate with a fine Encoder::Params::TimeBase.
+		bool UseFramePTS = false;
+		// Writes a fragmented MP4 (ignored for other containers, which like
+		// MPEG-TS are already streamable) so the file can be read while it is
+		// still written.
+		bool Fragmented = false;
+		// Period at which buffered data is pushed to the file, for readers
+		// following it. Zero flushes after each packet, max() never flushes
+		// before the end.
+		Duration FlushPeriod = Duration::max();
+		// Container short name (e.g. "mpegts"). If empty, it is guessed from
+		// Path extension.
+		std::string Format;
+		// If set, the output is written to this sink instead of Path.
+		std::shared_ptr<video::Sink> Sink;
+		// If set, frames are encoded asynchronously by this pool. Write()
+		// then only copies the frame, and blocks if the stream is too far
+		// behind. Errors are reported by the next Write().
+		std::shared_ptr<EncoderPool> Pool;
+		// Recycles the frame copies made with Pool. Defaults to
+		// FramePool::Default().
+		std::shared_ptr<FramePool> Frames;
+		// If FileBuffer.BufferSize is not zero, Path is written through a
+		// BufferedFileSink with these options. Ignored if Sink is set. The
+		// file is synced and closed by Close(), which reports its errors.
+		BufferedFileSink::Options FileBuffer;
+		// If set, frames too close to the last encoded one are dropped by
+		// Write() before any copy or encoding. It requires UseFramePTS, so
+		// the remaining frames keep their timing.
+		std::optional<StaticSceneFilter::Params> SkipStaticFrames;
 	};
 
 	Writer(Params &&muxerParams, Encoder::Params &&encoderParams);
+	// Creates a Writer without Encoder, that only accepts already encoded
+	// packets with timestamps in timeBase (stream copy).
+	Writer(
+	    Params                 &&muxerParams,
+	    const AVCodecParameters *codecpar,
+	    AVRational               timeBase
+	);
 	~Writer();
 
 	void Write(AVPacket *pkt);
-	void Write(const Frame &frame);
+	// Encodes frame, with an optional set of regions encoded at a different
+	// quality (see Encoder::Send()).
+	void Write(
+	    const Frame &frame, const std::vector<Encoder::Region> &regions = {}
+	);
+	// Same as above, but with an EncoderPool the frame is referenced
+	// instead of copied until it is encoded, so the planes of a view must
+	// stay valid until then.
+	void Write(
+	    const SharedFrame                  &frame,
+	    const std::vector<Encoder::Region> &regions = {}
+	);
+
+	// Encodes the remaining frames, writes the end of the output and closes
+	// it. Errors of these last writes, e.g. of a broken Sink, are only
+	// reported here: the destructor closes the output too, but ignores them.
+	void Close();
+
+	// Returns the statistics of the encoder, empty for stream copy.
+	Encoder::Stats EncoderStats() const;
+
+	// Returns the encoding queue statistics when using an EncoderPool.
+	EncoderPool::StreamStats PoolStats() const;
+
+	// Returns the statistics of Params::SkipStaticFrames, empty if unset.
+	StaticSceneFilter::Stats StaticSceneStats() const;
 
 private:
 	struct Implementation;
@@ -1,3 +1,4 @@
+#include <cpptrace/cpptrace.hpp>
 #include <filesystem>
 #include <fort/video/Encoder.hpp>
 #include <fort/video/Frame.hpp>
@@ -5,6 +6,7 @@
 #include <fort/video/Writer.hpp>
 #include <fstream>
 #include <gtest/gtest.h>
+#include <random>
 #include <string>
 
 extern "C" {
@@ -116,6 +118,35 @@ TEST_F(WriterTest, CanEncodeGray8) {
 	}
 }
 
+TEST_F(WriterTest, CanBeClosedExplicitly) {
+	auto path = TempDir / "closed.mp4";
+	Writer w{
+	    Writer::Params{.Path = path},
+	    Encoder::Params{
+	        .Size{40, 30},
+	        .Framerate = {24, 1},
+	        .Format    = AV_PIX_FMT_GRAY8,
+	    }};
+
+	Frame frame{40, 30, AV_PIX_FMT_GRAY8, 16};
+	for (int i = 0; i < 10; i++) {
+		memset(frame.Planes[0], 10 * i, 40 * 30);
+		w.Write(frame);
+	}
+	w.Close();
+	EXPECT_THROW(w.Write(frame), cpptrace::logic_error);
+
+	// the file is complete before the Writer is destroyed.
+	Reader r{path};
+	EXPECT_EQ(r.Length(), 10);
+	auto f = r.CreateFrame();
+	for (size_t i = 0; i < 10; i++) {
+		SCOPED_TRACE(std::to_string(i));
+		ASSERT_TRUE(r.Read(*f));
+		EXPECT_NEAR(f->Planes[0][0], 10 * i, 1);
+	}
+}
+
 TEST_F(WriterTest, CanEncodeYUV) {
 	auto path = TempDir / "generated-yuv.mp4";
 	{
@@ -164,5 +195,545 @@ TEST_F(WriterTest, CanEncodeYUV) {
 	}
 }
 
+TEST_F(WriterTest, HonorsFramePTSWhenDroppingFrames) {
+	auto             path = TempDir / "generated-dropped.mp4";
+	std::vector<int> written;
+	{
+		Writer w{
+		    Writer::Params{.Path = path, .UseFramePTS = true},
+		    Encoder::Params{
+		        .Size{40, 30},
+		        .Framerate = {24, 1},
+		        .Format    = AV_PIX_FMT_GRAY8,
+		    }};
+
+		Frame frame{40, 30, AV_PIX_FMT_GRAY8, 16};
+		for (int i = 0; i < 96; i++) {
+			// drops one frame every two in the middle of the sequence.
+			if (i >= 24 && i < 72 && i % 2 == 1) {
+				continue;
+			}
+			memset(frame.Planes[0], i, 40 * 30);
+			frame.PTS = Duration{int64_t(i * 1e9) / 24};
+			w.Write(frame);
+			written.push_back(i);
+		}
+	}
+
+	Reader r{path};
+	auto   f = r.CreateFrame();
+	for (int i : written) {
+		SCOPED_TRACE(std::to_string(i));
+		ASSERT_TRUE(r.Read(*f));
+		EXPECT_NEAR(f->Planes[0][0], i, 1);
+		EXPECT_NEAR(f->PTS.count(), int64_t(i * 1e9) / 24, 1e6);
+	}
+	EXPECT_FALSE(r.Read(*f));
+}
+
+TEST_F(WriterTest, CanSkipStaticFrames) {
+	auto path = TempDir / "static.mp4";
+	{
+		Writer w{
+		    {
+		        .Path             = path,
+		        .UseFramePTS      = true,
+		        .SkipStaticFrames = StaticSceneFilter::Params{},
+		    },
+		    {
+		        .Size{40, 30},
+		        .Framerate = {24, 1},
+		        .Format    = AV_PIX_FMT_GRAY8,
+		    },
+		};
+
+		Frame frame{40, 30, AV_PIX_FMT_GRAY8};
+		for (int i = 0; i < 48; i++) {
+			// the scene only changes every 8 frames.
+			memset(frame.Planes[0], 20 * (i / 8), frame.Linesize[0] * 30);
+			frame.PTS = Duration{int64_t(i * 1e9) / 24};
+			w.Write(frame);
+		}
+		EXPECT_EQ(w.StaticSceneStats().Frames, 48);
+		EXPECT_EQ(w.StaticSceneStats().Skipped, 42);
+	}
+
+	Reader r{path};
+	auto   f = r.CreateFrame();
+	for (int i = 0; i < 48; i += 8) {
+		SCOPED_TRACE(std::to_string(i));
+		ASSERT_TRUE(r.Read(*f));
+		EXPECT_NEAR(f->Planes[0][0], 20 * (i / 8), 2);
+		EXPECT_NEAR(f->PTS.count(), int64_t(i * 1e9) / 24, 1e6);
+	}
+	EXPECT_FALSE(r.Read(*f));
+
+	EXPECT_THROW(
+	    (Writer{
+	        {
+	            .Path             = path,
+	            .SkipStaticFrames = StaticSceneFilter::Params{},
+	        },
+	        {
+	            .Size{40, 30},
+	            .Framerate = {24, 1},
+	            .Format    = AV_PIX_FMT_GRAY8,
+	        },
+	    }),
+	    cpptrace::invalid_argument
+	);
+}
+
+TEST_F(WriterTest, CanWriteSubViews) {
+	auto path = TempDir / "subviews.mp4";
+	{
+		Writer w{
+		    {.Path = path},
+		    {
+		        .Size{40, 30},
+		        .Framerate = {24, 1},
+		        .Format    = AV_PIX_FMT_GRAY8,
+		    },
+		};
+		// only the center of the frame is written.
+		Frame frame{80, 60, AV_PIX_FMT_GRAY8};
+		for (int i = 0; i < 24; i++) {
+			memset(frame.Planes[0], 255, frame.Linesize[0] * 60);
+			auto center = frame.SubView(20, 16, 40, 30);
+			for (int y = 0; y < 30; ++y) {
+				memset(center.Planes[0] + y * center.Linesize[0], 4 * i, 40);
+			}
+			w.Write(center);
+		}
+	}
+
+	Reader r{path};
+	auto   f = r.CreateFrame();
+	for (int i = 0; i < 24; i++) {
+		ASSERT_TRUE(r.Read(*f));
+		EXPECT_NEAR(f->Planes[0][0], 4 * i, 2);
+		EXPECT_NEAR(f->Planes[0][29 * f->Linesize[0] + 39], 4 * i, 2);
+	}
+}
+
+TEST_F(WriterTest, RecyclesPooledFrameCopies) {
+	auto frames = FramePool::Create();
+	{
+		Writer w{
+		    {
+		        .Path   = TempDir / "recycled.mp4",
+		        .Pool   = std::make_shared<EncoderPool>(),
+		        .Frames = frames,
+		    },
+		    {
+		        .Size{40, 30},
+		        .Framerate = {24, 1},
+		        .Format    = AV_PIX_FMT_GRAY8,
+		    },
+		};
+		Frame frame{40, 30, AV_PIX_FMT_GRAY8, 16};
+		for (int i = 0; i < 48; i++) {
+			memset(frame.Planes[0], i, 40 * 30);
+			w.Write(frame);
+		}
+	}
+	auto stats = frames->GetStats();
+	EXPECT_GT(stats.Allocated, 0);
+	// at most the queued frames, the one being encoded and the one being
+	// submitted.
+	EXPECT_LE(stats.HighWaterMark, 4 + 2);
+	EXPECT_EQ(stats.Allocated, stats.HighWaterMark);
+	EXPECT_EQ(stats.InUse, 0);
+}
+
+TEST_F(WriterTest, ReferencesSharedFrames) {
+	auto frames = FramePool::Create();
+	auto path   = TempDir / "shared.mp4";
+	{
+		Writer w{
+		    {
+		        .Path   = path,
+		        .Pool   = std::make_shared<EncoderPool>(),
+		        .Frames = frames,
+		    },
+		    {
+		        .Size{40, 30},
+		        .Framerate = {24, 1},
+		        .Format    = AV_PIX_FMT_GRAY8,
+		    },
+		};
+		for (int i = 0; i < 24; i++) {
+			SharedFrame frame{Frame{40, 30, AV_PIX_FMT_GRAY8}};
+			memset(frame.Mutable().Planes[0], 4 * i, frame->Linesize[0] * 30);
+			w.Write(frame);
+		}
+	}
+	// no copy was made.
+	EXPECT_EQ(frames->GetStats().Allocated, 0);
+
+	Reader r{path};
+	auto   f = r.CreateFrame();
+	for (int i = 0; i < 24; i++) {
+		ASSERT_TRUE(r.Read(*f));
+		EXPECT_NEAR(f->Planes[0][0], 4 * i, 2);
+	}
+}
+
+TEST_F(WriterTest, CanShareAnEncoderPool) {
+	auto pool = std::make_shared<EncoderPool>(EncoderPool::Params{
+	    .Workers = 2,
+	});
+	constexpr size_t STREAMS = 6;
+	{
+		std::vector<std::unique_ptr<Writer>> writers;
+		for (size_t i = 0; i < STREAMS; ++i) {
+			writers.push_back(std::make_unique<Writer>(
+			    Writer::Params{
+			        .Path = TempDir / ("pooled-" + std::to_string(i) + ".mp4"),
+			        .Pool = pool,
+			    },
+			    Encoder::Params{
+			        .Size{40, 30},
+			        .Framerate = {24, 1},
+			        .Format    = AV_PIX_FMT_GRAY8,
+			    }
+			));
+		}
+
+		Frame frame{40, 30, AV_PIX_FMT_GRAY8, 16};
+		for (int i = 0; i < 48; i++) {
+			for (size_t j = 0; j < STREAMS; ++j) {
+				// the frame is reused right away, the writer must copy it.
+				memset(frame.Planes[0], i + j, 40 * 30);
+				writers[j]->Write(frame);
+			}
+		}
+		for (const auto &w : writers) {
+			EXPECT_LE(w->PoolStats().Queued, 4);
+		}
+	}
+
+	for (size_t j = 0; j < STREAMS; ++j) {
+		SCOPED_TRACE("stream " + std::to_string(j));
+		Reader r{TempDir / ("pooled-" + std::to_string(j) + ".mp4")};
+		auto   f = r.CreateFrame();
+		for (int i = 0; i < 48; i++) {
+			ASSERT_TRUE(r.Read(*f));
+			EXPECT_NEAR(f->Planes[0][0], i + j, 1);
+		}
+		EXPECT_FALSE(r.Read(*f));
+	}
+}
+
+TEST_F(WriterTest, RegionsOfInterestImproveQuality) {
+	auto                               path = TempDir / "roi.mp4";
+	constexpr int                      W = 160, H = 120, COUNT = 24;
+	std::vector<std::vector<uint8_t>>  images;
+	std::mt19937                       rng{0};
+	std::uniform_int_distribution<int> dist{0, 255};
+	{
+		// a low bitrate for a noisy content, so the quality is limited.
+		Writer w{
+		    {.Path = path},
+		    {
+		        .Size{W, H},
+		        .Framerate = {24, 1},
+		        .Format    = AV_PIX_FMT_GRAY8,
+		        .BitRate   = 100 * 1024,
+		    },
+		};
+		Frame frame{W, H, AV_PIX_FMT_GRAY8, 16};
+		for (int i = 0; i < COUNT; ++i) {
+			auto &image = images.emplace_back(W * H);
+			for (auto &v : image) {
+				v = dist(rng);
+			}
+			for (int y = 0; y < H; ++y) {
+				std::copy_n(
+				    image.data() + y * W,
+				    W,
+				    frame.Planes[0] + y * frame.Linesize[0]
+				);
+			}
+			// left half is sharp.
+			w.Write(
+			    frame,
+			    {{
+			        .X             = 0,
+			        .Y             = 0,
+			        .Width         = W / 2,
+			        .Height        = H,
+			        .QualityOffset = -1.0f,
+			    }}
+			);
+		}
+	}
+
+	Reader r{path};
+	auto   f = r.CreateFrame();
+	double errors[2]{0.0, 0.0};
+	for (const auto &image : images) {
+		ASSERT_TRUE(r.Read(*f));
+		for (int y = 0; y < H; ++y) {
+			for (int x = 0; x < W; ++x) {
+				const int decoded = f->Planes[0][y * f->Linesize[0] + x];
+				errors[x * 2 / W] += std::abs(decoded - image[y * W + x]);
+			}
+		}
+	}
+	EXPECT_LT(errors[0], 0.8 * errors[1]);
+}
+
+TEST_F(WriterTest, ChecksRegionsOfInterest) {
+	Writer w{
+	    {.Path = TempDir / "roi-invalid.mp4"},
+	    {
+	        .Size{40, 30},
+	        .Framerate = {24, 1},
+	        .Format    = AV_PIX_FMT_GRAY8,
+	    },
+	};
+	Frame frame{40, 30, AV_PIX_FMT_GRAY8, 16};
+	EXPECT_THROW(
+	    {
+		    w.Write(
+		        frame,
+		        {{
+		            .X             = 0,
+		            .Y             = 0,
+		            .Width         = 10,
+		            .Height        = 10,
+		            .QualityOffset = 2.0f,
+		        }}
+		    );
+	    },
+	    std::invalid_argument
+	);
+	// regions outside of the frame are ignored.
+	EXPECT_NO_THROW({
+		w.Write(
+		    frame,
+		    {{
+		        .X             = 100,
+		        .Y             = 100,
+		        .Width         = 10,
+		        .Height        = 10,
+		        .QualityOffset = -0.5f,
+		    }}
+		);
+	});
+}
+
+TEST_F(WriterTest, AdaptsEncodingLevel) {
+	// all with B-frames, unlike "ultrafast".
+	const std::vector<Encoder::Level> levels = {
+	    {.Preset = "medium"},
+	    {.Preset = "veryfast", .Threads = 1},
+	    {.Preset = "superfast", .Threads = 1},
+	};
+	struct TestData {
+		std::string                 Name;
+		Encoder::Adaptation         Adaptive;
+		size_t                      FinalLevel;
+		std::vector<Encoder::LevelSwitch> Expected;
+	};
+
+	for (const auto &d : std::vector<TestData>{
+	         {
+	             .Name = "faster",
+	             // any load is too much.
+	             .Adaptive{.Levels = levels, .Period = 10, .HighLoad = 0.0f},
+	             .FinalLevel = 2,
+	             .Expected   = {{.Frame = 10, .From = 0, .To = 1},
+	                            {.Frame = 20, .From = 1, .To = 2}},
+	         },
+	         {
+	             .Name = "slower",
+	             // the encoder is always idle enough.
+	             .Adaptive{
+	                 .Levels   = levels,
+	                 .Initial  = 2,
+	                 .Period   = 20,
+	                 .HighLoad = 1e9f,
+	                 .LowLoad  = 1e9f,
+	             },
+	             .FinalLevel = 0,
+	             .Expected   = {{.Frame = 20, .From = 2, .To = 1},
+	                            {.Frame = 40, .From = 1, .To = 0}},
+	         },
+	     }) {
+		SCOPED_TRACE(d.Name);
+		auto path = TempDir / ("adaptive-" + d.Name + ".mp4");
+		{
+			Writer w{
+			    {.Path = path},
+			    {
+			        .Size{40, 30},
+			        .Framerate = {24, 1},
+			        .Format    = AV_PIX_FMT_GRAY8,
+			        .Adaptive  = d.Adaptive,
+			    },
+			};
+			Frame frame{40, 30, AV_PIX_FMT_GRAY8, 16};
+			for (int i = 0; i < 48; i++) {
+				memset(frame.Planes[0], i, 40 * 30);
+				w.Write(frame);
+			}
+			auto stats = w.EncoderStats();
+			EXPECT_EQ(stats.Level, d.FinalLevel);
+			ASSERT_EQ(stats.Switches.size(), d.Expected.size());
+			for (size_t i = 0; i < d.Expected.size(); ++i) {
+				EXPECT_EQ(stats.Switches[i].Frame, d.Expected[i].Frame);
+				EXPECT_EQ(stats.Switches[i].From, d.Expected[i].From);
+				EXPECT_EQ(stats.Switches[i].To, d.Expected[i].To);
+			}
+		}
+
+		// the output stays readable across switches.
+		Reader r{path};
+		auto   f = r.CreateFrame();
+		for (int i = 0; i < 48; i++) {
+			SCOPED_TRACE(std::to_string(i));
+			ASSERT_TRUE(r.Read(*f));
+			EXPECT_NEAR(f->Planes[0][0], i, 1);
+		}
+		EXPECT_FALSE(r.Read(*f));
+	}
+}
+
+TEST_F(WriterTest, AdaptationLevelsMustShareTheReorderDelay) {
+	EXPECT_THROW(
+	    {
+		    Writer w(
+		        {.Path = TempDir / "adaptive-invalid.mp4"},
+		        {
+		            .Size{40, 30},
+		            .Framerate = {24, 1},
+		            .Format    = AV_PIX_FMT_GRAY8,
+		            .Adaptive{
+		                .Levels = {
+		                    {.Preset = "veryfast"},
+		                    {.Preset = "ultrafast"},
+		                },
+		            },
+		        }
+		    );
+	    },
+	    cpptrace::invalid_argument
+	);
+}
+
+TEST_F(WriterTest, ReportsEncoderStats) {
+	Writer w{
+	    {.Path = TempDir / "stats.mp4"},
+	    {
+	        .Size{40, 30},
+	        .Framerate = {24, 1},
+	        .Format    = AV_PIX_FMT_GRAY8,
+	    },
+	};
+	Frame frame{40, 30, AV_PIX_FMT_GRAY8, 16};
+	for (int i = 0; i < 96; i++) {
+		memset(frame.Planes[0], i, 40 * 30);
+		w.Write(frame);
+	}
+
+	auto stats = w.EncoderStats();
+	EXPECT_GT(stats.Packets, 0);
+	EXPECT_EQ(stats.Packets + stats.InFlight, 96);
+	EXPECT_GE(stats.MaxInFlight, stats.InFlight);
+	EXPECT_GT(stats.Bytes, 0);
+	// keyint is 60.
+	EXPECT_GE(stats.IFrames, 1);
+	EXPECT_EQ(stats.IFrames + stats.PFrames + stats.BFrames, stats.Packets);
+	size_t latencies = 0;
+	for (auto count : stats.Latency) {
+		latencies += count;
+	}
+	EXPECT_EQ(latencies, stats.Packets);
+	EXPECT_LE(stats.MeanLatency, stats.MaxLatency);
+	EXPECT_GT(stats.BitRates[0], 0);
+	// the stream is shorter than the largest window.
+	EXPECT_LE(stats.BitRates[2], stats.BitRates[1]);
+}
+
+TEST_F(WriterTest, CanWriteVariableFrameRate) {
+	auto                 path = TempDir / "generated-vfr.mp4";
+	std::vector<int64_t> timestamps;
+	{
+		Writer w{
+		    Writer::Params{.Path = path, .UseFramePTS = true},
+		    Encoder::Params{
+		        .Size{40, 30},
+		        .Framerate = {24, 1},
+		        .TimeBase  = {1, 1000},
+		        .Format    = AV_PIX_FMT_GRAY8,
+		    }};
+
+		Frame   frame{40, 30, AV_PIX_FMT_GRAY8, 16};
+		int64_t ms = 0;
+		for (int i = 0; i < 60; i++) {
+			memset(frame.Planes[0], 4 * i, 40 * 30);
+			frame.PTS = std::chrono::milliseconds{ms};
+			w.Write(frame);
+			timestamps.push_back(ms);
+			ms += 30 + 17 * (i % 3);
+		}
+	}
+
+	Reader r{path};
+	auto   f = r.CreateFrame();
+	for (size_t i = 0; i < timestamps.size(); ++i) {
+		SCOPED_TRACE(std::to_string(i));
+		ASSERT_TRUE(r.Read(*f));
+		EXPECT_NEAR(f->Planes[0][0], 4 * i, 1);
+		EXPECT_NEAR(f->PTS.count(), timestamps[i] * 1000000, 1e6);
+	}
+	EXPECT_FALSE(r.Read(*f));
+}
+
+class WriterStreamingTest : public WriterTest,
+                            public ::testing::WithParamInterface<std::string> {
+};
+
+TEST_P(WriterStreamingTest, CanBeReadWhileWriting) {
+	auto path = TempDir / ("generated-streaming." + GetParam());
+
+	Writer w{
+	    Writer::Params{
+	        .Path         = path,
+	        .MuxerOptions = {{"flush_packets", "1"}},
+	        .Fragmented   = true,
+	        .FlushPeriod  = Duration{0},
+	    },
+	    Encoder::Params{
+	        .Size{40, 30},
+	        .Framerate = {24, 1},
+	        .Format    = AV_PIX_FMT_GRAY8,
+	    }};
+
+	Frame frame{40, 30, AV_PIX_FMT_GRAY8, 16};
+	for (int i = 0; i < 200; i++) {
+		memset(frame.Planes[0], i, 40 * 30);
+		w.Write(frame);
+	}
+
+	// the encoder delays some frames, but most of them must be readable
+	// before the writer is closed.
+	Reader r{path};
+	auto   f     = r.CreateFrame();
+	int    count = 0;
+	while (r.Read(*f)) {
+		SCOPED_TRACE(std::to_string(count));
+		EXPECT_NEAR(f->Planes[0][0], count, 1);
+		++count;
+	}
+	EXPECT_GT(count, 50);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Containers, WriterStreamingTest, ::testing::Values("mp4", "ts")
+);
+
 } // namespace video
 } // namespace fort
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <fort/video/SIMD.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FORT_VIDEO_HAS_X86 1
+// SIMD kernels are compiled for their instruction set with this attribute,
+// and only called if BestSIMDLevel() supports it.
+#define FORT_VIDEO_TARGET(t) __attribute__((target(t)))
+#endif
+
+namespace fort {
+namespace video {
+namespace details {
+
+using video::BestSIMDLevel;
+using video::SIMDLevel;
+
+} // namespace details
+} // namespace video
+} // namespace fort
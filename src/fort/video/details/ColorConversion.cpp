@@ -0,0 +1,481 @@
+#include "ColorConversion.hpp"
+
+#include <algorithm>
+
+#include "CPU.hpp"
+
+#ifdef FORT_VIDEO_HAS_X86
+#include <immintrin.h>
+#endif
+
+namespace fort {
+namespace video {
+namespace details {
+
+namespace {
+// BT.601 limited range coefficients, scaled by 2^15. Chroma coefficients sum
+// to zero so that greys map exactly to 128.
+constexpr int32_t YR = 8414, YG = 16519, YB = 3208;
+constexpr int32_t UR = -4857, UG = -9535, UB = 14392;
+constexpr int32_t VR = 14392, VG = -12052, VB = -2340;
+
+constexpr int32_t LumaShift   = 15;
+constexpr int32_t LumaBias    = (16 << LumaShift) + (1 << (LumaShift - 1));
+// chroma is computed on the sum of a 2x2 block, hence the two extra bits.
+constexpr int32_t ChromaShift = LumaShift + 2;
+constexpr int32_t ChromaBias  = (128 << ChromaShift) + (1 << (ChromaShift - 1));
+
+template <bool BGR> struct Layout {
+	constexpr static int R = BGR ? 2 : 0;
+	constexpr static int G = 1;
+	constexpr static int B = BGR ? 0 : 2;
+};
+
+inline uint8_t luma(int32_t r, int32_t g, int32_t b) noexcept {
+	return (YR * r + YG * g + YB * b + LumaBias) >> LumaShift;
+}
+
+template <bool BGR>
+inline void convertScalar(
+    const uint8_t *row0,
+    const uint8_t *row1,
+    uint8_t       *y0,
+    uint8_t       *y1,
+    uint8_t       *u,
+    uint8_t       *v,
+    int            x,
+    int            width
+) noexcept {
+	using L = Layout<BGR>;
+	for (; x < width; x += 2) {
+		const int      x1 = std::min(x + 1, width - 1);
+		const uint8_t *p00 = row0 + 3 * x, *p01 = row0 + 3 * x1;
+		const uint8_t *p10 = row1 + 3 * x, *p11 = row1 + 3 * x1;
+
+		y0[x] = luma(p00[L::R], p00[L::G], p00[L::B]);
+		y1[x] = luma(p10[L::R], p10[L::G], p10[L::B]);
+		if (x1 != x) {
+			y0[x1] = luma(p01[L::R], p01[L::G], p01[L::B]);
+			y1[x1] = luma(p11[L::R], p11[L::G], p11[L::B]);
+		}
+
+		const int32_t r = p00[L::R] + p01[L::R] + p10[L::R] + p11[L::R];
+		const int32_t g = p00[L::G] + p01[L::G] + p10[L::G] + p11[L::G];
+		const int32_t b = p00[L::B] + p01[L::B] + p10[L::B] + p11[L::B];
+
+		u[x / 2] = (UR * r + UG * g + UB * b + ChromaBias) >> ChromaShift;
+		v[x / 2] = (VR * r + VG * g + VB * b + ChromaBias) >> ChromaShift;
+	}
+}
+
+template <bool BGR>
+void convertRowScalar(
+    const uint8_t *row0,
+    const uint8_t *row1,
+    uint8_t       *y0,
+    uint8_t       *y1,
+    uint8_t       *u,
+    uint8_t       *v,
+    int            width
+) noexcept {
+	convertScalar<BGR>(row0, row1, y0, y1, u, v, 0, width);
+}
+
+#ifdef FORT_VIDEO_HAS_X86
+
+struct Channels {
+	__m128i C0, C1, C2;
+};
+
+// Splits 16 packed 3-bytes pixels in three 16 bytes channels.
+FORT_VIDEO_TARGET("sse4.1")
+inline Channels deinterleave16(const uint8_t *p) noexcept {
+	const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+	const __m128i b =
+	    _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16));
+	const __m128i c =
+	    _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 32));
+
+	// clang-format off
+	const __m128i a0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i b0 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+	const __m128i c0 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+	const __m128i a1 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+	const __m128i c1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+	const __m128i a2 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+	const __m128i c2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+	// clang-format on
+
+	return {
+	    .C0 = _mm_or_si128(
+	        _mm_or_si128(_mm_shuffle_epi8(a, a0), _mm_shuffle_epi8(b, b0)),
+	        _mm_shuffle_epi8(c, c0)
+	    ),
+	    .C1 = _mm_or_si128(
+	        _mm_or_si128(_mm_shuffle_epi8(a, a1), _mm_shuffle_epi8(b, b1)),
+	        _mm_shuffle_epi8(c, c1)
+	    ),
+	    .C2 = _mm_or_si128(
+	        _mm_or_si128(_mm_shuffle_epi8(a, a2), _mm_shuffle_epi8(b, b2)),
+	        _mm_shuffle_epi8(c, c2)
+	    ),
+	};
+}
+
+// Computes a weighted sum of 4 16-bits r,g,b lanes in 32-bits:
+// (cr*r + cg*g + cb*b + bias) >> shift
+FORT_VIDEO_TARGET("sse4.1")
+inline __m128i weighted4(
+    __m128i rg, __m128i bz, __m128i crg, __m128i cb, __m128i bias, int shift
+) noexcept {
+	return _mm_srai_epi32(
+	    _mm_add_epi32(
+	        _mm_add_epi32(_mm_madd_epi16(rg, crg), _mm_madd_epi16(bz, cb)),
+	        bias
+	    ),
+	    shift
+	);
+}
+
+// Computes 8 16-bits results from 8 16-bits r,g,b lanes.
+FORT_VIDEO_TARGET("sse4.1")
+inline __m128i weighted8(
+    __m128i r, __m128i g, __m128i b, __m128i crg, __m128i cb, __m128i bias, int shift
+) noexcept {
+	const __m128i zero = _mm_setzero_si128();
+
+	return _mm_packs_epi32(
+	    weighted4(
+	        _mm_unpacklo_epi16(r, g),
+	        _mm_unpacklo_epi16(b, zero),
+	        crg,
+	        cb,
+	        bias,
+	        shift
+	    ),
+	    weighted4(
+	        _mm_unpackhi_epi16(r, g),
+	        _mm_unpackhi_epi16(b, zero),
+	        crg,
+	        cb,
+	        bias,
+	        shift
+	    )
+	);
+}
+
+FORT_VIDEO_TARGET("sse4.1")
+inline __m128i pair(int32_t a, int32_t b) noexcept {
+	return _mm_set1_epi32((a & 0xffff) | (b << 16));
+}
+
+FORT_VIDEO_TARGET("sse4.1")
+inline __m128i luma16(__m128i r, __m128i g, __m128i b) noexcept {
+	const __m128i crg  = pair(YR, YG);
+	const __m128i cb   = pair(YB, 0);
+	const __m128i bias = _mm_set1_epi32(LumaBias);
+	const __m128i zero = _mm_setzero_si128();
+
+	const __m128i lo = weighted8(
+	    _mm_cvtepu8_epi16(r),
+	    _mm_cvtepu8_epi16(g),
+	    _mm_cvtepu8_epi16(b),
+	    crg,
+	    cb,
+	    bias,
+	    LumaShift
+	);
+	const __m128i hi = weighted8(
+	    _mm_unpackhi_epi8(r, zero),
+	    _mm_unpackhi_epi8(g, zero),
+	    _mm_unpackhi_epi8(b, zero),
+	    crg,
+	    cb,
+	    bias,
+	    LumaShift
+	);
+	return _mm_packus_epi16(lo, hi);
+}
+
+template <bool BGR>
+FORT_VIDEO_TARGET("sse4.1")
+void convertRowSSE41(
+    const uint8_t *row0,
+    const uint8_t *row1,
+    uint8_t       *y0,
+    uint8_t       *y1,
+    uint8_t       *u,
+    uint8_t       *v,
+    int            width
+) noexcept {
+	const __m128i ones   = _mm_set1_epi8(1);
+	const __m128i cuRG   = pair(UR, UG);
+	const __m128i cuB    = pair(UB, 0);
+	const __m128i cvRG   = pair(VR, VG);
+	const __m128i cvB    = pair(VB, 0);
+	const __m128i cbias  = _mm_set1_epi32(ChromaBias);
+
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		auto top    = deinterleave16(row0 + 3 * x);
+		auto bottom = deinterleave16(row1 + 3 * x);
+		if constexpr (BGR) {
+			std::swap(top.C0, top.C2);
+			std::swap(bottom.C0, bottom.C2);
+		}
+
+		_mm_storeu_si128(
+		    reinterpret_cast<__m128i *>(y0 + x),
+		    luma16(top.C0, top.C1, top.C2)
+		);
+		_mm_storeu_si128(
+		    reinterpret_cast<__m128i *>(y1 + x),
+		    luma16(bottom.C0, bottom.C1, bottom.C2)
+		);
+
+		// sums of each 2x2 block, as 8 16-bits lanes.
+		const __m128i r = _mm_add_epi16(
+		    _mm_maddubs_epi16(top.C0, ones),
+		    _mm_maddubs_epi16(bottom.C0, ones)
+		);
+		const __m128i g = _mm_add_epi16(
+		    _mm_maddubs_epi16(top.C1, ones),
+		    _mm_maddubs_epi16(bottom.C1, ones)
+		);
+		const __m128i b = _mm_add_epi16(
+		    _mm_maddubs_epi16(top.C2, ones),
+		    _mm_maddubs_epi16(bottom.C2, ones)
+		);
+
+		const __m128i cu = weighted8(r, g, b, cuRG, cuB, cbias, ChromaShift);
+		const __m128i cv = weighted8(r, g, b, cvRG, cvB, cbias, ChromaShift);
+		_mm_storel_epi64(
+		    reinterpret_cast<__m128i *>(u + x / 2),
+		    _mm_packus_epi16(cu, cu)
+		);
+		_mm_storel_epi64(
+		    reinterpret_cast<__m128i *>(v + x / 2),
+		    _mm_packus_epi16(cv, cv)
+		);
+	}
+	convertScalar<BGR>(row0, row1, y0, y1, u, v, x, width);
+}
+
+FORT_VIDEO_TARGET("avx2")
+inline __m256i weighted16(
+    __m256i r, __m256i g, __m256i b, __m256i crg, __m256i cb, __m256i bias, int shift
+) noexcept {
+	const __m256i zero = _mm256_setzero_si256();
+	// unpack and packs are both lane-wise, so the result stays in order.
+	const __m256i lo   = _mm256_srai_epi32(
+        _mm256_add_epi32(
+            _mm256_add_epi32(
+                _mm256_madd_epi16(_mm256_unpacklo_epi16(r, g), crg),
+                _mm256_madd_epi16(_mm256_unpacklo_epi16(b, zero), cb)
+            ),
+            bias
+        ),
+        shift
+    );
+	const __m256i hi = _mm256_srai_epi32(
+	    _mm256_add_epi32(
+	        _mm256_add_epi32(
+	            _mm256_madd_epi16(_mm256_unpackhi_epi16(r, g), crg),
+	            _mm256_madd_epi16(_mm256_unpackhi_epi16(b, zero), cb)
+	        ),
+	        bias
+	    ),
+	    shift
+	);
+	return _mm256_packs_epi32(lo, hi);
+}
+
+FORT_VIDEO_TARGET("avx2")
+inline __m256i pair256(int32_t a, int32_t b) noexcept {
+	return _mm256_set1_epi32((a & 0xffff) | (b << 16));
+}
+
+FORT_VIDEO_TARGET("avx2")
+inline __m256i luma32(__m256i r, __m256i g, __m256i b) noexcept {
+	const __m256i crg  = pair256(YR, YG);
+	const __m256i cb   = pair256(YB, 0);
+	const __m256i bias = _mm256_set1_epi32(LumaBias);
+
+	const __m256i lo = weighted16(
+	    _mm256_cvtepu8_epi16(_mm256_castsi256_si128(r)),
+	    _mm256_cvtepu8_epi16(_mm256_castsi256_si128(g)),
+	    _mm256_cvtepu8_epi16(_mm256_castsi256_si128(b)),
+	    crg,
+	    cb,
+	    bias,
+	    LumaShift
+	);
+	const __m256i hi = weighted16(
+	    _mm256_cvtepu8_epi16(_mm256_extracti128_si256(r, 1)),
+	    _mm256_cvtepu8_epi16(_mm256_extracti128_si256(g, 1)),
+	    _mm256_cvtepu8_epi16(_mm256_extracti128_si256(b, 1)),
+	    crg,
+	    cb,
+	    bias,
+	    LumaShift
+	);
+	return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+}
+
+template <bool BGR>
+FORT_VIDEO_TARGET("avx2")
+inline void load32(const uint8_t *p, __m256i &r, __m256i &g, __m256i &b) noexcept {
+	auto lo = deinterleave16(p);
+	auto hi = deinterleave16(p + 48);
+	if constexpr (BGR) {
+		std::swap(lo.C0, lo.C2);
+		std::swap(hi.C0, hi.C2);
+	}
+	r = _mm256_set_m128i(hi.C0, lo.C0);
+	g = _mm256_set_m128i(hi.C1, lo.C1);
+	b = _mm256_set_m128i(hi.C2, lo.C2);
+}
+
+template <bool BGR>
+FORT_VIDEO_TARGET("avx2")
+void convertRowAVX2(
+    const uint8_t *row0,
+    const uint8_t *row1,
+    uint8_t       *y0,
+    uint8_t       *y1,
+    uint8_t       *u,
+    uint8_t       *v,
+    int            width
+) noexcept {
+	const __m256i ones  = _mm256_set1_epi8(1);
+	const __m256i cuRG  = pair256(UR, UG);
+	const __m256i cuB   = pair256(UB, 0);
+	const __m256i cvRG  = pair256(VR, VG);
+	const __m256i cvB   = pair256(VB, 0);
+	const __m256i cbias = _mm256_set1_epi32(ChromaBias);
+
+	int x = 0;
+	for (; x + 32 <= width; x += 32) {
+		__m256i r0, g0, b0, r1, g1, b1;
+		load32<BGR>(row0 + 3 * x, r0, g0, b0);
+		load32<BGR>(row1 + 3 * x, r1, g1, b1);
+
+		_mm256_storeu_si256(
+		    reinterpret_cast<__m256i *>(y0 + x),
+		    luma32(r0, g0, b0)
+		);
+		_mm256_storeu_si256(
+		    reinterpret_cast<__m256i *>(y1 + x),
+		    luma32(r1, g1, b1)
+		);
+
+		// maddubs is lane-wise, each lane holds 16 consecutive pixels, so the
+		// 16 sums are in order.
+		const __m256i r = _mm256_add_epi16(
+		    _mm256_maddubs_epi16(r0, ones),
+		    _mm256_maddubs_epi16(r1, ones)
+		);
+		const __m256i g = _mm256_add_epi16(
+		    _mm256_maddubs_epi16(g0, ones),
+		    _mm256_maddubs_epi16(g1, ones)
+		);
+		const __m256i b = _mm256_add_epi16(
+		    _mm256_maddubs_epi16(b0, ones),
+		    _mm256_maddubs_epi16(b1, ones)
+		);
+
+		const __m256i cu = weighted16(r, g, b, cuRG, cuB, cbias, ChromaShift);
+		const __m256i cv = weighted16(r, g, b, cvRG, cvB, cbias, ChromaShift);
+
+		_mm_storeu_si128(
+		    reinterpret_cast<__m128i *>(u + x / 2),
+		    _mm256_castsi256_si128(
+		        _mm256_permute4x64_epi64(_mm256_packus_epi16(cu, cu), 0x08)
+		    )
+		);
+		_mm_storeu_si128(
+		    reinterpret_cast<__m128i *>(v + x / 2),
+		    _mm256_castsi256_si128(
+		        _mm256_permute4x64_epi64(_mm256_packus_epi16(cv, cv), 0x08)
+		    )
+		);
+	}
+	convertRowSSE41<BGR>(
+	    row0 + 3 * x,
+	    row1 + 3 * x,
+	    y0 + x,
+	    y1 + x,
+	    u + x / 2,
+	    v + x / 2,
+	    width - x
+	);
+}
+
+#endif // FORT_VIDEO_HAS_X86
+
+using RowFunction = void (*)(
+    const uint8_t *,
+    const uint8_t *,
+    uint8_t *,
+    uint8_t *,
+    uint8_t *,
+    uint8_t *,
+    int
+) noexcept;
+
+template <RowFunction Row>
+void convert(
+    const uint8_t *src,
+    int            srcLinesize,
+    uint8_t *const dst[3],
+    const int      dstLinesize[3],
+    int            width,
+    int            height
+) {
+	for (int y = 0; y < height; y += 2) {
+		const bool     last = y + 1 >= height;
+		const uint8_t *row0 = src + y * srcLinesize;
+		uint8_t       *y0   = dst[0] + y * dstLinesize[0];
+		// an odd last row is paired with itself.
+		Row(row0,
+		    last ? row0 : row0 + srcLinesize,
+		    y0,
+		    last ? y0 : y0 + dstLinesize[0],
+		    dst[1] + (y / 2) * dstLinesize[1],
+		    dst[2] + (y / 2) * dstLinesize[2],
+		    width);
+	}
+}
+
+template <bool BGR> RGB24ToYUV420PFunction find(SIMDLevel level) {
+#ifdef FORT_VIDEO_HAS_X86
+	switch (std::min(level, BestSIMDLevel())) {
+	case SIMDLevel::AVX2:
+		return convert<convertRowAVX2<BGR>>;
+	case SIMDLevel::SSE41:
+		return convert<convertRowSSE41<BGR>>;
+	default:
+		break;
+	}
+#endif
+	return convert<convertRowScalar<BGR>>;
+}
+
+} // namespace
+
+RGB24ToYUV420PFunction FindRGB24ToYUV420P(PixelFormat format, SIMDLevel level) {
+	switch (format) {
+	case AV_PIX_FMT_RGB24:
+		return find<false>(level);
+	case AV_PIX_FMT_BGR24:
+		return find<true>(level);
+	default:
+		return nullptr;
+	}
+}
+
+} // namespace details
+} // namespace video
+} // namespace fort
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+#include <fort/video/Types.hpp>
+#include <fort/video/details/CPU.hpp>
+
+namespace fort {
+namespace video {
+namespace details {
+
+// Converts a packed RGB24 or BGR24 image to planar YUV420P (BT.601, limited
+// range) without any scaling. Chroma is the rounded average of each 2x2 block,
+// odd last column / row are replicated.
+using RGB24ToYUV420PFunction = void (*)(
+    const uint8_t *src,
+    int            srcLinesize,
+    uint8_t *const dst[3],
+    const int      dstLinesize[3],
+    int            width,
+    int            height
+);
+
+// Returns the kernel for format (AV_PIX_FMT_RGB24 or AV_PIX_FMT_BGR24) at the
+// requested SIMD level, or nullptr if there is none.
+RGB24ToYUV420PFunction
+FindRGB24ToYUV420P(PixelFormat format, SIMDLevel level = BestSIMDLevel());
+
+} // namespace details
+} // namespace video
+} // namespace fort
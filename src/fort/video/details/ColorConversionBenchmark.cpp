@@ -0,0 +1,115 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include <fort/video/Frame.hpp>
+#include <fort/video/details/AVTypes.hpp>
+#include <fort/video/details/ColorConversion.hpp>
+
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+namespace fort {
+namespace video {
+namespace details {
+
+static void fillRandom(Frame &frame) {
+	std::mt19937                       rng{0};
+	std::uniform_int_distribution<int> dist{0, 255};
+	for (int y = 0; y < frame.Size.Height; ++y) {
+		for (int x = 0; x < frame.Linesize[0]; ++x) {
+			frame.Planes[0][y * frame.Linesize[0] + x] = dist(rng);
+		}
+	}
+}
+
+static void setThroughput(benchmark::State &state, const Resolution &size) {
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(
+	    int64_t(state.iterations()) * 3 * size.Width * size.Height
+	);
+}
+
+static void BM_RGB24ToYUV420P(benchmark::State &state) {
+	const auto       level = SIMDLevel(state.range(0));
+	const Resolution size{int(state.range(1)), int(state.range(2))};
+	if (level > BestSIMDLevel()) {
+		state.SkipWithError(("unsupported " + to_string(level)).c_str());
+		return;
+	}
+	state.SetLabel(to_string(level));
+
+	Frame src{size, AV_PIX_FMT_RGB24};
+	Frame dst{size, AV_PIX_FMT_YUV420P};
+	fillRandom(src);
+	auto fn = FindRGB24ToYUV420P(AV_PIX_FMT_RGB24, level);
+
+	for (auto _ : state) {
+		fn(src.Planes[0],
+		   src.Linesize[0],
+		   dst.Planes,
+		   dst.Linesize,
+		   size.Width,
+		   size.Height);
+		benchmark::DoNotOptimize(dst.Planes[0]);
+		benchmark::ClobberMemory();
+	}
+	setThroughput(state, size);
+}
+
+static void BM_RGB24ToYUV420PSwscale(benchmark::State &state) {
+	const Resolution size{int(state.range(0)), int(state.range(1))};
+	state.SetLabel("swscale");
+
+	Frame src{size, AV_PIX_FMT_RGB24};
+	Frame dst{size, AV_PIX_FMT_YUV420P};
+	fillRandom(src);
+	SwsContextPtr sws{sws_getContext(
+	    size.Width,
+	    size.Height,
+	    AV_PIX_FMT_RGB24,
+	    size.Width,
+	    size.Height,
+	    AV_PIX_FMT_YUV420P,
+	    SWS_BILINEAR,
+	    nullptr,
+	    nullptr,
+	    nullptr
+	)};
+
+	for (auto _ : state) {
+		sws_scale(
+		    sws.get(),
+		    src.Planes,
+		    src.Linesize,
+		    0,
+		    size.Height,
+		    dst.Planes,
+		    dst.Linesize
+		);
+		benchmark::DoNotOptimize(dst.Planes[0]);
+		benchmark::ClobberMemory();
+	}
+	setThroughput(state, size);
+}
+
+static void levelsAndSizes(benchmark::internal::Benchmark *b) {
+	for (auto level : {SIMDLevel::Scalar, SIMDLevel::SSE41, SIMDLevel::AVX2}) {
+		b->Args({int(level), 1920, 1080});
+		b->Args({int(level), 3840, 2160});
+	}
+}
+
+BENCHMARK(BM_RGB24ToYUV420P)
+    ->Apply(levelsAndSizes)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_RGB24ToYUV420PSwscale)
+    ->Args({1920, 1080})
+    ->Args({3840, 2160})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace details
+} // namespace video
+} // namespace fort
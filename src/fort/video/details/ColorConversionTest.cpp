@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include <fort/video/Frame.hpp>
+#include <fort/video/details/AVTypes.hpp>
+#include <fort/video/details/ColorConversion.hpp>
+
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+namespace fort {
+namespace video {
+namespace details {
+
+class ColorConversionTest : public ::testing::TestWithParam<PixelFormat> {
+protected:
+	static void FillRandom(Frame &frame, std::mt19937 &rng) {
+		std::uniform_int_distribution<int> dist{0, 255};
+		for (int y = 0; y < frame.Size.Height; ++y) {
+			for (int x = 0; x < 3 * frame.Size.Width; ++x) {
+				frame.Planes[0][y * frame.Linesize[0] + x] = dist(rng);
+			}
+		}
+	}
+
+	static void Convert(
+	    RGB24ToYUV420PFunction fn, const Frame &src, Frame &dst
+	) {
+		fn(src.Planes[0],
+		   src.Linesize[0],
+		   dst.Planes,
+		   dst.Linesize,
+		   src.Size.Width,
+		   src.Size.Height);
+	}
+
+	// Returns the number of samples of the three planes which differ.
+	static size_t CountDifferences(const Frame &expected, const Frame &result) {
+		size_t res = 0;
+		for (int plane = 0; plane < 3; ++plane) {
+			const int width =
+			    plane == 0 ? result.Size.Width : (result.Size.Width + 1) / 2;
+			const int height =
+			    plane == 0 ? result.Size.Height : (result.Size.Height + 1) / 2;
+			for (int y = 0; y < height; ++y) {
+				for (int x = 0; x < width; ++x) {
+					const int e =
+					    expected.Planes[plane][y * expected.Linesize[plane] + x];
+					const int r =
+					    result.Planes[plane][y * result.Linesize[plane] + x];
+					res += e != r;
+				}
+			}
+		}
+		return res;
+	}
+
+	static void ExpectPlanesNear(
+	    const Frame &expected, const Frame &result, int tolerance
+	) {
+		for (int plane = 0; plane < 3; ++plane) {
+			const int width =
+			    plane == 0 ? result.Size.Width : (result.Size.Width + 1) / 2;
+			const int height =
+			    plane == 0 ? result.Size.Height : (result.Size.Height + 1) / 2;
+			for (int y = 0; y < height; ++y) {
+				for (int x = 0; x < width; ++x) {
+					const int e =
+					    expected.Planes[plane][y * expected.Linesize[plane] + x];
+					const int r =
+					    result.Planes[plane][y * result.Linesize[plane] + x];
+					ASSERT_NEAR(r, e, tolerance)
+					    << "plane: " << plane << " x: " << x << " y: " << y;
+				}
+			}
+		}
+	}
+};
+
+TEST_P(ColorConversionTest, SIMDIsBitExact) {
+	std::mt19937 rng{42};
+	for (const auto &size : std::vector<Resolution>{
+	         {1, 1},
+	         {15, 7},
+	         {16, 2},
+	         {33, 5},
+	         {64, 48},
+	         {97, 31},
+	     }) {
+		SCOPED_TRACE(std::to_string(size.Width) + "x" + std::to_string(size.Height));
+		Frame src{size, GetParam()};
+		FillRandom(src, rng);
+
+		Frame expected{size, AV_PIX_FMT_YUV420P};
+		Convert(FindRGB24ToYUV420P(GetParam(), SIMDLevel::Scalar), src, expected);
+
+		for (auto level : {SIMDLevel::SSE41, SIMDLevel::AVX2}) {
+			if (level > BestSIMDLevel()) {
+				continue;
+			}
+			SCOPED_TRACE(to_string(level));
+			Frame result{size, AV_PIX_FMT_YUV420P};
+			Convert(FindRGB24ToYUV420P(GetParam(), level), src, result);
+			ExpectPlanesNear(expected, result, 0);
+		}
+	}
+}
+
+TEST_P(ColorConversionTest, MatchesSwscale) {
+	// Bit-exactness with swscale is not reachable as its output depends on
+	// the code path it selects at runtime. We check that both agree up to
+	// rounding of their fixed point coefficients.
+	std::mt19937         rng{0};
+	constexpr static int WIDTH = 64, HEIGHT = 48;
+	Frame                src{WIDTH, HEIGHT, GetParam()};
+
+	// each 2x2 block has a single color, so chroma subsampling filters
+	// cannot make a difference.
+	std::uniform_int_distribution<int> dist{0, 255};
+	for (int y = 0; y < HEIGHT; y += 2) {
+		for (int x = 0; x < WIDTH; x += 2) {
+			const uint8_t c[3] = {
+			    uint8_t(dist(rng)),
+			    uint8_t(dist(rng)),
+			    uint8_t(dist(rng)),
+			};
+			for (int i = 0; i < 4; ++i) {
+				uint8_t *p = src.Planes[0] + (y + i / 2) * src.Linesize[0] +
+				             3 * (x + i % 2);
+				std::copy(c, c + 3, p);
+			}
+		}
+	}
+
+	SwsContextPtr sws{sws_getContext(
+	    WIDTH,
+	    HEIGHT,
+	    GetParam(),
+	    WIDTH,
+	    HEIGHT,
+	    AV_PIX_FMT_YUV420P,
+	    SWS_POINT | SWS_ACCURATE_RND | SWS_BITEXACT,
+	    nullptr,
+	    nullptr,
+	    nullptr
+	)};
+	ASSERT_TRUE(sws);
+
+	Frame expected{WIDTH, HEIGHT, AV_PIX_FMT_YUV420P};
+	sws_scale(
+	    sws.get(),
+	    src.Planes,
+	    src.Linesize,
+	    0,
+	    HEIGHT,
+	    expected.Planes,
+	    expected.Linesize
+	);
+
+	Frame result{WIDTH, HEIGHT, AV_PIX_FMT_YUV420P};
+	Convert(FindRGB24ToYUV420P(GetParam()), src, result);
+
+	ExpectPlanesNear(expected, result, 1);
+	// both round the same exact values, they only disagree near the half.
+	const size_t samples = WIDTH * HEIGHT * 3 / 2;
+	EXPECT_LE(CountDifferences(expected, result), samples / 20)
+	    << "more than 5% of " << samples << " samples differ";
+}
+
+TEST_P(ColorConversionTest, KeepsGreyNeutral) {
+	Frame src{32, 2, GetParam()};
+	for (int x = 0; x < 32; ++x) {
+		for (int y = 0; y < 2; ++y) {
+			std::fill_n(src.Planes[0] + y * src.Linesize[0] + 3 * x, 3, x * 8);
+		}
+	}
+	Frame result{32, 2, AV_PIX_FMT_YUV420P};
+	Convert(FindRGB24ToYUV420P(GetParam()), src, result);
+
+	EXPECT_EQ(result.Planes[0][0], 16);
+	for (int x = 0; x < 16; ++x) {
+		EXPECT_EQ(result.Planes[1][x], 128);
+		EXPECT_EQ(result.Planes[2][x], 128);
+	}
+}
+
+TEST_P(ColorConversionTest, RespectsChannelOrder) {
+	const bool bgr = GetParam() == AV_PIX_FMT_BGR24;
+	Frame      src{2, 2, GetParam()};
+	for (int y = 0; y < 2; ++y) {
+		for (int x = 0; x < 2; ++x) {
+			uint8_t *p = src.Planes[0] + y * src.Linesize[0] + 3 * x;
+			// pure red
+			p[0] = bgr ? 0 : 255;
+			p[1] = 0;
+			p[2] = bgr ? 255 : 0;
+		}
+	}
+	Frame result{2, 2, AV_PIX_FMT_YUV420P};
+	Convert(FindRGB24ToYUV420P(GetParam()), src, result);
+	EXPECT_EQ(result.Planes[0][0], 81);
+	EXPECT_EQ(result.Planes[1][0], 90);
+	EXPECT_EQ(result.Planes[2][0], 240);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Formats,
+    ColorConversionTest,
+    ::testing::Values(AV_PIX_FMT_RGB24, AV_PIX_FMT_BGR24)
+);
+
+TEST(ColorConversionUTest, UnsupportedFormat) {
+	EXPECT_EQ(FindRGB24ToYUV420P(AV_PIX_FMT_GRAY8), nullptr);
+	EXPECT_EQ(FindRGB24ToYUV420P(AV_PIX_FMT_YUV420P), nullptr);
+}
+
+} // namespace details
+} // namespace video
+} // namespace fort
@@ -0,0 +1,272 @@
+#include "Muxer.hpp"
+
+#include <cpptrace/cpptrace.hpp>
+#include <fort/utils/Defer.hpp>
+
+#include "AVCall.hpp"
+
+namespace fort {
+namespace video {
+namespace details {
+
+Muxer::Muxer(const Writer::Params &params, const AVCodecContext *codec)
+    : d_context{nullptr, [](AVFormatContext *) {}}
+    , d_flushPeriod{params.FlushPeriod} {
+	d_stream            = newStream(params);
+	d_stream->time_base = codec->time_base;
+	AVCall(avcodec_parameters_from_context, d_stream->codecpar, codec);
+
+	if (d_context->oformat->flags & AVFMT_GLOBALHEADER) {
+		d_context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+	}
+
+	open(params);
+}
+
+Muxer::Muxer(
+    const Writer::Params    &params,
+    const AVCodecParameters *codecpar,
+    AVRational               timeBase
+)
+    : d_context{nullptr, [](AVFormatContext *) {}}
+    , d_flushPeriod{params.FlushPeriod} {
+	d_stream            = newStream(params);
+	d_stream->time_base = timeBase;
+	AVCall(avcodec_parameters_copy, d_stream->codecpar, codecpar);
+	// the tag is specific to the input container.
+	d_stream->codecpar->codec_tag = 0;
+
+	open(params);
+}
+
+AVStream *Muxer::newStream(const Writer::Params &params) {
+	AVFormatContext *ctx{nullptr};
+
+	AVCall(
+	    avformat_alloc_output_context2,
+	    &ctx,
+	    nullptr,
+	    params.Format.empty() ? nullptr : params.Format.c_str(),
+	    params.Path.c_str()
+	);
+
+	d_context = AVFormatContextPtr{ctx, avformat_free_context};
+
+	// we don't use a smart pointer as the stream is owned by the context.
+	auto stream =
+	    AVAlloc<AVStream>(avformat_new_stream, d_context.get(), nullptr);
+	stream->id = d_context->nb_streams - 1;
+	return stream;
+}
+
+Muxer::~Muxer() {
+	try {
+		Close();
+	} catch (...) {
+	}
+}
+
+void Muxer::Close() {
+	if (std::exchange(d_closed, true) || d_context->pb == nullptr) {
+		return;
+	}
+	std::exception_ptr error;
+	// after a failure, the trailer write would fail too.
+	if (d_failed == false) {
+		try {
+			call(av_write_trailer, d_context.get());
+		} catch (...) {
+			error = std::current_exception();
+		}
+	}
+	if (d_sink) {
+		closeSink();
+		if (d_sinkError && !error) {
+			// the last buffered bytes are written by closeSink().
+			error = std::exchange(d_sinkError, nullptr);
+		}
+		// the end of the file is only written when its buffer is.
+		try {
+			if (d_fileSink) {
+				d_fileSink->Close();
+			} else {
+				d_sink->Flush();
+			}
+		} catch (...) {
+			if (!error) {
+				error = std::current_exception();
+			}
+		}
+	} else if ((d_context->oformat->flags & AVFMT_NOFILE) == 0) {
+		int ret = avio_closep(&d_context->pb);
+		if (ret < 0 && !error) {
+			error = std::make_exception_ptr(AVError(ret, avio_closep));
+		}
+	}
+	if (error) {
+		d_failed = true;
+		std::rethrow_exception(error);
+	}
+}
+
+bool Muxer::Failed() const noexcept {
+	return d_failed;
+}
+
+void Muxer::Write(AVPacket *pkt, AVRational timeBase) {
+	if (d_closed) {
+		throw cpptrace::logic_error{"output is closed"};
+	}
+	pkt->stream_index = d_stream->index;
+	av_packet_rescale_ts(pkt, timeBase, d_stream->time_base);
+	call(av_interleaved_write_frame, d_context.get(), pkt);
+
+	if (clock::now() - d_lastFlush >= d_flushPeriod) {
+		Flush();
+	}
+}
+
+void Muxer::Flush() {
+	// a null packet flushes the muxer, e.g. it ends the current MP4 fragment.
+	call(av_write_frame, d_context.get(), nullptr);
+	if (d_context->pb != nullptr) {
+		avio_flush(d_context->pb);
+		if (d_context->pb->error < 0) {
+			// avio_flush() does not report errors by itself.
+			fail();
+			throw AVError(d_context->pb->error, avio_flush);
+		}
+	}
+	if (d_sink) {
+		try {
+			d_sink->Flush();
+		} catch (...) {
+			d_failed = true;
+			throw;
+		}
+	}
+	d_lastFlush = clock::now();
+}
+
+void Muxer::open(const Writer::Params &params) {
+	if (params.Sink) {
+		d_sink = params.Sink;
+		openSink();
+	} else if (params.FileBuffer.BufferSize > 0) {
+		d_fileSink = std::make_shared<BufferedFileSink>(
+		    params.Path,
+		    params.FileBuffer
+		);
+		d_sink = d_fileSink;
+		openSink();
+	} else if ((d_context->oformat->flags & AVFMT_NOFILE) == 0) {
+		AVCall(avio_open, &d_context->pb, params.Path.c_str(), AVIO_FLAG_WRITE);
+	}
+
+	AVDictionary *opts{nullptr};
+	defer {
+		if (opts != nullptr) {
+			av_dict_free(&opts);
+		}
+	};
+	if (!params.MuxerOptionKey.empty() && !params.MuxerOptionValue.empty()) {
+		AVCall(
+		    av_dict_set,
+		    &opts,
+		    params.MuxerOptionKey.c_str(),
+		    params.MuxerOptionValue.c_str(),
+		    0
+		);
+	}
+	for (const auto &[key, value] : params.MuxerOptions) {
+		AVCall(av_dict_set, &opts, key.c_str(), value.c_str(), 0);
+	}
+
+	if (params.Fragmented && std::string{d_context->oformat->name} == "mp4" &&
+	    av_dict_get(opts, "movflags", nullptr, 0) == nullptr) {
+		// an empty moov is written upfront and each fragment carries its own
+		// index, instead of a single moov written by av_write_trailer().
+		AVCall(
+		    av_dict_set,
+		    &opts,
+		    "movflags",
+		    "frag_keyframe+empty_moov+default_base_moof",
+		    0
+		);
+	}
+
+	try {
+		call(avformat_write_header, d_context.get(), &opts);
+	} catch (...) {
+		// the destructor will not be called.
+		if (d_sink) {
+			closeSink();
+		}
+		throw;
+	}
+	d_lastFlush = clock::now();
+}
+
+void Muxer::fail() {
+	d_failed = true;
+	if (d_sinkError) {
+		std::rethrow_exception(std::exchange(d_sinkError, nullptr));
+	}
+}
+
+void Muxer::openSink() {
+	constexpr static int IO_BUFFER_SIZE = 64 * 1024;
+
+	auto buffer = reinterpret_cast<unsigned char *>(
+	    AVAlloc<void>(av_malloc, IO_BUFFER_SIZE)
+	);
+
+	d_context->pb = avio_alloc_context(
+	    buffer,
+	    IO_BUFFER_SIZE,
+	    1,
+	    this,
+	    nullptr,
+	    &Muxer::writeSink,
+	    d_sink->Seekable() ? &Muxer::seekSink : nullptr
+	);
+	if (d_context->pb == nullptr) {
+		av_free(buffer);
+		throw AVError(AVERROR(ENOMEM), avio_alloc_context);
+	}
+	d_context->flags |= AVFMT_FLAG_CUSTOM_IO;
+}
+
+void Muxer::closeSink() {
+	avio_flush(d_context->pb);
+	av_freep(&d_context->pb->buffer);
+	avio_context_free(&d_context->pb);
+}
+
+int Muxer::writeSink(void *opaque, WriteBuffer buffer, int size) {
+	auto self = reinterpret_cast<Muxer *>(opaque);
+	try {
+		self->d_sink->Write(buffer, size);
+		return size;
+	} catch (...) {
+		self->d_sinkError = std::current_exception();
+		return AVERROR(EIO);
+	}
+}
+
+int64_t Muxer::seekSink(void *opaque, int64_t offset, int whence) {
+	auto self = reinterpret_cast<Muxer *>(opaque);
+	try {
+		if ((whence & AVSEEK_SIZE) != 0) {
+			return self->d_sink->Size();
+		}
+		return self->d_sink->Seek(offset, whence);
+	} catch (...) {
+		self->d_sinkError = std::current_exception();
+		return AVERROR(EIO);
+	}
+}
+
+} // namespace details
+} // namespace video
+} // namespace fort
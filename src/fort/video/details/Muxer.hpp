@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include <fort/video/Writer.hpp>
+#include <fort/video/details/AVCall.hpp>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavformat/version.h>
+}
+
+namespace fort {
+namespace video {
+namespace details {
+
+// Muxer owns an output file with a single video stream. The trailer is
+// written and the file closed by Close(), or on destruction ignoring errors.
+class Muxer {
+public:
+	Muxer(const Writer::Params &params, const AVCodecContext *codec);
+	// Creates a muxer for already encoded packets, for stream copy.
+	Muxer(
+	    const Writer::Params    &params,
+	    const AVCodecParameters *codecpar,
+	    AVRational               timeBase
+	);
+	~Muxer();
+
+	Muxer(const Muxer &other)            = delete;
+	Muxer &operator=(const Muxer &other) = delete;
+
+	// Writes a packet whose timestamps are expressed in timeBase.
+	void Write(AVPacket *pkt, AVRational timeBase);
+
+	// Pushes all buffered data to the output, closing the current fragment
+	// for fragmented formats.
+	void Flush();
+
+	// Writes the trailer and closes the output, and reports any error of
+	// these last writes. The output is released even if it throws.
+	void Close();
+
+	// Returns true if a write failed, and the output is unusable.
+	bool Failed() const noexcept;
+
+private:
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+	using WriteBuffer = const uint8_t *;
+#else
+	using WriteBuffer = uint8_t *;
+#endif
+
+	using AVFormatContextPtr = std::
+	    unique_ptr<AVFormatContext, std::function<void(AVFormatContext *)>>;
+
+	AVStream *newStream(const Writer::Params &params);
+
+	void open(const Writer::Params &params);
+
+	void openSink();
+
+	void closeSink();
+
+	// Calls fn like AVCall(), but rethrows the original sink exception if
+	// the failure comes from it.
+	template <typename Function, typename... Args>
+	int call(Function &&fn, Args &&...args) {
+		try {
+			return AVCall(
+			    std::forward<Function>(fn),
+			    std::forward<Args>(args)...
+			);
+		} catch (const AVError &) {
+			fail();
+			throw;
+		}
+	}
+
+	// Marks the muxer as failed, and rethrows the sink exception if any.
+	void fail();
+
+	static int writeSink(void *opaque, WriteBuffer buffer, int size);
+
+	static int64_t seekSink(void *opaque, int64_t offset, int whence);
+
+	using clock = std::chrono::steady_clock;
+
+	AVFormatContextPtr d_context;
+	AVStream          *d_stream;
+	Duration           d_flushPeriod;
+	clock::time_point  d_lastFlush;
+
+	std::shared_ptr<Sink> d_sink;
+	// set if d_sink was created from Writer::Params::FileBuffer, and is
+	// closed with the output.
+	std::shared_ptr<BufferedFileSink> d_fileSink;
+	// error raised by d_sink, rethrown when the muxer reports a failure.
+	std::exception_ptr d_sinkError;
+	bool               d_failed = false;
+	bool               d_closed = false;
+};
+
+} // namespace details
+} // namespace video
+} // namespace fort
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+
+#include <fort/video/Frame.hpp>
+
+extern "C" {
+#include <libavutil/mathematics.h>
+}
+
+namespace fort {
+namespace video {
+namespace details {
+
+// PTSGenerator computes the encoder timestamps of the written frames. It
+// either counts frames, or uses Frame::PTS relative to the first frame,
+// rescaled to the encoder time base. In the latter case, timestamps are
+// kept strictly increasing: a frame that would collide with the previous
+// one after rescaling is pushed to the next tick.
+class PTSGenerator {
+public:
+	PTSGenerator(bool useFramePTS, AVRational timeBase) noexcept
+	    : d_useFramePTS{useFramePTS}
+	    , d_timeBase{timeBase} {}
+
+	int64_t operator()(const Frame &frame) noexcept {
+		if (d_useFramePTS == false) {
+			return d_last = d_last + 1;
+		}
+		if (d_first == Duration::min()) {
+			d_first = frame.PTS;
+		}
+		int64_t pts = av_rescale_q(
+		    (frame.PTS - d_first).count(),
+		    {1, int(1e9)},
+		    d_timeBase
+		);
+		return d_last = std::max(pts, d_last + 1);
+	}
+
+private:
+	bool       d_useFramePTS;
+	AVRational d_timeBase;
+	Duration   d_first = Duration::min();
+	int64_t    d_last  = -1;
+};
+
+} // namespace details
+} // namespace video
+} // namespace fort
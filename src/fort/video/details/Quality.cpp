@@ -0,0 +1,342 @@
+#include "Quality.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "CPU.hpp"
+
+#ifdef FORT_VIDEO_HAS_X86
+#include <immintrin.h>
+#endif
+
+namespace fort {
+namespace video {
+namespace details {
+
+namespace {
+
+constexpr int WindowSize = 8;
+
+// Sums over a window of a and b pixels, of a^2 + b^2, and of a * b.
+struct WindowSums {
+	int32_t A, B, Squares, Products;
+};
+
+uint64_t ssdRowScalar(const uint8_t *a, const uint8_t *b, int x, int width) {
+	uint64_t res = 0;
+	for (; x < width; ++x) {
+		const int32_t d = int32_t(a[x]) - int32_t(b[x]);
+		res += d * d;
+	}
+	return res;
+}
+
+uint64_t ssdScalar(
+    const uint8_t *a,
+    int            aLinesize,
+    const uint8_t *b,
+    int            bLinesize,
+    int            width,
+    int            height
+) {
+	uint64_t res = 0;
+	for (int y = 0; y < height; ++y) {
+		res += ssdRowScalar(a + y * aLinesize, b + y * bLinesize, 0, width);
+	}
+	return res;
+}
+
+void windowsScalar(
+    const uint8_t *a,
+    int            aLinesize,
+    const uint8_t *b,
+    int            bLinesize,
+    int            count,
+    WindowSums    *sums
+) {
+	for (int w = 0; w < count; ++w) {
+		WindowSums s{0, 0, 0, 0};
+		for (int y = 0; y < WindowSize; ++y) {
+			for (int x = 0; x < WindowSize; ++x) {
+				const int32_t va = a[y * aLinesize + w * WindowSize + x];
+				const int32_t vb = b[y * bLinesize + w * WindowSize + x];
+				s.A += va;
+				s.B += vb;
+				s.Squares += va * va + vb * vb;
+				s.Products += va * vb;
+			}
+		}
+		sums[w] = s;
+	}
+}
+
+#ifdef FORT_VIDEO_HAS_X86
+
+FORT_VIDEO_TARGET("sse4.1")
+inline int32_t hsum(__m128i v) noexcept {
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(v);
+}
+
+FORT_VIDEO_TARGET("sse4.1")
+uint64_t ssdSSE41(
+    const uint8_t *a,
+    int            aLinesize,
+    const uint8_t *b,
+    int            bLinesize,
+    int            width,
+    int            height
+) {
+	const __m128i zero = _mm_setzero_si128();
+	uint64_t      res  = 0;
+	for (int y = 0; y < height; ++y) {
+		const uint8_t *ra  = a + y * aLinesize;
+		const uint8_t *rb  = b + y * bLinesize;
+		__m128i        acc = _mm_setzero_si128();
+		int            x   = 0;
+		// each 32-bit lane gets at most 2 * 255^2 per iteration, which
+		// cannot overflow for any realistic width.
+		for (; x + 16 <= width; x += 16) {
+			const __m128i va = _mm_loadu_si128((const __m128i *)(ra + x));
+			const __m128i vb = _mm_loadu_si128((const __m128i *)(rb + x));
+			const __m128i lo = _mm_sub_epi16(
+			    _mm_unpacklo_epi8(va, zero),
+			    _mm_unpacklo_epi8(vb, zero)
+			);
+			const __m128i hi = _mm_sub_epi16(
+			    _mm_unpackhi_epi8(va, zero),
+			    _mm_unpackhi_epi8(vb, zero)
+			);
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(lo, lo));
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(hi, hi));
+		}
+		res += uint32_t(hsum(acc)) + ssdRowScalar(ra, rb, x, width);
+	}
+	return res;
+}
+
+FORT_VIDEO_TARGET("sse4.1")
+void windowsSSE41(
+    const uint8_t *a,
+    int            aLinesize,
+    const uint8_t *b,
+    int            bLinesize,
+    int            count,
+    WindowSums    *sums
+) {
+	const __m128i ones = _mm_set1_epi16(1);
+	for (int w = 0; w < count; ++w) {
+		__m128i sa = _mm_setzero_si128(), sb = _mm_setzero_si128();
+		__m128i sq = _mm_setzero_si128(), sp = _mm_setzero_si128();
+		for (int y = 0; y < WindowSize; ++y) {
+			const __m128i va = _mm_cvtepu8_epi16(_mm_loadl_epi64(
+			    (const __m128i *)(a + y * aLinesize + w * WindowSize)
+			));
+			const __m128i vb = _mm_cvtepu8_epi16(_mm_loadl_epi64(
+			    (const __m128i *)(b + y * bLinesize + w * WindowSize)
+			));
+			sa = _mm_add_epi32(sa, _mm_madd_epi16(va, ones));
+			sb = _mm_add_epi32(sb, _mm_madd_epi16(vb, ones));
+			sq = _mm_add_epi32(sq, _mm_madd_epi16(va, va));
+			sq = _mm_add_epi32(sq, _mm_madd_epi16(vb, vb));
+			sp = _mm_add_epi32(sp, _mm_madd_epi16(va, vb));
+		}
+		sums[w] = {hsum(sa), hsum(sb), hsum(sq), hsum(sp)};
+	}
+}
+
+FORT_VIDEO_TARGET("avx2")
+inline __m128i hsum2(__m256i v) noexcept {
+	// returns the sum of each 128-bit lane in the two lowest 32-bit lanes.
+	v = _mm256_add_epi32(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm256_add_epi32(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_unpacklo_epi32(
+	    _mm256_castsi256_si128(v),
+	    _mm256_extracti128_si256(v, 1)
+	);
+}
+
+FORT_VIDEO_TARGET("avx2")
+uint64_t ssdAVX2(
+    const uint8_t *a,
+    int            aLinesize,
+    const uint8_t *b,
+    int            bLinesize,
+    int            width,
+    int            height
+) {
+	uint64_t res = 0;
+	for (int y = 0; y < height; ++y) {
+		const uint8_t *ra  = a + y * aLinesize;
+		const uint8_t *rb  = b + y * bLinesize;
+		__m256i        acc = _mm256_setzero_si256();
+		int            x   = 0;
+		for (; x + 32 <= width; x += 32) {
+			const __m256i va = _mm256_loadu_si256((const __m256i *)(ra + x));
+			const __m256i vb = _mm256_loadu_si256((const __m256i *)(rb + x));
+			const __m256i zero = _mm256_setzero_si256();
+			// unpacking is done per 128-bit lane, the order does not matter
+			// for a sum.
+			const __m256i lo = _mm256_sub_epi16(
+			    _mm256_unpacklo_epi8(va, zero),
+			    _mm256_unpacklo_epi8(vb, zero)
+			);
+			const __m256i hi = _mm256_sub_epi16(
+			    _mm256_unpackhi_epi8(va, zero),
+			    _mm256_unpackhi_epi8(vb, zero)
+			);
+			acc = _mm256_add_epi32(acc, _mm256_madd_epi16(lo, lo));
+			acc = _mm256_add_epi32(acc, _mm256_madd_epi16(hi, hi));
+		}
+		const __m128i lanes = hsum2(acc);
+		res += uint64_t(uint32_t(_mm_cvtsi128_si32(lanes))) +
+		       uint64_t(uint32_t(_mm_extract_epi32(lanes, 1))) +
+		       ssdRowScalar(ra, rb, x, width);
+	}
+	return res;
+}
+
+FORT_VIDEO_TARGET("avx2")
+void windowsAVX2(
+    const uint8_t *a,
+    int            aLinesize,
+    const uint8_t *b,
+    int            bLinesize,
+    int            count,
+    WindowSums    *sums
+) {
+	const __m256i ones = _mm256_set1_epi16(1);
+	int           w    = 0;
+	// two windows at once, one per 128-bit lane.
+	for (; w + 2 <= count; w += 2) {
+		__m256i sa = _mm256_setzero_si256(), sb = _mm256_setzero_si256();
+		__m256i sq = _mm256_setzero_si256(), sp = _mm256_setzero_si256();
+		for (int y = 0; y < WindowSize; ++y) {
+			const __m256i va = _mm256_cvtepu8_epi16(_mm_loadu_si128(
+			    (const __m128i *)(a + y * aLinesize + w * WindowSize)
+			));
+			const __m256i vb = _mm256_cvtepu8_epi16(_mm_loadu_si128(
+			    (const __m128i *)(b + y * bLinesize + w * WindowSize)
+			));
+			sa = _mm256_add_epi32(sa, _mm256_madd_epi16(va, ones));
+			sb = _mm256_add_epi32(sb, _mm256_madd_epi16(vb, ones));
+			sq = _mm256_add_epi32(sq, _mm256_madd_epi16(va, va));
+			sq = _mm256_add_epi32(sq, _mm256_madd_epi16(vb, vb));
+			sp = _mm256_add_epi32(sp, _mm256_madd_epi16(va, vb));
+		}
+		const __m128i ha = hsum2(sa), hb = hsum2(sb);
+		const __m128i hq = hsum2(sq), hp = hsum2(sp);
+		sums[w] = {
+		    _mm_cvtsi128_si32(ha),
+		    _mm_cvtsi128_si32(hb),
+		    _mm_cvtsi128_si32(hq),
+		    _mm_cvtsi128_si32(hp),
+		};
+		sums[w + 1] = {
+		    _mm_extract_epi32(ha, 1),
+		    _mm_extract_epi32(hb, 1),
+		    _mm_extract_epi32(hq, 1),
+		    _mm_extract_epi32(hp, 1),
+		};
+	}
+	windowsSSE41(
+	    a + w * WindowSize,
+	    aLinesize,
+	    b + w * WindowSize,
+	    bLinesize,
+	    count - w,
+	    sums + w
+	);
+}
+
+#endif // FORT_VIDEO_HAS_X86
+
+using WindowFunction =
+    void (*)(const uint8_t *, int, const uint8_t *, int, int, WindowSums *);
+
+double ssimWindow(const WindowSums &s) noexcept {
+	constexpr double N  = WindowSize * WindowSize;
+	constexpr double C1 = (0.01 * 255) * (0.01 * 255) * N * N;
+	constexpr double C2 = (0.03 * 255) * (0.03 * 255) * N * N;
+
+	const double a = s.A, b = s.B;
+	const double variances  = s.Squares * N - a * a - b * b;
+	const double covariance = s.Products * N - a * b;
+	return ((2 * a * b + C1) * (2 * covariance + C2)) /
+	       ((a * a + b * b + C1) * (variances + C2));
+}
+
+template <WindowFunction Windows>
+double ssim(
+    const uint8_t *a,
+    int            aLinesize,
+    const uint8_t *b,
+    int            bLinesize,
+    int            width,
+    int            height
+) {
+	const int columns = width / WindowSize, rows = height / WindowSize;
+	if (columns == 0 || rows == 0) {
+		return 1.0;
+	}
+	std::vector<WindowSums> sums(columns);
+	double                  res = 0.0;
+	for (int y = 0; y < rows; ++y) {
+		Windows(
+		    a + y * WindowSize * aLinesize,
+		    aLinesize,
+		    b + y * WindowSize * bLinesize,
+		    bLinesize,
+		    columns,
+		    sums.data()
+		);
+		for (const auto &s : sums) {
+			res += ssimWindow(s);
+		}
+	}
+	return res / (columns * rows);
+}
+
+} // namespace
+
+SSDFunction FindSSD(SIMDLevel level) {
+#ifdef FORT_VIDEO_HAS_X86
+	switch (std::min(level, BestSIMDLevel())) {
+	case SIMDLevel::AVX2:
+		return ssdAVX2;
+	case SIMDLevel::SSE41:
+		return ssdSSE41;
+	default:
+		break;
+	}
+#endif
+	return ssdScalar;
+}
+
+SSIMFunction FindSSIM(SIMDLevel level) {
+#ifdef FORT_VIDEO_HAS_X86
+	switch (std::min(level, BestSIMDLevel())) {
+	case SIMDLevel::AVX2:
+		return ssim<windowsAVX2>;
+	case SIMDLevel::SSE41:
+		return ssim<windowsSSE41>;
+	default:
+		break;
+	}
+#endif
+	return ssim<windowsScalar>;
+}
+
+double PSNR(uint64_t ssd, size_t size) noexcept {
+	if (ssd == 0 || size == 0) {
+		return 100.0;
+	}
+	const double mse = double(ssd) / size;
+	return std::min(100.0, 10.0 * std::log10(255.0 * 255.0 / mse));
+}
+
+} // namespace details
+} // namespace video
+} // namespace fort
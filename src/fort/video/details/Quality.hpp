@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <fort/video/details/CPU.hpp>
+
+namespace fort {
+namespace video {
+namespace details {
+
+// Sum of squared differences between two 8-bit planes.
+using SSDFunction = uint64_t (*)(
+    const uint8_t *a,
+    int            aLinesize,
+    const uint8_t *b,
+    int            bLinesize,
+    int            width,
+    int            height
+);
+
+// Mean structural similarity between two 8-bit planes, over non-overlapping
+// 8x8 windows. Incomplete windows on the right and bottom borders are
+// ignored, planes smaller than a window return 1.
+using SSIMFunction = double (*)(
+    const uint8_t *a,
+    int            aLinesize,
+    const uint8_t *b,
+    int            bLinesize,
+    int            width,
+    int            height
+);
+
+// Returns the kernels at the requested SIMD level. All levels return
+// exactly the same results.
+SSDFunction  FindSSD(SIMDLevel level = BestSIMDLevel());
+SSIMFunction FindSSIM(SIMDLevel level = BestSIMDLevel());
+
+// Peak signal to noise ratio in dB of an 8-bit plane of size pixels, capped
+// to 100dB for identical planes.
+double PSNR(uint64_t ssd, size_t size) noexcept;
+
+} // namespace details
+} // namespace video
+} // namespace fort
@@ -0,0 +1,209 @@
+#include "QualityMonitor.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include <cpptrace/cpptrace.hpp>
+#include <fort/utils/Defer.hpp>
+
+#include "AVCall.hpp"
+
+namespace fort {
+namespace video {
+namespace details {
+
+static AVCodecContextPtr openDecoder(const AVCodecContext *encoder) {
+	const AVCodec *codec = avcodec_find_decoder(encoder->codec_id);
+	if (codec == nullptr) {
+		throw cpptrace::runtime_error{
+		    "could not find a decoder for " +
+		    std::string{avcodec_get_name(encoder->codec_id)},
+		};
+	}
+	auto ctx = MakeAVCodecContext(codec);
+
+	AVCodecParameters *par = avcodec_parameters_alloc();
+	if (par == nullptr) {
+		throw AVError(AVERROR(ENOMEM), avcodec_parameters_alloc);
+	}
+	defer {
+		avcodec_parameters_free(&par);
+	};
+	AVCall(avcodec_parameters_from_context, par, encoder);
+	AVCall(avcodec_parameters_to_context, ctx.get(), par);
+	ctx->pkt_timebase = encoder->time_base;
+	// the monitor runs next to the encoder, it should not compete with it.
+	ctx->thread_count = 1;
+
+	AVCall(avcodec_open2, ctx.get(), codec, nullptr);
+	return ctx;
+}
+
+QualityMonitor::QualityMonitor(const AVCodecContext *encoder, size_t period)
+    : d_decoder{openDecoder(encoder)}
+    , d_ssd{FindSSD()}
+    , d_ssim{FindSSIM()}
+    , d_period{std::max(period, size_t(1))}
+    , d_width{encoder->width}
+    , d_height{encoder->height} {
+	d_thread = std::thread{[this]() { loop(); }};
+}
+
+QualityMonitor::~QualityMonitor() {
+	{
+		std::lock_guard<std::mutex> lock{d_mutex};
+		d_quit = true;
+	}
+	d_cv.notify_all();
+	d_thread.join();
+}
+
+void QualityMonitor::Sent(const AVFrame &frame, size_t index) {
+	if (index % d_period != 0) {
+		return;
+	}
+	std::vector<uint8_t> luma(size_t(d_width) * d_height);
+	for (int y = 0; y < d_height; ++y) {
+		std::memcpy(
+		    luma.data() + size_t(y) * d_width,
+		    frame.data[0] + size_t(y) * frame.linesize[0],
+		    d_width
+		);
+	}
+	std::lock_guard<std::mutex> lock{d_mutex};
+	d_references[frame.pts] = std::move(luma);
+}
+
+void QualityMonitor::Received(const AVPacket &pkt) {
+	AVPacketPtr copy{av_packet_clone(&pkt)};
+	if (!copy) {
+		throw AVError(AVERROR(ENOMEM), av_packet_clone);
+	}
+	{
+		std::lock_guard<std::mutex> lock{d_mutex};
+		if (d_flushed) {
+			return;
+		}
+		d_packets.push_back(std::move(copy));
+	}
+	d_cv.notify_all();
+}
+
+void QualityMonitor::Finish() {
+	std::unique_lock<std::mutex> lock{d_mutex};
+	if (d_flushed == false) {
+		d_flushed = true;
+		d_packets.push_back(nullptr);
+		d_cv.notify_all();
+	}
+	d_cv.wait(lock, [this]() { return d_packets.empty() && d_busy == false; });
+	if (d_error) {
+		std::rethrow_exception(std::exchange(d_error, nullptr));
+	}
+}
+
+QualityMonitor::Stats QualityMonitor::GetStats() const {
+	std::lock_guard<std::mutex> lock{d_mutex};
+	auto                        res = d_stats;
+	if (res.Samples > 0) {
+		res.MeanPSNR = d_totalPSNR / res.Samples;
+		res.MeanSSIM = d_totalSSIM / res.Samples;
+	}
+	return res;
+}
+
+void QualityMonitor::loop() {
+	while (true) {
+		AVPacketPtr pkt;
+		{
+			std::unique_lock<std::mutex> lock{d_mutex};
+			d_busy = false;
+			d_cv.notify_all();
+			d_cv.wait(lock, [this]() {
+				return d_quit || d_packets.empty() == false;
+			});
+			if (d_quit) {
+				return;
+			}
+			pkt = std::move(d_packets.front());
+			d_packets.pop_front();
+			d_busy = true;
+		}
+
+		try {
+			decode(pkt.get());
+		} catch (...) {
+			// the decoder state is unknown, remaining packets are dropped.
+			std::lock_guard<std::mutex> lock{d_mutex};
+			d_error = std::current_exception();
+			d_packets.clear();
+			d_flushed = true;
+		}
+	}
+}
+
+void QualityMonitor::decode(AVPacket *pkt) {
+	AVCall(avcodec_send_packet, d_decoder.get(), pkt);
+	while (true) {
+		int error = avcodec_receive_frame(d_decoder.get(), d_frame.get());
+		if (error == AVERROR(EAGAIN) || error == AVERROR_EOF) {
+			return;
+		} else if (error < 0) {
+			throw AVError(error, avcodec_receive_frame);
+		}
+		defer {
+			av_frame_unref(d_frame.get());
+		};
+		measure(*d_frame);
+	}
+}
+
+void QualityMonitor::measure(const AVFrame &frame) {
+	std::vector<uint8_t> reference;
+	{
+		std::lock_guard<std::mutex> lock{d_mutex};
+		// frames are decoded in presentation order, older references will
+		// never match.
+		auto it = d_references.lower_bound(frame.pts);
+		d_references.erase(d_references.begin(), it);
+		if (it == d_references.end() || it->first != frame.pts) {
+			return;
+		}
+		reference = std::move(it->second);
+		d_references.erase(it);
+	}
+
+	const uint64_t ssd = d_ssd(
+	    reference.data(),
+	    d_width,
+	    frame.data[0],
+	    frame.linesize[0],
+	    d_width,
+	    d_height
+	);
+	const double psnr = PSNR(ssd, size_t(d_width) * d_height);
+	const double ssim = d_ssim(
+	    reference.data(),
+	    d_width,
+	    frame.data[0],
+	    frame.linesize[0],
+	    d_width,
+	    d_height
+	);
+
+	std::lock_guard<std::mutex> lock{d_mutex};
+	if (d_stats.Samples == 0) {
+		d_stats.MinPSNR = psnr;
+		d_stats.MinSSIM = ssim;
+	}
+	++d_stats.Samples;
+	d_totalPSNR     += psnr;
+	d_totalSSIM     += ssim;
+	d_stats.MinPSNR  = std::min(d_stats.MinPSNR, psnr);
+	d_stats.MinSSIM  = std::min(d_stats.MinSSIM, ssim);
+}
+
+} // namespace details
+} // namespace video
+} // namespace fort
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fort/video/details/AVTypes.hpp>
+#include <fort/video/details/Quality.hpp>
+
+namespace fort {
+namespace video {
+namespace details {
+
+// QualityMonitor measures the luma PSNR and SSIM of an encoded stream
+// against its input, on a side thread. Every packet must be decoded for
+// inter prediction, but only one frame every period is compared.
+class QualityMonitor {
+public:
+	struct Stats {
+		size_t Samples  = 0;
+		double MeanPSNR = 0.0, MinPSNR = 0.0;
+		double MeanSSIM = 0.0, MinSSIM = 0.0;
+	};
+
+	QualityMonitor(const AVCodecContext *encoder, size_t period);
+	~QualityMonitor();
+
+	QualityMonitor(const QualityMonitor &other)            = delete;
+	QualityMonitor &operator=(const QualityMonitor &other) = delete;
+
+	// Reports the index-th frame sent to the encoder, its luma plane is
+	// kept if it is sampled.
+	void Sent(const AVFrame &frame, size_t index);
+
+	// Queues a packet output by the encoder for decoding.
+	void Received(const AVPacket &pkt);
+
+	// Flushes the decoder and waits until every queued packet is measured.
+	// Rethrows any decoding error.
+	void Finish();
+
+	// Thread-safe.
+	Stats GetStats() const;
+
+private:
+	void loop();
+
+	void decode(AVPacket *pkt);
+
+	void measure(const AVFrame &frame);
+
+	AVCodecContextPtr  d_decoder;
+	const SSDFunction  d_ssd;
+	const SSIMFunction d_ssim;
+	const size_t       d_period;
+	const int          d_width, d_height;
+
+	mutable std::mutex      d_mutex;
+	std::condition_variable d_cv;
+	// a null packet flushes the decoder.
+	std::deque<AVPacketPtr> d_packets;
+	// luma planes of the sampled frames not decoded yet, by pts.
+	std::map<int64_t, std::vector<uint8_t>> d_references;
+
+	bool d_busy = false, d_quit = false, d_flushed = false;
+	std::exception_ptr d_error;
+
+	Stats  d_stats;
+	double d_totalPSNR = 0.0, d_totalSSIM = 0.0;
+
+	AVFramePtr  d_frame = AVFramePtr{av_frame_alloc()};
+	std::thread d_thread;
+};
+
+} // namespace details
+} // namespace video
+} // namespace fort
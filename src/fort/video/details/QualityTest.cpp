@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include <fort/video/details/Quality.hpp>
+
+namespace fort {
+namespace video {
+namespace details {
+
+struct Plane {
+	int                  Width, Height, Linesize;
+	std::vector<uint8_t> Data;
+
+	Plane(int width, int height, int padding = 13)
+	    : Width{width}
+	    , Height{height}
+	    , Linesize{width + padding}
+	    , Data(Linesize * height, 0) {}
+
+	uint8_t &operator()(int x, int y) {
+		return Data[y * Linesize + x];
+	}
+};
+
+static void FillRandom(Plane &plane, std::mt19937 &rng) {
+	std::uniform_int_distribution<int> dist{0, 255};
+	for (auto &v : plane.Data) {
+		v = dist(rng);
+	}
+}
+
+TEST(QualityTest, SIMDIsExact) {
+	std::mt19937 rng{42};
+	for (const auto &[width, height] : std::vector<std::pair<int, int>>{
+	         {1, 1},
+	         {7, 9},
+	         {16, 8},
+	         {33, 17},
+	         {64, 48},
+	         {97, 31},
+	         {1920, 16},
+	     }) {
+		SCOPED_TRACE(std::to_string(width) + "x" + std::to_string(height));
+		Plane a{width, height}, b{width, height};
+		FillRandom(a, rng);
+		FillRandom(b, rng);
+
+		const auto ssd = FindSSD(SIMDLevel::Scalar)(
+		    a.Data.data(),
+		    a.Linesize,
+		    b.Data.data(),
+		    b.Linesize,
+		    width,
+		    height
+		);
+		const auto ssim = FindSSIM(SIMDLevel::Scalar)(
+		    a.Data.data(),
+		    a.Linesize,
+		    b.Data.data(),
+		    b.Linesize,
+		    width,
+		    height
+		);
+
+		for (auto level : {SIMDLevel::SSE41, SIMDLevel::AVX2}) {
+			if (level > BestSIMDLevel()) {
+				continue;
+			}
+			SCOPED_TRACE(to_string(level));
+			EXPECT_EQ(
+			    FindSSD(level)(
+			        a.Data.data(),
+			        a.Linesize,
+			        b.Data.data(),
+			        b.Linesize,
+			        width,
+			        height
+			    ),
+			    ssd
+			);
+			EXPECT_EQ(
+			    FindSSIM(level)(
+			        a.Data.data(),
+			        a.Linesize,
+			        b.Data.data(),
+			        b.Linesize,
+			        width,
+			        height
+			    ),
+			    ssim
+			);
+		}
+	}
+}
+
+TEST(QualityTest, IdenticalPlanes) {
+	std::mt19937 rng{0};
+	Plane        a{64, 48};
+	FillRandom(a, rng);
+	const auto ssd =
+	    FindSSD()(a.Data.data(), a.Linesize, a.Data.data(), a.Linesize, 64, 48);
+	EXPECT_EQ(ssd, 0);
+	EXPECT_EQ(PSNR(ssd, 64 * 48), 100.0);
+	EXPECT_DOUBLE_EQ(
+	    FindSSIM()(a.Data.data(), a.Linesize, a.Data.data(), a.Linesize, 64, 48),
+	    1.0
+	);
+}
+
+TEST(QualityTest, KnownValues) {
+	Plane a{64, 48}, b{64, 48};
+	for (int y = 0; y < 48; ++y) {
+		for (int x = 0; x < 64; ++x) {
+			a(x, y) = 100;
+			b(x, y) = 110;
+		}
+	}
+	const auto ssd =
+	    FindSSD()(a.Data.data(), a.Linesize, b.Data.data(), b.Linesize, 64, 48);
+	EXPECT_EQ(ssd, 100 * 64 * 48);
+	EXPECT_NEAR(PSNR(ssd, 64 * 48), 28.13, 0.01);
+	// a luminance shift barely changes the structure.
+	EXPECT_GT(
+	    FindSSIM()(a.Data.data(), a.Linesize, b.Data.data(), b.Linesize, 64, 48),
+	    0.99
+	);
+
+	std::mt19937 rng{1};
+	FillRandom(b, rng);
+	EXPECT_LT(
+	    FindSSIM()(a.Data.data(), a.Linesize, b.Data.data(), b.Linesize, 64, 48),
+	    0.1
+	);
+}
+
+TEST(QualityTest, SmallPlanes) {
+	Plane a{7, 7}, b{7, 7};
+	EXPECT_EQ(
+	    FindSSIM()(a.Data.data(), a.Linesize, b.Data.data(), b.Linesize, 7, 7),
+	    1.0
+	);
+}
+
+} // namespace details
+} // namespace video
+} // namespace fort
@@ -0,0 +1,121 @@
+#include "Scale.hpp"
+
+#include <algorithm>
+#include <thread>
+
+extern "C" {
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+#include <libavutil/opt.h>
+}
+
+#include "AVCall.hpp"
+#include "AVTypes.hpp"
+
+namespace fort {
+namespace video {
+namespace details {
+
+int ScaleFlags(const ScaleOptions &options) noexcept {
+	int res = 0;
+	switch (options.Algorithm) {
+	case ScaleAlgorithm::Point:
+		res = SWS_POINT;
+		break;
+	case ScaleAlgorithm::FastBilinear:
+		res = SWS_FAST_BILINEAR;
+		break;
+	case ScaleAlgorithm::Bilinear:
+		res = SWS_BILINEAR;
+		break;
+	case ScaleAlgorithm::Area:
+		res = SWS_AREA;
+		break;
+	case ScaleAlgorithm::Bicubic:
+		res = SWS_BICUBIC;
+		break;
+	case ScaleAlgorithm::Gauss:
+		res = SWS_GAUSS;
+		break;
+	case ScaleAlgorithm::Spline:
+		res = SWS_SPLINE;
+		break;
+	case ScaleAlgorithm::Lanczos:
+		res = SWS_LANCZOS;
+		break;
+	}
+	if (options.AccurateRounding) {
+		res |= SWS_ACCURATE_RND;
+	}
+	if (options.FullChromaInterpolation) {
+		res |= SWS_FULL_CHR_H_INT;
+	}
+	if (options.FullChromaInput) {
+		res |= SWS_FULL_CHR_H_INP;
+	}
+	return res;
+}
+
+int ScaleThreads(const Resolution &from, const Resolution &to) noexcept {
+	constexpr static int64_t PIXELS_PER_THREAD = 2'000'000;
+
+	const int64_t pixels = std::max(
+	    int64_t(from.Width) * from.Height,
+	    int64_t(to.Width) * to.Height
+	);
+	const int64_t concurrency =
+	    std::max(1U, std::thread::hardware_concurrency());
+	return std::clamp(pixels / PIXELS_PER_THREAD, int64_t(1), concurrency);
+}
+
+#if FORT_VIDEO_HAS_SWS_THREADS
+// Wraps frame in an AVFrame pointing to its planes without owning them, as
+// sws_scale_frame() requires reference counted frames.
+static AVFramePtr wrap(const Frame &frame) {
+	AVFramePtr res{AVAlloc<AVFrame>(av_frame_alloc)};
+	res->width  = frame.Size.Width;
+	res->height = frame.Size.Height;
+	res->format = frame.Format;
+	for (int i = 0; i < 4; ++i) {
+		res->data[i]     = frame.Planes[i];
+		res->linesize[i] = frame.Linesize[i];
+	}
+	res->buf[0] = AVAlloc<AVBufferRef>(
+	    av_buffer_create,
+	    frame.Planes[0],
+	    size_t(frame.Linesize[0]) * frame.Size.Height,
+	    [](void *, uint8_t *) {},
+	    nullptr,
+	    0
+	);
+	return res;
+}
+#endif
+
+void Scale(SwsContext *ctx, const Frame &src, Frame &dst) {
+#if FORT_VIDEO_HAS_SWS_THREADS
+	int64_t threads = 1;
+	av_opt_get_int(ctx, "threads", 0, &threads);
+	if (threads > 1) {
+		auto wrappedSrc = wrap(src);
+		auto wrappedDst = wrap(dst);
+		AVCall(sws_scale_frame, ctx, wrappedDst.get(), wrappedSrc.get());
+		return;
+	}
+#endif
+	// the legacy API only uses the first slice context of threaded ones.
+	AVCall(
+	    sws_scale,
+	    ctx,
+	    src.Planes,
+	    src.Linesize,
+	    0,
+	    src.Size.Height,
+	    dst.Planes,
+	    dst.Linesize
+	);
+}
+
+} // namespace details
+} // namespace video
+} // namespace fort
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <fort/video/Frame.hpp>
+
+extern "C" {
+#include <libswscale/swscale.h>
+#include <libswscale/version.h>
+}
+
+// sws_scale_frame() and the slice threads appeared with FFmpeg 5.0.
+#define FORT_VIDEO_HAS_SWS_THREADS                                             \
+	(LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 4, 100))
+
+namespace fort {
+namespace video {
+namespace details {
+
+// Returns the swscale flags for options.
+int ScaleFlags(const ScaleOptions &options) noexcept;
+
+// Returns the number of slice threads worth using to convert from a frame
+// of size from to one of size to: 1 up to about 1080p, then one per two
+// megapixels up to the hardware concurrency.
+int ScaleThreads(const Resolution &from, const Resolution &to) noexcept;
+
+// Converts the whole src frame to dst with ctx. Contexts created with more
+// than one thread split the destination rows over their slice threads.
+void Scale(SwsContext *ctx, const Frame &src, Frame &dst);
+
+} // namespace details
+} // namespace video
+} // namespace fort
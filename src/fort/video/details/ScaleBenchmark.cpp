@@ -0,0 +1,174 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <tuple>
+
+#include <fort/video/Frame.hpp>
+#include <fort/video/details/Quality.hpp>
+#include <fort/video/details/Scale.hpp>
+#include <fort/video/details/ScaleContextCache.hpp>
+
+namespace fort {
+namespace video {
+namespace details {
+
+static void fillRandom(Frame &frame) {
+	std::mt19937                       rng{0};
+	std::uniform_int_distribution<int> dist{0, 255};
+	for (int y = 0; y < frame.Size.Height; ++y) {
+		for (int x = 0; x < frame.Linesize[0]; ++x) {
+			frame.Planes[0][y * frame.Linesize[0] + x] = dist(rng);
+		}
+	}
+}
+
+// Converts YUV420P frames, as decoded, to GRAY8 or RGB24 at the given size,
+// with a single thread or with ScaleThreads() slice threads.
+static void BM_Scale(benchmark::State &state) {
+	const bool       sliced = state.range(0) != 0;
+	const auto       format = PixelFormat(state.range(1));
+	const Resolution from{int(state.range(2)), int(state.range(3))};
+	const Resolution to{int(state.range(4)), int(state.range(5))};
+	const int        threads = sliced ? ScaleThreads(from, to) : 1;
+	state.SetLabel(std::to_string(threads) + " thread(s)");
+
+	Frame src{from, AV_PIX_FMT_YUV420P};
+	Frame dst{to, format};
+	fillRandom(src);
+	ScaleContextCache cache;
+	auto              ctx =
+	    cache.Get(from, AV_PIX_FMT_YUV420P, to, format, SWS_BILINEAR, threads);
+
+	for (auto _ : state) {
+		Scale(ctx.get(), src, dst);
+		benchmark::DoNotOptimize(dst.Planes[0]);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(
+	    int64_t(state.iterations()) * from.Width * from.Height * 3 / 2
+	);
+}
+
+static void conversions(benchmark::internal::Benchmark *b) {
+	for (int sliced : {0, 1}) {
+		for (auto format : {AV_PIX_FMT_GRAY8, AV_PIX_FMT_RGB24}) {
+			b->Args({sliced, format, 3840, 2160, 3840, 2160});
+			b->Args({sliced, format, 3840, 2160, 1920, 1080});
+			b->Args({sliced, format, 7680, 4320, 7680, 4320});
+			b->Args({sliced, format, 7680, 4320, 3840, 2160});
+		}
+	}
+}
+
+// Renders a band-limited pattern, which is exactly known at any size:
+// its frequencies stay below the Nyquist limit of 1920x1080.
+static void render(Frame &frame) {
+	constexpr static double TWO_PI = 2.0 * M_PI;
+	for (int y = 0; y < frame.Size.Height; ++y) {
+		const double v = (y + 0.5) / frame.Size.Height;
+		for (int x = 0; x < frame.Size.Width; ++x) {
+			const double u     = (x + 0.5) / frame.Size.Width;
+			const double value = 128.0 +
+			                     60.0 * std::sin(TWO_PI * 300.0 * u) *
+			                         std::cos(TWO_PI * 200.0 * v) +
+			                     40.0 * std::sin(TWO_PI * 100.0 * (u + v));
+			frame.Planes[0][y * frame.Linesize[0] + x] =
+			    uint8_t(std::lround(value));
+		}
+	}
+}
+
+static const char *name(ScaleAlgorithm algorithm) {
+	switch (algorithm) {
+	case ScaleAlgorithm::Point:
+		return "point";
+	case ScaleAlgorithm::FastBilinear:
+		return "fast_bilinear";
+	case ScaleAlgorithm::Bilinear:
+		return "bilinear";
+	case ScaleAlgorithm::Area:
+		return "area";
+	case ScaleAlgorithm::Bicubic:
+		return "bicubic";
+	case ScaleAlgorithm::Gauss:
+		return "gauss";
+	case ScaleAlgorithm::Spline:
+		return "spline";
+	case ScaleAlgorithm::Lanczos:
+		return "lanczos";
+	}
+	return "unknown";
+}
+
+// Speed and quality of each algorithm, when resizing GRAY8 frames. The
+// quality is measured against the pattern rendered at the target size.
+static void BM_ScaleAlgorithm(benchmark::State &state) {
+	const ScaleOptions options{
+	    .Algorithm        = ScaleAlgorithm(state.range(0)),
+	    .AccurateRounding = state.range(1) != 0,
+	};
+	const Resolution from{int(state.range(2)), int(state.range(3))};
+	const Resolution to{int(state.range(4)), int(state.range(5))};
+	state.SetLabel(
+	    std::string(name(options.Algorithm)) +
+	    (options.AccurateRounding ? "|accurate_rnd" : "")
+	);
+
+	Frame src{from, AV_PIX_FMT_GRAY8}, dst{to, AV_PIX_FMT_GRAY8};
+	Frame expected{to, AV_PIX_FMT_GRAY8};
+	render(src);
+	render(expected);
+	ScaleContextCache cache;
+	const int         flags = ScaleFlags(options);
+	auto ctx = cache.Get(from, AV_PIX_FMT_GRAY8, to, AV_PIX_FMT_GRAY8, flags);
+
+	for (auto _ : state) {
+		Scale(ctx.get(), src, dst);
+		benchmark::DoNotOptimize(dst.Planes[0]);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations());
+
+	const auto args = std::make_tuple(
+	    expected.Planes[0],
+	    expected.Linesize[0],
+	    dst.Planes[0],
+	    dst.Linesize[0],
+	    to.Width,
+	    to.Height
+	);
+	state.counters["psnr"] = PSNR(
+	    std::apply(FindSSD(), args),
+	    size_t(to.Width) * to.Height
+	);
+	state.counters["ssim"] = std::apply(FindSSIM(), args);
+}
+
+static void algorithms(benchmark::internal::Benchmark *b) {
+	for (int algorithm = int(ScaleAlgorithm::Point);
+	     algorithm <= int(ScaleAlgorithm::Lanczos);
+	     ++algorithm) {
+		for (int accurate : {0, 1}) {
+			// 4K downscaled to 1080p, and 1080p upscaled to 4K.
+			b->Args({algorithm, accurate, 3840, 2160, 1920, 1080});
+			b->Args({algorithm, accurate, 1920, 1080, 3840, 2160});
+		}
+	}
+}
+
+BENCHMARK(BM_ScaleAlgorithm)
+    ->Apply(algorithms)
+    ->ArgNames({"algorithm", "accurate", "w", "h", "dw", "dh"})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_Scale)
+    ->Apply(conversions)
+    ->ArgNames({"sliced", "format", "w", "h", "dw", "dh"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace details
+} // namespace video
+} // namespace fort
@@ -0,0 +1,170 @@
+#include "ScaleContextCache.hpp"
+#include "Scale.hpp"
+
+#include <algorithm>
+#include <cpptrace/cpptrace.hpp>
+
+extern "C" {
+#include <libavutil/opt.h>
+}
+
+#include <fort/video/TypesIO.hpp>
+
+namespace fort {
+namespace video {
+namespace details {
+
+static SwsContext *newContext(
+    int         width,
+    int         height,
+    PixelFormat format,
+    int         dstWidth,
+    int         dstHeight,
+    PixelFormat dstFormat,
+    int         flags,
+    int         threads
+) {
+#if FORT_VIDEO_HAS_SWS_THREADS
+	if (threads > 1) {
+		// the threads option is only settable before the initialization.
+		SwsContext *res = sws_alloc_context();
+		if (res == nullptr) {
+			return nullptr;
+		}
+		av_opt_set_int(res, "srcw", width, 0);
+		av_opt_set_int(res, "srch", height, 0);
+		av_opt_set_int(res, "src_format", format, 0);
+		av_opt_set_int(res, "dstw", dstWidth, 0);
+		av_opt_set_int(res, "dsth", dstHeight, 0);
+		av_opt_set_int(res, "dst_format", dstFormat, 0);
+		av_opt_set_int(res, "sws_flags", flags, 0);
+		av_opt_set_int(res, "threads", threads, 0);
+		if (sws_init_context(res, nullptr, nullptr) < 0) {
+			sws_freeContext(res);
+			return nullptr;
+		}
+		return res;
+	}
+#endif
+	return sws_getContext(
+	    width,
+	    height,
+	    format,
+	    dstWidth,
+	    dstHeight,
+	    dstFormat,
+	    flags,
+	    nullptr,
+	    nullptr,
+	    nullptr
+	);
+}
+
+ScaleContextCache::ScaleContextCache()
+    : d_counters{std::make_shared<Counters>()}
+    , d_pools{[this](
+                  int         width,
+                  int         height,
+                  PixelFormat format,
+                  int         dstWidth,
+                  int         dstHeight,
+                  PixelFormat dstFormat,
+                  int         flags,
+                  int         threads
+              ) {
+	    return newPool(
+	        width,
+	        height,
+	        format,
+	        dstWidth,
+	        dstHeight,
+	        dstFormat,
+	        flags,
+	        threads
+	    );
+    }} {}
+
+ScaleContextCache &ScaleContextCache::Default() {
+	static ScaleContextCache instance;
+	return instance;
+}
+
+ScaleContextCache::ContextPtr ScaleContextCache::Get(
+    const Resolution &from,
+    PixelFormat       fromFormat,
+    const Resolution &to,
+    PixelFormat       toFormat,
+    int               flags,
+    int               threads
+) {
+	// the pool is only looked up under the lock, a context creation does
+	// not block other configurations.
+	Pool::Ptr pool;
+	{
+		std::lock_guard lock{d_mutex};
+		pool = d_pools(
+		    from.Width,
+		    from.Height,
+		    fromFormat,
+		    to.Width,
+		    to.Height,
+		    toFormat,
+		    flags,
+		    std::max(threads, 1)
+		);
+	}
+	auto res = pool->Get();
+	++d_counters->Checkouts;
+	return res;
+}
+
+ScaleContextCache::Stats ScaleContextCache::GetStats() const noexcept {
+	// a concurrent Get() counts its creation before its checkout, the two
+	// loads may see the first and not the second.
+	const size_t checkouts = d_counters->Checkouts.load();
+	const size_t created   = d_counters->Created.load();
+	return {
+	    .Created = created,
+	    .Reused  = std::max(checkouts, created) - created,
+	};
+}
+
+ScaleContextCache::Pool::Ptr ScaleContextCache::newPool(
+    int         width,
+    int         height,
+    PixelFormat format,
+    int         dstWidth,
+    int         dstHeight,
+    PixelFormat dstFormat,
+    int         flags,
+    int         threads
+) {
+	auto create = [=, counters = d_counters]() {
+		auto res = newContext(
+		    width,
+		    height,
+		    format,
+		    dstWidth,
+		    dstHeight,
+		    dstFormat,
+		    flags,
+		    threads
+		);
+		if (res == nullptr) {
+			throw cpptrace::runtime_error{
+			    "could not create conversion from " +
+			    std::to_string(Resolution{width, height}) + " " +
+			    std::to_string(format) + " to " +
+			    std::to_string(Resolution{dstWidth, dstHeight}) + " " +
+			    std::to_string(dstFormat),
+			};
+		}
+		++counters->Created;
+		return res;
+	};
+	return Pool::Create(create, FreeSwsContext{});
+}
+
+} // namespace details
+} // namespace video
+} // namespace fort
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <fort/utils/LRUCache.hpp>
+#include <fort/utils/ObjectPool.hpp>
+#include <fort/video/Types.hpp>
+
+#include "AVTypes.hpp"
+
+namespace fort {
+namespace video {
+namespace details {
+
+// ScaleContextCache recycles swscale contexts across instances, since
+// sws_getContext() is costly compared to short clips. Contexts are pooled
+// per (source size and format, destination size and format, flags, slice
+// threads), and the last CAPACITY configurations are kept.
+//
+// A SwsContext is not reentrant: Get() checks out a context for exclusive
+// use, and it returns to its pool when released. It is thread-safe.
+class ScaleContextCache {
+public:
+	constexpr static size_t CAPACITY = 16;
+
+	using ContextPtr =
+	    std::unique_ptr<SwsContext, std::function<void(SwsContext *)>>;
+
+	struct Stats {
+		// contexts created with sws_getContext(), and checkouts served by
+		// a recycled one.
+		size_t Created = 0, Reused = 0;
+	};
+
+	ScaleContextCache();
+
+	// Process-wide cache, shared by Reader and Encoder.
+	static ScaleContextCache &Default();
+
+	// Contexts with more than one thread convert whole frames with slice
+	// threads through Scale(), see ScaleThreads(). Throws
+	// cpptrace::runtime_error if the conversion is not supported.
+	ContextPtr
+	Get(const Resolution &from,
+	    PixelFormat       fromFormat,
+	    const Resolution &to,
+	    PixelFormat       toFormat,
+	    int               flags,
+	    int               threads = 1);
+
+	Stats GetStats() const noexcept;
+
+private:
+	using Pool = utils::ObjectPool<
+	    SwsContext,
+	    std::function<SwsContext *()>,
+	    FreeSwsContext>;
+
+	using PoolFactory = std::function<Pool::Ptr(
+	    int width,
+	    int height,
+	    PixelFormat,
+	    int dstWidth,
+	    int dstHeight,
+	    PixelFormat,
+	    int flags,
+	    int threads
+	)>;
+
+	Pool::Ptr newPool(
+	    int         width,
+	    int         height,
+	    PixelFormat format,
+	    int         dstWidth,
+	    int         dstHeight,
+	    PixelFormat dstFormat,
+	    int         flags,
+	    int         threads
+	);
+
+	// counters are shared with the pools, which may outlive the cache.
+	struct Counters {
+		std::atomic<size_t> Created = 0, Checkouts = 0;
+	};
+
+	std::shared_ptr<Counters>              d_counters;
+	std::mutex                             d_mutex;
+	utils::LRUCache<CAPACITY, PoolFactory> d_pools;
+};
+
+} // namespace details
+} // namespace video
+} // namespace fort
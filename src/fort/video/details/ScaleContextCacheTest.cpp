@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <cpptrace/cpptrace.hpp>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <fort/video/details/ScaleContextCache.hpp>
+
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+namespace fort {
+namespace video {
+namespace details {
+
+class ScaleContextCacheTest : public ::testing::Test {
+protected:
+	ScaleContextCache::ContextPtr Get(const Resolution &to, int flags) {
+		return cache.Get(
+		    {64, 48},
+		    AV_PIX_FMT_RGB24,
+		    to,
+		    AV_PIX_FMT_YUV420P,
+		    flags
+		);
+	}
+
+	ScaleContextCache cache;
+};
+
+TEST_F(ScaleContextCacheTest, ReusesReleasedContexts) {
+	SwsContext *first = nullptr;
+	{
+		auto ctx = Get({64, 48}, SWS_BILINEAR);
+		ASSERT_NE(ctx, nullptr);
+		first = ctx.get();
+	}
+	auto ctx = Get({64, 48}, SWS_BILINEAR);
+	EXPECT_EQ(ctx.get(), first);
+	EXPECT_EQ(cache.GetStats().Created, 1);
+	EXPECT_EQ(cache.GetStats().Reused, 1);
+}
+
+TEST_F(ScaleContextCacheTest, ChecksOutDistinctContexts) {
+	auto a = Get({64, 48}, SWS_BILINEAR);
+	auto b = Get({64, 48}, SWS_BILINEAR);
+	EXPECT_NE(a.get(), b.get());
+
+	auto c = Get({32, 24}, SWS_BILINEAR);
+	auto d = Get({64, 48}, SWS_BICUBIC);
+	EXPECT_EQ(
+	    (std::set<SwsContext *>{a.get(), b.get(), c.get(), d.get()}).size(),
+	    4
+	);
+	EXPECT_EQ(cache.GetStats().Created, 4);
+	EXPECT_EQ(cache.GetStats().Reused, 0);
+}
+
+TEST_F(ScaleContextCacheTest, KeepsEvictedContextsAlive) {
+	auto ctx = Get({64, 48}, SWS_BILINEAR);
+	for (int i = 1; i <= int(ScaleContextCache::CAPACITY); ++i) {
+		Get({64 + 2 * i, 48}, SWS_BILINEAR);
+	}
+	// releases into the evicted pool, and a new one gets created.
+	ctx.reset();
+	ctx = Get({64, 48}, SWS_BILINEAR);
+	EXPECT_EQ(cache.GetStats().Created, ScaleContextCache::CAPACITY + 2);
+}
+
+TEST_F(ScaleContextCacheTest, IsThreadSafe) {
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 8; ++i) {
+		threads.emplace_back([this, i]() {
+			for (int j = 0; j < 100; ++j) {
+				auto ctx = Get({32 + 2 * ((i + j) % 4), 24}, SWS_BILINEAR);
+				ASSERT_NE(ctx, nullptr);
+			}
+		});
+	}
+	for (auto &t : threads) {
+		t.join();
+	}
+	const auto stats = cache.GetStats();
+	EXPECT_EQ(stats.Created + stats.Reused, 800);
+	EXPECT_LE(stats.Created, 4 * 8);
+}
+
+TEST_F(ScaleContextCacheTest, ThrowsOnUnsupportedConversion) {
+	EXPECT_THROW(Get({0, 0}, SWS_BILINEAR), cpptrace::runtime_error);
+}
+
+} // namespace details
+} // namespace video
+} // namespace fort
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <thread>
+
+#include <fort/video/Frame.hpp>
+#include <fort/video/details/Scale.hpp>
+#include <fort/video/details/ScaleContextCache.hpp>
+
+namespace fort {
+namespace video {
+namespace details {
+
+TEST(ScaleTest, MapsOptionsToFlags) {
+	EXPECT_EQ(ScaleFlags({}), SWS_BILINEAR);
+	EXPECT_EQ(ScaleFlags({.Algorithm = ScaleAlgorithm::Point}), SWS_POINT);
+	EXPECT_EQ(ScaleFlags({.Algorithm = ScaleAlgorithm::Area}), SWS_AREA);
+	EXPECT_EQ(
+	    ScaleFlags({
+	        .Algorithm               = ScaleAlgorithm::Lanczos,
+	        .AccurateRounding        = true,
+	        .FullChromaInterpolation = true,
+	        .FullChromaInput         = true,
+	    }),
+	    SWS_LANCZOS | SWS_ACCURATE_RND | SWS_FULL_CHR_H_INT | SWS_FULL_CHR_H_INP
+	);
+}
+
+TEST(ScaleTest, ThreadsOnlyLargeFrames) {
+	const int concurrency = std::max(1U, std::thread::hardware_concurrency());
+	EXPECT_EQ(ScaleThreads({640, 480}, {640, 480}), 1);
+	EXPECT_EQ(ScaleThreads({1920, 1080}, {1920, 1080}), 1);
+	EXPECT_EQ(ScaleThreads({3840, 2160}, {960, 540}), std::min(4, concurrency));
+	EXPECT_EQ(ScaleThreads({960, 540}, {3840, 2160}), std::min(4, concurrency));
+	EXPECT_EQ(
+	    ScaleThreads({7680, 4320}, {3840, 2160}),
+	    std::min(16, concurrency)
+	);
+}
+
+TEST(ScaleTest, SlicedConversionMatchesSingleThreaded) {
+	const Resolution from{3840, 2160}, to{1920, 1080};
+
+	Frame                              src{from, AV_PIX_FMT_RGB24};
+	std::mt19937                       rng{42};
+	std::uniform_int_distribution<int> dist{0, 255};
+	for (int y = 0; y < from.Height; ++y) {
+		for (int x = 0; x < 3 * from.Width; ++x) {
+			src.Planes[0][y * src.Linesize[0] + x] = dist(rng);
+		}
+	}
+
+	ScaleContextCache cache;
+	auto single = cache.Get(
+	    from,
+	    AV_PIX_FMT_RGB24,
+	    to,
+	    AV_PIX_FMT_YUV420P,
+	    SWS_BILINEAR | SWS_BITEXACT,
+	    1
+	);
+	auto sliced = cache.Get(
+	    from,
+	    AV_PIX_FMT_RGB24,
+	    to,
+	    AV_PIX_FMT_YUV420P,
+	    SWS_BILINEAR | SWS_BITEXACT,
+	    4
+	);
+
+	Frame expected{to, AV_PIX_FMT_YUV420P}, result{to, AV_PIX_FMT_YUV420P};
+	Scale(single.get(), src, expected);
+	Scale(sliced.get(), src, result);
+
+	for (int plane = 0; plane < 3; ++plane) {
+		const int width  = plane == 0 ? to.Width : to.Width / 2;
+		const int height = plane == 0 ? to.Height : to.Height / 2;
+		for (int y = 0; y < height; ++y) {
+			ASSERT_EQ(
+			    0,
+			    memcmp(
+			        expected.Planes[plane] + y * expected.Linesize[plane],
+			        result.Planes[plane] + y * result.Linesize[plane],
+			        width
+			    )
+			) << "plane: " << plane << " row: " << y;
+		}
+	}
+}
+
+} // namespace details
+} // namespace video
+} // namespace fort